@@ -26,6 +26,7 @@
 #define PWM_PIN1 (PWM_PIN0+1)
 
 #include "audio.h"
+#include <hardware/irq.h>
 
 #ifdef AUDIO_PWM_PIN
 #include "hardware/pwm.h"
@@ -58,7 +59,8 @@ i2s_config_t i2s_get_default_config(void) {
  */
 
 
-void i2s_init(i2s_config_t *i2s_config) {
+// The PIO program and the DMA channel, its source left to the caller
+static void i2s_setup(i2s_config_t *i2s_config) {
 
 
 #ifndef AUDIO_PWM_PIN
@@ -88,9 +90,6 @@ void i2s_init(i2s_config_t *i2s_config) {
 
     pio_sm_set_enabled(i2s_config->pio, i2s_config->sm, false);
 #endif
-    /* Allocate memory for the DMA buffer */
-    i2s_config->dma_buf=malloc(i2s_config->dma_trans_count*sizeof(uint32_t));
-
     /* Direct Memory Access setup */
     i2s_config->dma_channel = dma_claim_unused_channel(true);
     
@@ -136,6 +135,12 @@ void i2s_init(i2s_config_t *i2s_config) {
     pio_sm_set_enabled(i2s_config->pio, i2s_config->sm , true);
 }
 
+void i2s_init(i2s_config_t *i2s_config) {
+    /* Allocate memory for the DMA buffer */
+    i2s_config->dma_buf=malloc(i2s_config->dma_trans_count*sizeof(uint32_t));
+    i2s_setup(i2s_config);
+}
+
 /**
  * Write samples to I2S directly and wait for completion (blocking)
  * i2s_config: I2S context obtained by i2s_get_default_config()
@@ -211,3 +216,39 @@ void i2s_decrease_volume(i2s_config_t *i2s_config) {
         i2s_config->volume++;
     }
 }
+
+/* DMA block ring */
+
+#define AUDIO_RING_IRQ DMA_IRQ_1
+
+static audio_ring_t i2s_ring;
+static uint8_t i2s_ring_channel;
+
+static void __not_in_flash_func(i2s_ring_irq_handler)(void) {
+    dma_hw->ints1 = 1u << i2s_ring_channel;
+    dma_channel_transfer_from_buffer_now(i2s_ring_channel, audio_ring_next(&i2s_ring), i2s_ring.frames);
+}
+
+/**
+ * Set up I2S output fed from a ring of BLOCKS DMA blocks of
+ * i2s_config->dma_trans_count frames each, and start sending silence.
+ * LATENCY is the number of blocks queued before playback starts.
+ * Returns the ring to write to, NULL if it cannot be allocated.
+ */
+audio_ring_t *i2s_ring_init(i2s_config_t *i2s_config, uint16_t blocks, uint16_t latency) {
+    // the ring's blocks are the DMA source, i2s_config->dma_buf stays unused
+    i2s_setup(i2s_config);
+
+    i2s_ring.format = AUDIO_RING_I2S;
+    i2s_ring.channels = i2s_config->channel_count;
+    i2s_ring.volume = i2s_config->volume;
+    if (!audio_ring_init(&i2s_ring, blocks, i2s_config->dma_trans_count, latency))
+        return NULL;
+    i2s_ring_channel = i2s_config->dma_channel;
+
+    dma_channel_set_irq1_enabled(i2s_ring_channel, true);
+    irq_set_exclusive_handler(AUDIO_RING_IRQ, i2s_ring_irq_handler);
+    irq_set_enabled(AUDIO_RING_IRQ, true);
+    dma_channel_transfer_from_buffer_now(i2s_ring_channel, i2s_ring.silence, i2s_ring.frames);
+    return &i2s_ring;
+}
@@ -33,6 +33,7 @@ extern "C" {
 #include <hardware/clocks.h>
 #include <hardware/dma.h>
 #include "audio_i2s.pio.h"
+#include "audio_ring.h"
 
 typedef struct i2s_config 
 {
@@ -57,6 +58,9 @@ void i2s_volume(i2s_config_t *i2s_config,uint8_t volume);
 void i2s_increase_volume(i2s_config_t *i2s_config);
 void i2s_decrease_volume(i2s_config_t *i2s_config);
 
+/* I2S fed from a ring of DMA blocks (audio_ring.h) of dma_trans_count frames */
+audio_ring_t *i2s_ring_init(i2s_config_t *i2s_config, uint16_t blocks, uint16_t latency);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,113 @@
+#include <stdlib.h>
+
+#include "audio_ring.h"
+
+/* audio_ring_next runs in the DMA interrupt */
+#ifdef PICO_ON_DEVICE
+#include <pico/platform.h>
+#define RING_FUNC(f) __not_in_flash_func(f)
+#else
+#define RING_FUNC(f) f
+#endif
+
+bool audio_ring_init(audio_ring_t *ring, uint16_t count, uint16_t frames, uint16_t latency) {
+    ring->count = count;
+    ring->frames = frames;
+    ring->blocks = malloc((size_t)count * frames * sizeof(uint32_t));
+    ring->silence = malloc(frames * sizeof(uint32_t));
+    if (!ring->blocks || !ring->silence)
+        return false;
+    for (uint16_t i = 0; i < frames; i++)
+        ring->silence[i] = audio_ring_word(ring, 0);
+    ring->written = ring->played = 0;
+    ring->write_pos = 0;
+    ring->running = false;
+    ring->underruns = ring->overruns = 0;
+    audio_ring_set_latency(ring, latency);
+    return true;
+}
+
+/**
+ * Queue COUNT mono samples, or COUNT left/right pairs if the ring has two
+ * channels, unsigned 8-bit if SAMPLE_SIZE is 1 or signed 16-bit if it is 2,
+ * as they come from POKEYSND_Process.
+ * Returns the number of samples (pairs) queued.
+ */
+size_t audio_ring_write(audio_ring_t *ring, const void *samples, size_t count, int sample_size) {
+    const uint8_t *s8 = samples;
+    const int16_t *s16 = samples;
+    size_t done = 0;
+
+    while (done < count) {
+        if (ring->write_pos == 0 && ring->written - ring->played >= ring->count) {
+            ring->overruns += count - done;
+            break;
+        }
+        uint32_t *block = ring->blocks + (ring->written % ring->count) * ring->frames;
+        size_t n = ring->frames - ring->write_pos;
+        if (n > count - done)
+            n = count - done;
+        if (ring->channels == 2) {
+            for (size_t i = 0; i < n; i++) {
+                const size_t k = (done + i) * 2;
+                block[ring->write_pos + i] = sample_size == 2
+                    ? audio_ring_pair(ring, s16[k], s16[k + 1])
+                    : audio_ring_pair(ring, (int16_t)((s8[k] - 128) << 8), (int16_t)((s8[k + 1] - 128) << 8));
+            }
+        } else if (sample_size == 2) {
+            for (size_t i = 0; i < n; i++)
+                block[ring->write_pos + i] = audio_ring_word(ring, s16[done + i]);
+        } else {
+            for (size_t i = 0; i < n; i++)
+                block[ring->write_pos + i] = audio_ring_word(ring, (int16_t)((s8[done + i] - 128) << 8));
+        }
+        ring->write_pos += n;
+        done += n;
+        if (ring->write_pos == ring->frames) {
+            ring->write_pos = 0;
+            // publish the block only after its samples are stored
+            __sync_synchronize();
+            ring->written++;
+        }
+    }
+    return done;
+}
+
+/**
+ * The block to send after the one the DMA has just finished
+ */
+const uint32_t *RING_FUNC(audio_ring_next)(audio_ring_t *ring) {
+    if (ring->running) {
+        // the block just sent is free again
+        ring->played++;
+    }
+    uint32_t queued = ring->written - ring->played;
+    if (!ring->running && queued >= ring->latency) {
+        ring->running = true;
+    } else if (ring->running && queued == 0) {
+        ring->running = false;
+        ring->underruns++;
+    }
+    if (!ring->running)
+        return ring->silence;
+    return ring->blocks + (ring->played % ring->count) * ring->frames;
+}
+
+/**
+ * Set the number of blocks queued before playback starts, 1 .. count - 1
+ */
+void audio_ring_set_latency(audio_ring_t *ring, uint16_t latency) {
+    if (latency >= ring->count)
+        latency = ring->count - 1;
+    if (latency < 1)
+        latency = 1;
+    ring->latency = latency;
+}
+
+void audio_ring_get_stats(const audio_ring_t *ring, audio_ring_stats_t *stats) {
+    stats->blocks = ring->played;
+    stats->underruns = ring->underruns;
+    stats->overruns = ring->overruns;
+    stats->queued = ring->written - ring->played;
+    stats->latency = ring->latency;
+}
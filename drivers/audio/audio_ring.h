@@ -0,0 +1,81 @@
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Ring of DMA blocks shared by the I2S and PWM sinks.
+ *
+ * Every block is FRAMES words, one word per sample in the format of the
+ * sink, or per left/right pair of samples when CHANNELS is 2.  The writer fills blocks in turn with audio_ring_write, which never
+ * waits: what does not fit is dropped and counted as an overrun.  Each time
+ * the DMA has sent a block, its interrupt asks audio_ring_next for the next
+ * one.  Playback starts once LATENCY blocks are queued, and again after an
+ * underrun; until then the sink gets silence.
+ *
+ * The writer and the interrupt each own one counter (written, played), so
+ * they need no lock between them.  Plain C, so that the host can run it.
+ */
+
+#define AUDIO_RING_I2S 0    // signed 16 bits, left in the low half of the word
+#define AUDIO_RING_PWM 1    // duty 0 .. top, left on the first pin of the slice
+
+typedef struct audio_ring_stats {
+    uint32_t blocks;        // blocks played
+    uint32_t underruns;     // blocks the DMA found the ring empty for
+    uint32_t overruns;      // samples dropped because the ring was full
+    uint16_t queued;        // blocks waiting now, the one playing included
+    uint16_t latency;       // blocks queued before playback starts
+} audio_ring_stats_t;
+
+typedef struct audio_ring {
+    uint8_t format;
+    uint8_t channels;       // 2: the samples written are left/right pairs, else mono
+    uint8_t volume;         // right shift, 0 (loudest) .. 16
+    uint16_t top;           // AUDIO_RING_PWM: the counter wrap
+    uint16_t frames;        // words per block
+    uint16_t count;         // blocks
+    volatile uint16_t latency;
+    uint32_t *blocks;
+    uint32_t *silence;
+    volatile uint32_t written;  // by the writer only
+    volatile uint32_t played;   // by the interrupt only
+    uint16_t write_pos;         // words of the block being filled
+    volatile bool running;
+    volatile uint32_t underruns;
+    uint32_t overruns;
+} audio_ring_t;
+
+/* Allocates COUNT blocks of FRAMES words; FALSE if out of memory. FORMAT,
+   CHANNELS, VOLUME and TOP are to be set before. */
+bool audio_ring_init(audio_ring_t *ring, uint16_t count, uint16_t frames, uint16_t latency);
+size_t audio_ring_write(audio_ring_t *ring, const void *samples, size_t count, int sample_size);
+const uint32_t *audio_ring_next(audio_ring_t *ring);
+void audio_ring_set_latency(audio_ring_t *ring, uint16_t latency);
+void audio_ring_get_stats(const audio_ring_t *ring, audio_ring_stats_t *stats);
+
+/* A signed 16-bit sample in the format of half a word of the ring */
+static inline uint32_t audio_ring_half(const audio_ring_t *ring, int16_t sample) {
+    int32_t v = sample >> ring->volume;
+    if (ring->format == AUDIO_RING_PWM)
+        return (uint32_t)((v + 32768) * (ring->top + 1)) >> 16;
+    return (uint16_t)v;
+}
+
+/* A signed 16-bit sample in the word format of the ring, on both channels */
+static inline uint32_t audio_ring_word(const audio_ring_t *ring, int16_t sample) {
+    const uint32_t half = audio_ring_half(ring, sample);
+    return half << 16 | half;
+}
+
+/* A left/right pair of signed 16-bit samples in the word format of the ring */
+static inline uint32_t audio_ring_pair(const audio_ring_t *ring, int16_t left, int16_t right) {
+    return audio_ring_half(ring, right) << 16 | audio_ring_half(ring, left);
+}
+
+#ifdef __cplusplus
+}
+#endif
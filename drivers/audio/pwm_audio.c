@@ -0,0 +1,76 @@
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/pwm.h>
+
+#include "pwm_audio.h"
+
+#define PWM_AUDIO_IRQ DMA_IRQ_1
+
+static audio_ring_t pwm_ring;
+static int pwm_channel;
+
+static void __not_in_flash_func(pwm_audio_irq_handler)(void) {
+    dma_hw->ints1 = 1u << pwm_channel;
+    dma_channel_transfer_from_buffer_now(pwm_channel, audio_ring_next(&pwm_ring), pwm_ring.frames);
+}
+
+// clk_sys * num / den closest to FREQ, both 16 bits
+static void pwm_audio_pace(uint32_t freq, uint16_t *num, uint16_t *den) {
+    const uint32_t clk = clock_get_hz(clk_sys);
+    uint32_t best_error = UINT32_MAX;
+    *num = 1;
+    *den = 0xffff;
+    for (uint32_t n = 1; n <= 0xffff; n++) {
+        const uint64_t d = ((uint64_t)clk * n + freq / 2) / freq;
+        if (d > 0xffff)
+            break;
+        const uint64_t rate = (uint64_t)clk * n / d;
+        const uint32_t error = rate > freq ? rate - freq : freq - rate;
+        if (error < best_error) {
+            best_error = error;
+            *num = n;
+            *den = d;
+        }
+    }
+}
+
+audio_ring_t *pwm_audio_init(uint8_t pin, uint32_t sample_freq, uint8_t channels, uint16_t frames, uint16_t blocks, uint16_t latency) {
+    pwm_ring.format = AUDIO_RING_PWM;
+    pwm_ring.channels = channels;
+    pwm_ring.volume = 0;
+    pwm_ring.top = (1 << PWM_AUDIO_BITS) - 1;
+    if (!audio_ring_init(&pwm_ring, blocks, frames, latency))
+        return NULL;
+
+    // both pins of the slice
+    const uint8_t pin0 = pin & 0xfe;
+    gpio_set_function(pin0, GPIO_FUNC_PWM);
+    gpio_set_function(pin0 + 1, GPIO_FUNC_PWM);
+    const uint slice = pwm_gpio_to_slice_num(pin0);
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, 1);
+    pwm_config_set_wrap(&config, pwm_ring.top);
+    pwm_init(slice, &config, false);
+    pwm_set_both_levels(slice, (pwm_ring.top + 1) / 2, (pwm_ring.top + 1) / 2);
+    pwm_set_enabled(slice, true);
+
+    uint16_t num, den;
+    const int timer = dma_claim_unused_timer(true);
+    pwm_audio_pace(sample_freq, &num, &den);
+    dma_timer_set_fraction(timer, num, den);
+
+    pwm_channel = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(pwm_channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, dma_get_timer_dreq(timer));
+    dma_channel_configure(pwm_channel, &c, &pwm_hw->slice[slice].cc, pwm_ring.silence, frames, false);
+
+    dma_channel_set_irq1_enabled(pwm_channel, true);
+    irq_set_exclusive_handler(PWM_AUDIO_IRQ, pwm_audio_irq_handler);
+    irq_set_enabled(PWM_AUDIO_IRQ, true);
+    dma_channel_start(pwm_channel);
+    return &pwm_ring;
+}
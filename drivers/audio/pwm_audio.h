@@ -0,0 +1,28 @@
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "audio_ring.h"
+
+/* PWM sound for boards without an I2S DAC.  Both channels of the slice of
+ * PIN carry the same signal, or left and right in stereo, at a carrier of
+ * clk_sys / 2^PWM_AUDIO_BITS.
+ * A DMA timer paced at the sample rate writes one duty word per sample from
+ * the ring, and the PWM holds it until the next: the upsampling to the
+ * carrier costs no CPU.
+ */
+
+#ifndef PWM_AUDIO_BITS
+#define PWM_AUDIO_BITS 10
+#endif
+
+/* Ring of BLOCKS blocks of FRAMES samples at SAMPLE_FREQ, mono or, with 2
+   CHANNELS, left on the first pin and right on the second; NULL if it
+   cannot be allocated. */
+audio_ring_t *pwm_audio_init(uint8_t pin, uint32_t sample_freq, uint8_t channels, uint16_t frames, uint16_t blocks, uint16_t latency);
+
+#ifdef __cplusplus
+}
+#endif
@@ -51,6 +51,12 @@ void graphics_set_buffer(uint8_t* buffer, uint16_t width, uint16_t height);
 
 void graphics_set_offset(int x, int y);
 
+// Streamed picture: in the 8-bit graphics mode line y of the buffer comes
+// from get_line(y) instead of the graphics buffer, which may be NULL. A NULL
+// line keeps what the line buffer held; frame_end() is called after the last
+// visible line. Pass NULL to read the graphics buffer again.
+void graphics_set_line_source(const uint8_t* (*get_line)(int y), void (*frame_end)(void));
+
 void graphics_set_palette(uint8_t i, uint32_t color);
 
 void graphics_set_textbuffer(uint8_t* buffer);
@@ -21,8 +21,8 @@ static int SM_conv = -1;
 //активный видеорежим
 static enum graphics_mode_t graphics_mode = GRAPHICSMODE_DEFAULT;
 
-//буфер  палитры 256 цветов в формате R8G8B8
-static uint32_t palette[256];
+//буфер  палитры в формате R8G8B8: 256 цветов пользователя и служебные
+static uint32_t palette[HDMI_CONV_COLORS];
 
 
 #define SCREEN_WIDTH (320)
@@ -33,6 +33,8 @@ static int graphics_buffer_width = 0;
 static int graphics_buffer_height = 0;
 static int graphics_buffer_shift_x = 0;
 static int graphics_buffer_shift_y = 0;
+static const uint8_t* (*line_source)(int y) = NULL;
+static void (*line_source_frame_end)(void) = NULL;
 
 //текстовый буфер
 uint8_t* text_buffer = NULL;
@@ -47,14 +49,15 @@ static int dma_chan_pal_conv_ctrl;
 static int dma_chan_pal_conv;
 
 //DMA буферы
-//основные строчные данные
-static uint32_t* __scratch_y("hdmi_ptr_3") dma_lines[2] = { NULL,NULL };
-static uint32_t* __scratch_y("hdmi_ptr_4") DMA_BUF_ADDR[2];
+//основные строчные данные: 16-битные индексы в conv_color, 400 на строку
+static uint16_t* __scratch_y("hdmi_ptr_3") dma_lines[2] = { NULL,NULL };
+static uint16_t* __scratch_y("hdmi_ptr_4") DMA_BUF_ADDR[2];
+
+//ДМА палитра для конвертации: 4 слова TMDS на индекс, PIO берёт 9 бит
+//индекса, поэтому выравнивание 8 КБ. В хвосте выделяются строки DMA
+static alignas(8192)
+uint32_t conv_color[HDMI_CONV_COLORS * 4 + 2 * 200];
 
-//ДМА палитра для конвертации
-//в хвосте этой памяти выделяется dma_data
-static alignas(4096)
-uint32_t conv_color[1224];
 
 
 //индекс, проверяющий зависание
@@ -62,14 +65,16 @@ static uint32_t irq_inx = 0;
 
 //функции и константы HDMI
 
-#define BASE_HDMI_CTRL_INX (240)
+//служебные индексы за 256 цветами пользователя: фон, синхра, текст
+#define HDMI_BG_INX (256)
+#define BASE_HDMI_CTRL_INX (257)
 //программа конвертации адреса
 
 uint16_t pio_program_instructions_conv_HDMI[] = {
     //         //     .wrap_target
     0x80a0, //  0: pull   block
-    0x40e8, //  1: in     osr, 8
-    0x4034, //  2: in     x, 20
+    0x40e9, //  1: in     osr, 9
+    0x4033, //  2: in     x, 19
     0x8020, //  3: push   block
     //     .wrap
 };
@@ -152,6 +157,36 @@ static uint tmds_encoder(const uint8_t d8) {
     return d_out;
 }
 
+//TMDS символы индекса: пиксель и его инверсия для второй половины
+static void set_conv_color(const int i, const uint32_t color888) {
+    uint64_t* conv_color64 = (uint64_t *)conv_color;
+    const uint8_t R = (color888 >> 16) & 0xff;
+    const uint8_t G = (color888 >> 8) & 0xff;
+    const uint8_t B = (color888 >> 0) & 0xff;
+    palette[i] = color888 & 0x00ffffff;
+    conv_color64[i * 2] = get_ser_diff_data(tmds_encoder(R), tmds_encoder(G), tmds_encoder(B));
+    conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ 0x0003ffffffffffffl;
+}
+
+static void __scratch_y("hdmi_driver") fill_line(uint16_t* out, const uint16_t inx, int count) {
+    while (count-- > 0) *out++ = inx;
+}
+
+//8-битные пиксели в 16-битные индексы, по 4 пикселя за чтение слова
+static void __scratch_y("hdmi_driver") widen_line(uint16_t* out, const uint8_t* in, int count) {
+    if ((((uintptr_t)in | (uintptr_t)out) & 3) == 0) {
+        uint32_t* out32 = (uint32_t *)out;
+        for (; count >= 4; count -= 4) {
+            const uint32_t p = *(const uint32_t *)in;
+            in += 4;
+            *out32++ = (p & 0xff) | (p << 8 & 0xff0000);
+            *out32++ = (p >> 16 & 0xff) | (p >> 8 & 0xff0000);
+        }
+        out = (uint16_t *)out32;
+    }
+    while (count-- > 0) *out++ = *in++;
+}
+
 static void pio_set_x(PIO pio, const int sm, uint32_t v) {
     uint instr_shift = pio_encode_in(pio_x, 4);
     uint instr_mov = pio_encode_mov(pio_x, pio_isr);
@@ -179,12 +214,12 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
     inx_buf_dma++;
 
 
-    uint8_t* activ_buf = (uint8_t *)dma_lines[inx_buf_dma & 1];
+    uint16_t* activ_buf = dma_lines[inx_buf_dma & 1];
 
     if (line < 480) {
         //область изображения
         uint8_t* input_buffer = &graphics_buffer[(line / 2) * graphics_buffer_width];
-        uint8_t* output_buffer = activ_buf + 72; //для выравнивания синхры;
+        uint16_t* output_buffer = activ_buf + 72; //для выравнивания синхры;
         int y = line / 2;
         switch (graphics_mode) {
             case GRAPHICSMODE_DEFAULT:
@@ -193,38 +228,43 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
                 if (false || (graphics_buffer_shift_y > y) || (y >= (graphics_buffer_shift_y + graphics_buffer_height))
                     || (graphics_buffer_shift_x >= SCREEN_WIDTH) || (
                         (graphics_buffer_shift_x + graphics_buffer_width) < 0)) {
-                    memset(output_buffer, 255,SCREEN_WIDTH);
+                    fill_line(output_buffer, HDMI_BG_INX, SCREEN_WIDTH);
                     break;
                 }
 
-                uint8_t* activ_buf_end = output_buffer + SCREEN_WIDTH;
+                uint16_t* activ_buf_end = output_buffer + SCREEN_WIDTH;
             //рисуем пространство слева от буфера
                 for (int i = graphics_buffer_shift_x; i-- > 0;) {
-                    *output_buffer++ = 255;
+                    *output_buffer++ = HDMI_BG_INX;
                 }
 
             //рисуем сам видеобуфер+пространство справа
-                input_buffer = &graphics_buffer[(y - graphics_buffer_shift_y) * graphics_buffer_width];
+                if (line_source) {
+                    input_buffer = (uint8_t *)line_source(y - graphics_buffer_shift_y);
+                    // the beam overtook the emulation: keep the old line
+                    if (!input_buffer) break;
+                }
+                else
+                    input_buffer = &graphics_buffer[(y - graphics_buffer_shift_y) * graphics_buffer_width];
 
                 const uint8_t* input_buffer_end = input_buffer + graphics_buffer_width;
 
                 if (graphics_buffer_shift_x < 0) input_buffer -= graphics_buffer_shift_x;
 
-                while (activ_buf_end > output_buffer) {
-                    if (input_buffer < input_buffer_end) {
-                        uint8_t i_color = *input_buffer++;
-                        i_color = ((i_color & 0xf0) == 0xf0) ? 255 : i_color;
-                        *output_buffer++ = i_color;
-                    }
-                    else
-                        *output_buffer++ = 255;
+                //все 256 цветов без замен, затем фон справа
+                int count = input_buffer_end - input_buffer;
+                if (count > activ_buf_end - output_buffer) count = activ_buf_end - output_buffer;
+                if (count > 0) {
+                    widen_line(output_buffer, input_buffer, count);
+                    output_buffer += count;
                 }
+                fill_line(output_buffer, HDMI_BG_INX, activ_buf_end - output_buffer);
 
                 break;
 
             case TEXTMODE_DEFAULT:
             case TEXTMODE_53x30: {
-                *output_buffer++ = 255;
+                *output_buffer++ = HDMI_BG_INX;
 
                 for (int x = 0; x < TEXTMODE_COLS; x++) {
                     const uint16_t offset = (y / 8) * (TEXTMODE_COLS * 2) + x * 2;
@@ -240,15 +280,11 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
                         glyph_row >>= 1;
                     }
                 }
-                *output_buffer = 255;
+                *output_buffer = HDMI_BG_INX;
                 break;
             }
             default:
-                for (int i = SCREEN_WIDTH; i--;) {
-                    uint8_t i_color = *input_buffer++;
-                    i_color = (i_color & 0xf0) == 0xf0 ? 255 : i_color;
-                    *output_buffer++ = i_color;
-                }
+                widen_line(output_buffer, input_buffer, SCREEN_WIDTH);
                 break;
         }
 
@@ -260,9 +296,9 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
 
         // --|_|---|_|---|_|----
         //---|___________|-----
-        memset(activ_buf + 48,BASE_HDMI_CTRL_INX, 24);
-        memset(activ_buf,BASE_HDMI_CTRL_INX + 1, 48);
-        memset(activ_buf + 392,BASE_HDMI_CTRL_INX, 8);
+        fill_line(activ_buf + 48,BASE_HDMI_CTRL_INX, 24);
+        fill_line(activ_buf,BASE_HDMI_CTRL_INX + 1, 48);
+        fill_line(activ_buf + 392,BASE_HDMI_CTRL_INX, 8);
 
         //без выравнивания
         // --|_|---|_|---|_|----
@@ -272,13 +308,14 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
         //   memset(activ_buf+376,BASE_HDMI_CTRL_INX,24);
     }
     else {
+        if (line == 481 && line_source_frame_end) line_source_frame_end();
         if ((line >= 490) && (line < 492)) {
             //кадровый синхроимпульс
             //для выравнивания синхры
             // --|_|---|_|---|_|----
             //---|___________|-----
-            memset(activ_buf + 48,BASE_HDMI_CTRL_INX + 2, 352);
-            memset(activ_buf,BASE_HDMI_CTRL_INX + 3, 48);
+            fill_line(activ_buf + 48,BASE_HDMI_CTRL_INX + 2, 352);
+            fill_line(activ_buf,BASE_HDMI_CTRL_INX + 3, 48);
             //без выравнивания
             // --|_|---|_|---|_|----
             //-------|___________|----
@@ -291,8 +328,8 @@ static void __scratch_y("hdmi_driver") dma_handler_HDMI() {
             //ССИ без изображения
             //для выравнивания синхры
 
-            memset(activ_buf + 48,BASE_HDMI_CTRL_INX, 352);
-            memset(activ_buf,BASE_HDMI_CTRL_INX + 1, 48);
+            fill_line(activ_buf + 48,BASE_HDMI_CTRL_INX, 352);
+            fill_line(activ_buf,BASE_HDMI_CTRL_INX + 1, 48);
 
             // memset(activ_buf,BASE_HDMI_CTRL_INX,328);
             // memset(activ_buf+328,BASE_HDMI_CTRL_INX+1,48);
@@ -351,16 +388,13 @@ static inline bool hdmi_init() {
 
     offs_prg1 = pio_add_program(PIO_VIDEO_ADDR, &pio_program_conv_addr_HDMI);
     offs_prg0 = pio_add_program(PIO_VIDEO, &program_PIO_HDMI);
-    pio_set_x(PIO_VIDEO_ADDR, SM_conv, ((uint32_t)conv_color >> 12));
-
-    //заполнение палитры
-    for (int ci = 0; ci < 240; ci++) graphics_set_palette(ci, palette[ci]); //
-
-    //255 - цвет фона
-    graphics_set_palette(255, palette[255]);
+    pio_set_x(PIO_VIDEO_ADDR, SM_conv, ((uint32_t)conv_color >> 13));
 
+    //заполнение палитры: 256 цветов, фон и текст
+    for (int ci = 0; ci < HDMI_CONV_COLORS; ci++)
+        if (ci < BASE_HDMI_CTRL_INX || ci >= BASE_HDMI_TEXT_INX) set_conv_color(ci, palette[ci]);
 
-    //240-243 служебные данные(синхра) напрямую вносим в массив -конвертер
+    //257-260 служебные данные(синхра) напрямую вносим в массив -конвертер
     uint64_t* conv_color64 = (uint64_t *)conv_color;
     const uint16_t b0 = 0b1101010100;
     const uint16_t b1 = 0b0010101011;
@@ -425,12 +459,12 @@ static inline bool hdmi_init() {
     pio_sm_set_enabled(PIO_VIDEO, SM_video, true);
 
     //настройки DMA
-    dma_lines[0] = &conv_color[1024];
-    dma_lines[1] = &conv_color[1124];
+    dma_lines[0] = (uint16_t *)&conv_color[HDMI_CONV_COLORS * 4];
+    dma_lines[1] = (uint16_t *)&conv_color[HDMI_CONV_COLORS * 4 + 200];
 
     //основной рабочий канал
     dma_channel_config cfg_dma = dma_channel_get_default_config(dma_chan);
-    channel_config_set_transfer_data_size(&cfg_dma, DMA_SIZE_8);
+    channel_config_set_transfer_data_size(&cfg_dma, DMA_SIZE_16);
     channel_config_set_chain_to(&cfg_dma, dma_chan_ctrl); // chain to other channel
 
     channel_config_set_read_increment(&cfg_dma, true);
@@ -539,18 +573,9 @@ void graphics_set_mode(enum graphics_mode_t mode) {
     clrScr(0);
 };
 
+//все 256 индексов - цвета пользователя, служебные лежат выше
 void graphics_set_palette(uint8_t i, uint32_t color888) {
-    palette[i] = color888 & 0x00ffffff;
-
-
-    if ((i >= BASE_HDMI_CTRL_INX) && (i != 255)) return; //не записываем "служебные" цвета
-
-    uint64_t* conv_color64 = (uint64_t *)conv_color;
-    const uint8_t R = (color888 >> 16) & 0xff;
-    const uint8_t G = (color888 >> 8) & 0xff;
-    const uint8_t B = (color888 >> 0) & 0xff;
-    conv_color64[i * 2] = get_ser_diff_data(tmds_encoder(R), tmds_encoder(G), tmds_encoder(B));
-    conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ 0x0003ffffffffffffl;
+    set_conv_color(i, color888);
 };
 
 void graphics_set_buffer(uint8_t* buffer, uint16_t width, uint16_t height) {
@@ -573,29 +598,34 @@ void graphics_init() {
 
 
     // FIXME сделать конфигурацию пользователем
-    graphics_set_palette(200, RGB888(0x00, 0x00, 0x00)); //black
-    graphics_set_palette(201, RGB888(0x00, 0x00, 0xC4)); //blue
-    graphics_set_palette(202, RGB888(0x00, 0xC4, 0x00)); //green
-    graphics_set_palette(203, RGB888(0x00, 0xC4, 0xC4)); //cyan
-    graphics_set_palette(204, RGB888(0xC4, 0x00, 0x00)); //red
-    graphics_set_palette(205, RGB888(0xC4, 0x00, 0xC4)); //magenta
-    graphics_set_palette(206, RGB888(0xC4, 0x7E, 0x00)); //brown
-    graphics_set_palette(207, RGB888(0xC4, 0xC4, 0xC4)); //light gray
-    graphics_set_palette(208, RGB888(0x4E, 0x4E, 0x4E)); //dark gray
-    graphics_set_palette(209, RGB888(0x4E, 0x4E, 0xDC)); //light blue
-    graphics_set_palette(210, RGB888(0x4E, 0xDC, 0x4E)); //light green
-    graphics_set_palette(211, RGB888(0x4E, 0xF3, 0xF3)); //light cyan
-    graphics_set_palette(212, RGB888(0xDC, 0x4E, 0x4E)); //light red
-    graphics_set_palette(213, RGB888(0xF3, 0x4E, 0xF3)); //light magenta
-    graphics_set_palette(214, RGB888(0xF3, 0xF3, 0x4E)); //yellow
-    graphics_set_palette(215, RGB888(0xFF, 0xFF, 0xFF)); //white
+    set_conv_color(BASE_HDMI_TEXT_INX + 0, RGB888(0x00, 0x00, 0x00)); //black
+    set_conv_color(BASE_HDMI_TEXT_INX + 1, RGB888(0x00, 0x00, 0xC4)); //blue
+    set_conv_color(BASE_HDMI_TEXT_INX + 2, RGB888(0x00, 0xC4, 0x00)); //green
+    set_conv_color(BASE_HDMI_TEXT_INX + 3, RGB888(0x00, 0xC4, 0xC4)); //cyan
+    set_conv_color(BASE_HDMI_TEXT_INX + 4, RGB888(0xC4, 0x00, 0x00)); //red
+    set_conv_color(BASE_HDMI_TEXT_INX + 5, RGB888(0xC4, 0x00, 0xC4)); //magenta
+    set_conv_color(BASE_HDMI_TEXT_INX + 6, RGB888(0xC4, 0x7E, 0x00)); //brown
+    set_conv_color(BASE_HDMI_TEXT_INX + 7, RGB888(0xC4, 0xC4, 0xC4)); //light gray
+    set_conv_color(BASE_HDMI_TEXT_INX + 8, RGB888(0x4E, 0x4E, 0x4E)); //dark gray
+    set_conv_color(BASE_HDMI_TEXT_INX + 9, RGB888(0x4E, 0x4E, 0xDC)); //light blue
+    set_conv_color(BASE_HDMI_TEXT_INX + 10, RGB888(0x4E, 0xDC, 0x4E)); //light green
+    set_conv_color(BASE_HDMI_TEXT_INX + 11, RGB888(0x4E, 0xF3, 0xF3)); //light cyan
+    set_conv_color(BASE_HDMI_TEXT_INX + 12, RGB888(0xDC, 0x4E, 0x4E)); //light red
+    set_conv_color(BASE_HDMI_TEXT_INX + 13, RGB888(0xF3, 0x4E, 0xF3)); //light magenta
+    set_conv_color(BASE_HDMI_TEXT_INX + 14, RGB888(0xF3, 0xF3, 0x4E)); //yellow
+    set_conv_color(BASE_HDMI_TEXT_INX + 15, RGB888(0xFF, 0xFF, 0xFF)); //white
 
     hdmi_init();
 }
 
 void graphics_set_bgcolor(uint32_t color888) //определяем зарезервированный цвет в палитре
 {
-    graphics_set_palette(255, color888);
+    set_conv_color(HDMI_BG_INX, color888);
+};
+
+void graphics_set_line_source(const uint8_t* (*get_line)(int y), void (*frame_end)(void)) {
+    line_source = get_line;
+    line_source_frame_end = frame_end;
 };
 
 void graphics_set_offset(int x, int y) {
@@ -27,9 +27,14 @@ extern "C" {
 
 #define RGB888(r, g, b) ((r<<16) | (g << 8 ) | b )
 
+// Индексы TMDS палитры: 0-255 цвета graphics_set_palette, выше служебные
+// (фон 256, синхра 257-260, текст 261-276)
+#define BASE_HDMI_TEXT_INX (261)
+#define HDMI_CONV_COLORS (BASE_HDMI_TEXT_INX + 16)
+
 // TODO: Сделать настраиваемо
-static const uint8_t textmode_palette[16] = {
-    200, 201, 202, 203, 204, 205, 206, 207, 208, 209, 210, 211, 212, 213, 214, 215
+static const uint16_t textmode_palette[16] = {
+    261, 262, 263, 264, 265, 266, 267, 268, 269, 270, 271, 272, 273, 274, 275, 276
 };
 
 
@@ -51,6 +51,15 @@ static uint graphics_buffer_height = 0;
 static int graphics_buffer_shift_x = 0;
 static int graphics_buffer_shift_y = 0;
 
+// One flag per graphics buffer line, set by the emulation for the lines it
+// changed; NULL to send the whole buffer every refresh.
+static uint8_t* dirty_lines = NULL;
+static void (*refresh_yield)(void) = NULL;
+
+// Lines converted to RGB565 for the DMA, one sent while the next is filled
+#define LCD_LINE_MAX 384
+static uint16_t lcd_line[2][LCD_LINE_MAX];
+
 enum graphics_mode_t graphics_mode = GRAPHICSMODE_DEFAULT;
 
 static const uint8_t init_seq[] = {
@@ -199,10 +208,26 @@ void graphics_set_textbuffer(uint8_t* buffer) {
 void graphics_set_offset(const int x, const int y) {
     graphics_buffer_shift_x = x;
     graphics_buffer_shift_y = y;
+    graphics_set_all_dirty();
+}
+
+void graphics_set_dirty_lines(uint8_t* lines) {
+    dirty_lines = lines;
+    graphics_set_all_dirty();
+}
+
+void graphics_set_refresh_yield(void (*yield)(void)) {
+    refresh_yield = yield;
+}
+
+void graphics_set_all_dirty() {
+    if (dirty_lines)
+        memset(dirty_lines, 1, graphics_buffer_height);
 }
 
 void clrScr(const uint8_t color) {
     memset(&graphics_buffer[0], 0, graphics_buffer_height * graphics_buffer_width);
+    graphics_set_all_dirty();
     lcd_set_window(0, 0,SCREEN_WIDTH,SCREEN_HEIGHT);
     uint32_t i = SCREEN_WIDTH * SCREEN_HEIGHT;
     start_pixels();
@@ -222,6 +247,37 @@ void st7789_dma_pixels(const uint16_t* pixels, const uint num_pixels) {
     dma_channel_hw_addr(st7789_chan)->ctrl_trig = ctrl | DMA_CH0_CTRL_TRIG_INCR_READ_BITS;
 }
 
+// Sends lines y to y + count - 1 of the graphics buffer in one window.
+// A negative x offset crops the left of the buffer, and what does not fit
+// on the right is cropped too.
+static void __scratch_y("refresh_lcd") lcd_send_lines(const int y, const int count) {
+    const int skip = graphics_buffer_shift_x < 0 ? -graphics_buffer_shift_x : 0;
+    const int x0 = graphics_buffer_shift_x < 0 ? 0 : graphics_buffer_shift_x;
+    int width = (int)graphics_buffer_width - skip;
+    if (width > SCREEN_WIDTH - x0)
+        width = SCREEN_WIDTH - x0;
+    if (width <= 0)
+        return;
+    const uint8_t* row = graphics_buffer + y * graphics_buffer_width + skip;
+    int buffer = 0;
+
+    lcd_set_window(x0, graphics_buffer_shift_y + y, width, count);
+    start_pixels();
+    for (int i = 0; i < count; i++) {
+        uint16_t* line = lcd_line[buffer];
+        const uint8_t* bitmap = row + i * graphics_buffer_width;
+        // the DMA may still be sending the other buffer, never this one
+        for (int x = 0; x < width; x++)
+            line[x] = palette[*bitmap++];
+        st7789_dma_pixels(line, width);
+        buffer ^= 1;
+        if (refresh_yield)
+            refresh_yield();
+    }
+    dma_channel_wait_for_finish_blocking(st7789_chan);
+    stop_pixels();
+}
+
 void __inline __scratch_y("refresh_lcd") refresh_lcd() {
     switch (graphics_mode) {
         case TEXTMODE_DEFAULT:
@@ -248,6 +304,25 @@ void __inline __scratch_y("refresh_lcd") refresh_lcd() {
             stop_pixels();
             break;
         case GRAPHICSMODE_DEFAULT: {
+            if (!dirty_lines && graphics_buffer_width <= LCD_LINE_MAX) {
+                lcd_send_lines(0, graphics_buffer_height);
+                break;
+            }
+            if (dirty_lines && graphics_buffer_width <= LCD_LINE_MAX) {
+                // Runs of changed lines only. A flag is cleared before its
+                // line is read, so a line changed meanwhile goes next time.
+                for (int y = 0; y < graphics_buffer_height;) {
+                    if (!dirty_lines[y]) {
+                        y++;
+                        continue;
+                    }
+                    const int first = y;
+                    while (y < graphics_buffer_height && dirty_lines[y])
+                        dirty_lines[y++] = 0;
+                    lcd_send_lines(first, y - first);
+                }
+                break;
+            }
             const uint8_t* bitmap = graphics_buffer;
             lcd_set_window(graphics_buffer_shift_x, graphics_buffer_shift_y, graphics_buffer_width,
                            graphics_buffer_height);
@@ -267,5 +342,6 @@ void __inline __scratch_y("refresh_lcd") refresh_lcd() {
 
 void graphics_set_palette(const uint8_t i, const uint32_t color) {
     palette[i] = (uint16_t)color;
+    graphics_set_all_dirty();
 }
 
@@ -56,3 +56,13 @@ inline static void graphics_set_bgcolor(uint32_t color888) {
     // dummy
 }
 void refresh_lcd();
+
+// Partial refresh: LINES holds a flag per line of the graphics buffer that
+// is set when the line changes; refresh_lcd sends the runs of set lines and
+// clears them. NULL sends the whole buffer every time.
+void graphics_set_dirty_lines(uint8_t* lines);
+void graphics_set_all_dirty();
+
+// Called by refresh_lcd after each line is handed to the DMA, so that the
+// caller's core can do other work while the line goes over SPI
+void graphics_set_refresh_yield(void (*yield)(void));
@@ -39,11 +39,19 @@ static int shift_picture = 0;
 
 static int visible_line_size = 320;
 
+//пикселей в строке GRAPHICSMODE_DEFAULT, см. graphics_set_scanout
+static int scanout_width = 320;
+#define SCANOUT_MAX (384)
+//шаблоны строк лежат с шагом самой длинной строки
+#define LINE_SIZE_MAX (800 * SCANOUT_MAX / 320)
+
 
 static int dma_chan_ctrl;
 static int dma_chan;
 
 static uint8_t* graphics_buffer;
+static const uint8_t* (*line_source)(int y) = NULL;
+static void (*line_source_frame_end)(void) = NULL;
 uint8_t* text_buffer = NULL;
 static uint graphics_buffer_width = 0;
 static uint graphics_buffer_height = 0;
@@ -85,6 +93,8 @@ void __time_critical_func() dma_handler_VGA() {
     }
 
     if (screen_line >= N_lines_visible) {
+        if (screen_line == N_lines_visible && line_source_frame_end) line_source_frame_end();
+
         //заполнение цветом фона
         if (screen_line == N_lines_visible | screen_line == N_lines_visible + 3) {
             uint32_t* output_buffer_32bit = lines_pattern[2 + (screen_line & 1)];
@@ -104,7 +114,7 @@ void __time_critical_func() dma_handler_VGA() {
         return;
     }
 
-    if (!input_buffer) {
+    if (!input_buffer && !line_source) {
         dma_channel_set_read_addr(dma_chan_ctrl, &lines_pattern[0], false);
         return;
     } //если нет видеобуфера - рисуем пустую строку
@@ -122,6 +132,7 @@ void __time_critical_func() dma_handler_VGA() {
         case ATARI_384x240x2:
         case GRAPHICSMODE_DEFAULT:
             line_number = screen_line / 2;
+            // the second scanline of a line resends the first: line_source is asked once
             if (screen_line % 2) return;
             y = screen_line / 2 - graphics_buffer_shift_y;
             break;
@@ -222,7 +233,7 @@ void __time_critical_func() dma_handler_VGA() {
     if (graphics_mode == CGA_640x200x2) {
         graphics_buffer_shift_x &= 0xfffffff1; //1bit buf
     }
-    else {
+    else if (graphics_mode != GRAPHICSMODE_DEFAULT) {
         graphics_buffer_shift_x &= 0xfffffff2; //2bit buf
     }
 
@@ -325,10 +336,29 @@ void __time_critical_func() dma_handler_VGA() {
             break;
         }
         case GRAPHICSMODE_DEFAULT:
-            input_buffer_8bit = input_buffer + y * width;
-            for (int i = width; i--;) {
-                //*output_buffer_16bit++=current_palette[*input_buffer_8bit++];
-                *output_buffer_16bit++ = current_palette[*input_buffer_8bit++];
+            if (line_source) {
+                input_buffer_8bit = (uint8_t *)line_source(y);
+                // the beam overtook the emulation: keep the old line
+                if (!input_buffer_8bit) break;
+                if (graphics_buffer_shift_x < 0) input_buffer_8bit -= graphics_buffer_shift_x;
+            }
+            else {
+                input_buffer_8bit = graphics_buffer + y * graphics_buffer_width;
+                if (graphics_buffer_shift_x < 0) input_buffer_8bit -= graphics_buffer_shift_x;
+            }
+            //по два пикселя на слово
+            if (((uintptr_t)output_buffer_16bit & 3) == 0) {
+                uint32_t* output_buffer_32bit = (uint32_t *)output_buffer_16bit;
+                for (int i = width / 2; i--;) {
+                    const uint32_t p0 = current_palette[*input_buffer_8bit++];
+                    *output_buffer_32bit++ = p0 | current_palette[*input_buffer_8bit++] << 16;
+                }
+                if (width & 1) *(uint16_t *)output_buffer_32bit = current_palette[*input_buffer_8bit];
+            }
+            else {
+                for (int i = width; i--;) {
+                    *output_buffer_16bit++ = current_palette[*input_buffer_8bit++];
+                }
             }
             break;
         case VGA_320x200x256x4:
@@ -348,6 +378,45 @@ void __time_critical_func() dma_handler_VGA() {
     dma_channel_set_read_addr(dma_chan_ctrl, output_buffer, false);
 }
 
+// Шаблоны строк и пиксельклок для WIDTH пикселей по два такта PIO.
+// Строка 640x480 (800 тактов: синхра 96, 48 до картинки, картинка 640, 16
+// после) растягивается в WIDTH / 320 раз вместе с частотой PIO, так что
+// строчная частота остаётся 31.47 кГц и картинка любой ширины занимает
+// весь экран.
+static void set_line_timing(const int width) {
+    const uint8_t TMPL_LINE8 = 0b11000000;
+    const uint8_t TMPL_VHS8 = TMPL_LINE8 ^ 0b11000000;
+    const uint8_t TMPL_VS8 = TMPL_LINE8 ^ 0b10000000;
+    const uint8_t TMPL_HS8 = TMPL_LINE8 ^ 0b01000000;
+
+    const int line_size = (800 * width / 320 + 3) & ~3;
+    const int HS_SIZE = 96 * width / 320;
+    const double fdiv = clock_get_hz(clk_sys) / (25175000.0 * line_size / 800); //частота пиксельклока
+
+    shift_picture = (144 * width / 320) & ~3;
+    visible_line_size = width;
+
+    const uint32_t div32 = (uint32_t)(fdiv * (1 << 16) + 0.0);
+    PIO_VGA->sm[_SM_VGA].clkdiv = div32 & 0xffffff00; //делитель для конкретной sm, с дробной частью
+    dma_channel_set_trans_count(dma_chan, line_size / 4, false);
+
+    uint8_t* base_ptr = (uint8_t *)lines_pattern[0];
+    //пустая строка
+    memset(base_ptr, TMPL_LINE8, line_size);
+    //выровненная синхра вначале
+    memset(base_ptr, TMPL_HS8, HS_SIZE);
+
+    // кадровая синхра
+    base_ptr = (uint8_t *)lines_pattern[1];
+    memset(base_ptr, TMPL_VS8, line_size);
+    //выровненная синхра вначале
+    memset(base_ptr, TMPL_VHS8, HS_SIZE);
+
+    //заготовки для строк с изображением
+    memcpy(lines_pattern[2], lines_pattern[0], line_size);
+    memcpy(lines_pattern[3], lines_pattern[0], line_size);
+}
+
 void graphics_set_mode(enum graphics_mode_t mode) {
     switch (mode) {
         case TEXTMODE_53x30:
@@ -360,24 +429,18 @@ void graphics_set_mode(enum graphics_mode_t mode) {
             text_buffer_width = 80;
             text_buffer_height = 30;
     }
-    memset(graphics_buffer, 0, graphics_buffer_height * graphics_buffer_width);
+    if (graphics_buffer) memset(graphics_buffer, 0, graphics_buffer_height * graphics_buffer_width);
     if (_SM_VGA < 0) return; // если  VGA не инициализирована -
 
     graphics_mode = mode;
+    //текст всегда в 320 пикселей, картинка - в ширину развёртки
+    const int width = mode == GRAPHICSMODE_DEFAULT ? scanout_width : 320;
 
-    // Если мы уже проиницилизированы - выходим
+    // Если мы уже проиницилизированы - меняем только развёртку
     if (txt_palette_fast && lines_pattern_data) {
+        if (width != visible_line_size) set_line_timing(width);
         return;
     };
-    uint8_t TMPL_VHS8 = 0;
-    uint8_t TMPL_VS8 = 0;
-    uint8_t TMPL_HS8 = 0;
-    uint8_t TMPL_LINE8 = 0;
-
-    int line_size;
-    double fdiv = 100;
-    int HS_SIZE = 4;
-    int HS_SHIFT = 100;
 
     switch (graphics_mode) {
         case TEXTMODE_160x100:
@@ -408,18 +471,11 @@ void graphics_set_mode(enum graphics_mode_t mode) {
         case EGA_320x200x16x4:
         case TGA_320x200x16:
         case ATARI_384x240x2:
-            TMPL_LINE8 = 0b11000000;
-            HS_SHIFT = 328 * 2;
-            HS_SIZE = 48 * 2;
-            line_size = 400 * 2;
-            shift_picture = line_size - HS_SHIFT;
             palette16_mask = 0xc0c0;
-            visible_line_size = 320;
             N_lines_total = 525;
             N_lines_visible = 480;
             line_VS_begin = 490;
             line_VS_end = 491;
-            fdiv = clock_get_hz(clk_sys) / 25175000.0; //частота пиксельклока
             break;
         default:
             return;
@@ -434,42 +490,21 @@ void graphics_set_mode(enum graphics_mode_t mode) {
     }
 
     //инициализация шаблонов строк и синхросигнала
-    if (!lines_pattern_data) //выделение памяти, если не выделено
+    if (!lines_pattern_data) //выделение памяти под самую длинную строку, если не выделено
     {
-        const uint32_t div32 = (uint32_t)(fdiv * (1 << 16) + 0.0);
-        PIO_VGA->sm[_SM_VGA].clkdiv = div32 & 0xfffff000; //делитель для конкретной sm
-        dma_channel_set_trans_count(dma_chan, line_size / 4, false);
-
-        lines_pattern_data = (uint32_t *)calloc(line_size * 4 / 4, sizeof(uint32_t));
+        lines_pattern_data = (uint32_t *)calloc(LINE_SIZE_MAX * 4 / 4, sizeof(uint32_t));
 
         for (int i = 0; i < 4; i++) {
-            lines_pattern[i] = &lines_pattern_data[i * (line_size / 4)];
+            lines_pattern[i] = &lines_pattern_data[i * (LINE_SIZE_MAX / 4)];
         }
-        // memset(lines_pattern_data,N_TMPLS*1200,0);
-        TMPL_VHS8 = TMPL_LINE8 ^ 0b11000000;
-        TMPL_VS8 = TMPL_LINE8 ^ 0b10000000;
-        TMPL_HS8 = TMPL_LINE8 ^ 0b01000000;
-
-        uint8_t* base_ptr = (uint8_t *)lines_pattern[0];
-        //пустая строка
-        memset(base_ptr, TMPL_LINE8, line_size);
-        //memset(base_ptr+HS_SHIFT,TMPL_HS8,HS_SIZE);
-        //выровненная синхра вначале
-        memset(base_ptr, TMPL_HS8, HS_SIZE);
-
-        // кадровая синхра
-        base_ptr = (uint8_t *)lines_pattern[1];
-        memset(base_ptr, TMPL_VS8, line_size);
-        //memset(base_ptr+HS_SHIFT,TMPL_VHS8,HS_SIZE);
-        //выровненная синхра вначале
-        memset(base_ptr, TMPL_VHS8, HS_SIZE);
-
-        //заготовки для строк с изображением
-        base_ptr = (uint8_t *)lines_pattern[2];
-        memcpy(base_ptr, lines_pattern[0], line_size);
-        base_ptr = (uint8_t *)lines_pattern[3];
-        memcpy(base_ptr, lines_pattern[0], line_size);
     }
+    set_line_timing(width);
+}
+
+void graphics_set_scanout(const int width) {
+    scanout_width = width < 320 ? 320 : width > SCANOUT_MAX ? SCANOUT_MAX : width & ~1;
+    if (lines_pattern_data && graphics_mode == GRAPHICSMODE_DEFAULT && scanout_width != visible_line_size)
+        set_line_timing(scanout_width);
 }
 
 void graphics_set_buffer(uint8_t* buffer, const uint16_t width, const uint16_t height) {
@@ -479,6 +514,11 @@ void graphics_set_buffer(uint8_t* buffer, const uint16_t width, const uint16_t h
 }
 
 
+void graphics_set_line_source(const uint8_t* (*get_line)(int y), void (*frame_end)(void)) {
+    line_source = get_line;
+    line_source_frame_end = frame_end;
+}
+
 void graphics_set_offset(const int x, const int y) {
     graphics_buffer_shift_x = x;
     graphics_buffer_shift_y = y;
@@ -11,3 +11,9 @@
 #define TEXTMODE_ROWS 30
 
 #define RGB888(r, g, b) ((r<<16) | (g << 8 ) | b )
+
+// Пикселей буфера на строку в GRAPHICSMODE_DEFAULT: 320 (обрезка), 336
+// (видимая часть строки Atari) или 384 (вся строка, с бордюром). Частота
+// PIO растягивается так, что они занимают весь экран 640x480; какие
+// столбцы попадут в строку, задаёт graphics_set_offset.
+void graphics_set_scanout(int width);
@@ -0,0 +1,139 @@
+/*
+ * antic_bench - time the ANTIC scanline renderers one display mode at a time.
+ *
+ * Usage: antic_bench [-frames N] [atari800 options]
+ *
+ * After booting the machine for a few frames the CPU is parked in a JMP
+ * loop with interrupts off, and every ANTIC mode 2-f is shown full screen
+ * from a display list of that mode alone over pseudo-random screen data and
+ * the OS font.  Each mode is run twice: with the playfield alone, and with
+ * four quadruple-width players over it, which sends the character cells
+ * they cover down the P/M path of the renderers.  For every run the
+ * rendering time per frame (the video timing slot) and the CRC32 of the
+ * screen are printed, so that a renderer can be both timed and checked for
+ * changes in what it draws.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "antic.h"
+#include "cpu.h"
+#include "crc32.h"
+#include "gtia.h"
+#include "memory.h"
+#include "pokey.h"
+#include "screen.h"
+#include "libatari800.h"
+
+#define PARK 0x0600		/* JMP PARK */
+#define DLIST 0x3c00
+#define SCREEN 0x4000
+
+/* scanlines per mode line */
+static const int mode_height[16] = { 0, 0, 8, 10, 8, 16, 8, 16, 8, 4, 4, 2, 1, 2, 1, 1 };
+
+static void setup_mode(int mode, int players)
+{
+	UWORD dl = DLIST;
+	int lines;
+	int row = 0;
+	int i;
+
+	/* 24 blank lines, then 192 of MODE, each line loading its own address */
+	for (i = 0; i < 3; i++)
+		MEMORY_dPutByte(dl++, 0x70);
+	for (lines = 0; lines + mode_height[mode] <= 192; lines += mode_height[mode], row++) {
+		UWORD addr = SCREEN + (row % 64) * 48;	/* 40 bytes at most */
+		MEMORY_dPutByte(dl++, 0x40 | mode);
+		MEMORY_dPutByte(dl++, addr & 0xff);
+		MEMORY_dPutByte(dl++, addr >> 8);
+	}
+	MEMORY_dPutByte(dl++, 0x41);
+	MEMORY_dPutByte(dl++, DLIST & 0xff);
+	MEMORY_dPutByte(dl++, DLIST >> 8);
+	ANTIC_PutByte(ANTIC_OFFSET_DLISTL, DLIST & 0xff);
+	ANTIC_PutByte(ANTIC_OFFSET_DLISTH, DLIST >> 8);
+
+	for (i = 0; i < 4; i++) {
+		GTIA_PutByte(GTIA_OFFSET_HPOSP0 + i, players ? 0x50 + 0x28 * i : 0);
+		GTIA_PutByte(GTIA_OFFSET_SIZEP0 + i, 3);
+		GTIA_PutByte(GTIA_OFFSET_GRAFP0 + i, players ? 0xa5 : 0);
+	}
+	GTIA_PutByte(GTIA_OFFSET_HITCLR, 0);
+}
+
+int main(int argc, char **argv)
+{
+	int frames = 1000;
+	int i, j;
+	int mode;
+	ULONG seed = 1;
+	timing_stats_t stats;
+
+	for (i = j = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else
+			argv[j++] = argv[i];
+	}
+	argv[j] = NULL;
+
+	if (!libatari800_init(j, argv)) {
+		fprintf(stderr, "antic_bench: libatari800_init failed\n");
+		return 1;
+	}
+	/* the same timing whatever the title table says */
+	libatari800_set_cycle_exact(LIBATARI800_CYCLE_EXACT_OFF);
+	{
+		input_template_t input;
+		libatari800_clear_input_array(&input);
+		for (i = 0; i < 10; i++)
+			libatari800_next_frame(&input);
+	}
+
+	/* park the CPU with no interrupts */
+	ANTIC_PutByte(ANTIC_OFFSET_NMIEN, 0);
+	POKEY_PutByte(POKEY_OFFSET_IRQEN, 0);
+	MEMORY_dPutByte(PARK, 0x4c);
+	MEMORY_dPutByte(PARK + 1, PARK & 0xff);
+	MEMORY_dPutByte(PARK + 2, PARK >> 8);
+	CPU_regPC = PARK;
+
+	for (i = 0; i < 64 * 48; i++) {
+		seed = seed * 1103515245 + 12345;
+		MEMORY_dPutByte(SCREEN + i, (UBYTE) (seed >> 16));
+	}
+	ANTIC_PutByte(ANTIC_OFFSET_CHBASE, 0xe0);
+	ANTIC_PutByte(ANTIC_OFFSET_CHACTL, 0x02);
+	ANTIC_PutByte(ANTIC_OFFSET_DMACTL, 0x22);
+	GTIA_PutByte(GTIA_OFFSET_PRIOR, 0x01);
+	GTIA_PutByte(GTIA_OFFSET_COLBK, 0x00);
+	for (i = 0; i < 4; i++) {
+		GTIA_PutByte(GTIA_OFFSET_COLPF0 + i, 0x24 + 0x32 * i);	/* hues and lumas all differ */
+		GTIA_PutByte(GTIA_OFFSET_COLPM0 + i, 0x1a + 0x30 * i);
+	}
+
+	printf("mode  %-21s  %-21s\n", "playfield", "with players");
+	printf("      %9s  %-10s  %9s  %-10s\n", "us/frame", "screen crc", "us/frame", "screen crc");
+	for (mode = 2; mode < 16; mode++) {
+		int players;
+		printf("%-4x", mode);
+		for (players = 0; players < 2; players++) {
+			setup_mode(mode, players);
+			for (i = 0; i < 2; i++)
+				ANTIC_Frame(TRUE);
+			libatari800_reset_timing_stats();
+			for (i = 0; i < frames; i++)
+				ANTIC_Frame(TRUE);
+			libatari800_get_timing_stats(&stats);
+			printf("  %9.2f", stats.nsec[LIBATARI800_TIMING_VIDEO] * 1e-3 / frames);
+			if (libatari800_get_screen_ptr() != NULL)
+				printf("  %08x  ", (unsigned int) ~CRC32_Update(0xffffffff, libatari800_get_screen_ptr(), Screen_WIDTH * Screen_HEIGHT));
+			else
+				printf("  %-10s", "-");
+		}
+		printf("\n");
+	}
+	return 0;
+}
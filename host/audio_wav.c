@@ -0,0 +1,227 @@
+/*
+ * audio_wav - render what the audio DMA would send to a WAV file.
+ *
+ * Usage: audio_wav [-frames N] [-o FILE] [-sink pwm|i2s] [-latency BLOCKS]
+ *                  [-drift PERCENT] [-sound inline|log|log-frame|async]
+ *                  [atari800 options] [image]
+ *
+ * The machine runs as on the device: every frame the sound of that frame
+ * (libatari800_get_sound_frame) is queued in the audio ring of
+ * drivers/audio, in blocks of half a frame, eight blocks with LATENCY of
+ * them queued before playback.  In place of the DMA interrupt the blocks
+ * are taken with audio_ring_next at the output rate, DRIFT percent faster
+ * than the emulation (negative: slower), and every word is turned back into
+ * a 16-bit sample: the duty cycle for the PWM sink, the left channel for
+ * I2S.  The WAV file at the output rate then holds what the speaker gets,
+ * silence before playback and after underruns included, and the ring
+ * counters are printed, with the render time per frame in the log modes.
+ *
+ * -dsprate and -audio16 select the rate and 16-bit POKEY output as for the
+ * emulator.
+ *
+ * -sound selects the synthesis (libatari800_set_sound_log): inline, log,
+ * log-frame, or async, which is log with the frames synthesized, queued and
+ * played on a thread of their own as on core 1 of the device.  async gives
+ * the same file as log, and log-frame the same as inline.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_ring.h"
+#include "libatari800.h"
+
+#define BLOCKS 8
+#define PWM_BITS 10	/* as PWM_AUDIO_BITS */
+
+static void put_le(FILE *fp, unsigned long v, int bytes)
+{
+	while (bytes--) {
+		fputc(v & 0xff, fp);
+		v >>= 8;
+	}
+}
+
+static void write_wav_header(FILE *fp, int freq, unsigned long samples)
+{
+	fwrite("RIFF", 1, 4, fp);
+	put_le(fp, 36 + samples * 2, 4);
+	fwrite("WAVEfmt ", 1, 8, fp);
+	put_le(fp, 16, 4);
+	put_le(fp, 1, 2);	/* PCM */
+	put_le(fp, 1, 2);	/* mono */
+	put_le(fp, freq, 4);
+	put_le(fp, freq * 2, 4);
+	put_le(fp, 2, 2);
+	put_le(fp, 16, 2);
+	fwrite("data", 1, 4, fp);
+	put_le(fp, samples * 2, 4);
+}
+
+static audio_ring_t ring;
+static FILE *fp;
+static double drift = 0;
+static int frame_len;
+static const uint32_t *block;
+static double due = 0;
+static unsigned long written = 0;
+static volatile int stop = FALSE;
+
+/* The sample a word of the ring stands for */
+static int word_sample(const audio_ring_t *ring, uint32_t word)
+{
+	if (ring->format == AUDIO_RING_PWM)
+		return (int) ((word & 0xffff) * 65536 / (ring->top + 1)) - 32768;
+	return (short) (word & 0xffff);
+}
+
+/* Queues the SAMPLES of a frame and plays the blocks due by then */
+static void play_frame(const short *buffer, int samples, int size)
+{
+	audio_ring_write(&ring, buffer, samples, size);
+	/* the output rate, DRIFT percent off */
+	due += samples * (1 + drift / 100);
+	while (due >= frame_len) {
+		int k;
+		for (k = 0; k < frame_len; k++) {
+			int v = word_sample(&ring, block[k]);
+			put_le(fp, (unsigned long) v & 0xffff, 2);
+		}
+		written += frame_len;
+		block = audio_ring_next(&ring);
+		due -= frame_len;
+	}
+}
+
+/* -sound async: synthesizes and plays the frames the emulation closes */
+static void *sound_thread(void *arg)
+{
+	static short buffer[4096];
+	int size = libatari800_get_sound_sample_size();
+
+	for (;;) {
+		int samples = libatari800_render_sound_frame(buffer, sizeof(buffer) / size);
+		if (samples > 0)
+			play_frame(buffer, samples, size);
+		else if (stop)
+			break;
+		else
+			sched_yield();
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int frames = 600;
+	const char *filename = "audio.wav";
+	int format = AUDIO_RING_PWM;
+	int latency = 3;
+	int sound = LIBATARI800_SOUND_INLINE;
+	int async = FALSE;
+	static short buffer[4096];
+	audio_ring_stats_t stats;
+	sound_log_stats_t log;
+	input_template_t input;
+	pthread_t thread;
+	int freq, size;
+	int i, j;
+
+	for (i = j = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			filename = argv[++i];
+		else if (strcmp(argv[i], "-sink") == 0 && i + 1 < argc)
+			format = strcmp(argv[++i], "i2s") == 0 ? AUDIO_RING_I2S : AUDIO_RING_PWM;
+		else if (strcmp(argv[i], "-latency") == 0 && i + 1 < argc)
+			latency = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-drift") == 0 && i + 1 < argc)
+			drift = atof(argv[++i]);
+		else if (strcmp(argv[i], "-sound") == 0 && i + 1 < argc) {
+			i++;
+			async = strcmp(argv[i], "async") == 0;
+			if (strcmp(argv[i], "log") == 0 || async)
+				sound = LIBATARI800_SOUND_LOG;
+			else if (strcmp(argv[i], "log-frame") == 0)
+				sound = LIBATARI800_SOUND_LOG_FRAME;
+			else
+				sound = LIBATARI800_SOUND_INLINE;
+		}
+		else
+			argv[j++] = argv[i];
+	}
+	argv[j] = NULL;
+
+	if (!libatari800_init(j, argv)) {
+		fprintf(stderr, "audio_wav: libatari800_init failed\n");
+		return 1;
+	}
+	freq = libatari800_get_sound_frequency();
+	size = libatari800_get_sound_sample_size();
+	if (freq == 0 || libatari800_get_num_sound_channels() != 1) {
+		fprintf(stderr, "audio_wav: needs mono sound\n");
+		return 1;
+	}
+	frame_len = freq / 120;
+	if (!libatari800_set_sound_log(sound)) {
+		fprintf(stderr, "audio_wav: cannot log the sound\n");
+		return 1;
+	}
+
+	memset(&ring, 0, sizeof(ring));
+	ring.format = format;
+	ring.top = (1 << PWM_BITS) - 1;
+	if (!audio_ring_init(&ring, BLOCKS, frame_len, latency)) {
+		fprintf(stderr, "audio_wav: out of memory\n");
+		return 1;
+	}
+	fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		fprintf(stderr, "audio_wav: cannot write %s\n", filename);
+		return 1;
+	}
+	write_wav_header(fp, freq, 0);
+
+	libatari800_clear_input_array(&input);
+	/* the DMA starts on silence */
+	block = ring.silence;
+	if (async && pthread_create(&thread, NULL, sound_thread, NULL) != 0) {
+		fprintf(stderr, "audio_wav: cannot start the sound thread\n");
+		return 1;
+	}
+	for (i = 0; i < frames; i++) {
+		libatari800_next_frame(&input);
+		if (async)
+			libatari800_end_sound_frame();
+		else
+			play_frame(buffer, libatari800_get_sound_frame(buffer, sizeof(buffer) / size), size);
+	}
+	if (async) {
+		stop = TRUE;
+		pthread_join(thread, NULL);
+	}
+
+	fseek(fp, 0, SEEK_SET);
+	write_wav_header(fp, freq, written);
+	if (fclose(fp) != 0) {
+		fprintf(stderr, "audio_wav: cannot write %s\n", filename);
+		return 1;
+	}
+	audio_ring_get_stats(&ring, &stats);
+	printf("output:      %s, %lu samples at %d Hz, %d-bit POKEY, %s sink\n", filename, written, freq,
+	       size * 8, format == AUDIO_RING_PWM ? "pwm" : "i2s");
+	printf("ring:        %u blocks of %d, latency %u\n", BLOCKS, frame_len, stats.latency);
+	printf("played:      %lu blocks, %lu underruns, %lu overruns, %u queued\n",
+	       (unsigned long) stats.blocks, (unsigned long) stats.underruns, (unsigned long) stats.overruns, stats.queued);
+	if (sound != LIBATARI800_SOUND_INLINE) {
+		libatari800_get_sound_log_stats(&log);
+		printf("log:         %llu writes, %llu frames overflowed, at most %u entries queued\n",
+		       log.writes, log.overflows, log.max_queued);
+		if (log.frames)
+			printf("render:      %llu us/frame, max %u us\n", log.render_us / log.frames, log.render_max_us);
+	}
+	return 0;
+}
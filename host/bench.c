@@ -0,0 +1,398 @@
+/*
+ * bench - run the Atari800 core headless and report emulation throughput.
+ *
+ * Usage: bench [-frames N] [-warmup N] [-heatmap FILE] [-profile FILE] [-banks N]
+ *              [-cycle-exact on|off|auto] [-batch | -batch-collisions]
+ *              [-render-split] [-line-cache] [-frameskip N [-frame-budget US]]
+ *              [-display [-beam-race]] [-pm-colls bytes|masks|check]
+ *              [atari800 options] [image]
+ *
+ * Any option not recognised here is passed to libatari800_init, so machine
+ * selection (-xl, -xe, -pal, ...) and the XEX/ATR/XFD image to boot work as
+ * on the command line of the emulator.  The CRC32 of the final screen and
+ * main memory are printed so that optimisations can be checked for changes
+ * in emulated behaviour.  The idle skip line reports the polling loops that
+ * CPU_GO fast-forwarded (IDLE_LOOP_SKIP in config.h).  With -DPREDECODE_ROM=ON
+ * the ROM pages decoded are reported; -DPREDECODE_CHECK=ON adds the share of
+ * instructions fetched predecoded and any that differed from memory.
+ *
+ * -heatmap writes the per-page access counts of the measured frames as CSV
+ * (page,cpu_read,cpu_write,cpu_fetch,antic,hardware); the core must be built
+ * with -DHEATMAP=ON for the counts to be non-zero.
+ *
+ * -profile writes the opcode counts and cycles, the sampled PC pages and the
+ * hardware register accesses of the measured frames as CSV sections; the
+ * core must be built with -DPROFILE=ON.
+ *
+ * -cycle-exact selects the display timing, off by default; auto uses the
+ * cycle-exact one for the titles listed in libatari800_main.c.  On and auto
+ * need the core built with -DCYCLE_EXACT=ON.  The timing
+ * line shows the one in use and the CRC32 of the image that keys it;
+ * timing_report.sh runs a set of images both ways.
+ *
+ * -batch runs the measured frames with a single libatari800_run_frames call,
+ * which draws only the last frame; -batch-collisions also detects P/M
+ * collisions in the other frames, so that games see the same collisions
+ * as with one libatari800_next_frame call per frame.
+ *
+ * -render-split draws the scanlines on a second thread, as core 1 does on
+ * the device (libatari800_set_render_split); the CRCs must not change.  The
+ * render line counts the lines handed over and the times the emulation had
+ * to wait for one.
+ *
+ * -line-cache leaves out the scanlines that would be drawn as they are in
+ * the screen buffer already (libatari800_set_line_cache); the CRCs must not
+ * change.  The line cache line counts the lines drawn and left alone.
+ *
+ * -frameskip N turns on the adaptive frame skip of libatari800_next_frame
+ * with at most N frames skipped in a row; -frame-budget sets the wall time
+ * per frame in microseconds, by default the frame period, which bench
+ * rarely falls behind.  Skipped frames change the screen CRC only.
+ *
+ * Built with -DSCANLINE_RING=ON there is no frame buffer, so the line ring
+ * counters take the place of the screen CRC; no display is attached, so
+ * ANTIC never waits and nothing is shown.  -display attaches a thread that
+ * takes the lines as an NTSC display would, 262 lines of 63.6 us, which
+ * paces the run to 60 frames a second; the line ring counters then include
+ * the input to display latency, and -beam-race turns on
+ * libatari800_set_beam_racing to shorten it.
+ *
+ * -pm-colls picks the player/missile collision engine
+ * (libatari800_set_pm_collisions); with masks the memory CRC must not
+ * change, and check runs both on every line and counts the lines on which
+ * they differ.
+ *
+ * -banks N writes PORTB N times after the measured frames, cycling through
+ * CPU and ANTIC XE bank selections, and reports bank switches per second.
+ * Use it with an XE memory size such as -xe or -ram-xl 320.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "antic.h"
+#include "crc32.h"
+#include "pia.h"
+#include "screen.h"
+#include "libatari800.h"
+#ifdef SCANLINE_RING
+#include "scanline_ring.h"
+#endif
+
+static const char *slot_names[LIBATARI800_TIMING_SLOTS] = {
+	"input", "cpu", "video", "gtia", "pokey", "sound"
+};
+
+static heatmap_t heat;
+
+/* CPU view of memory; MEMORY_mem holds RAM only when ROM or banks are paged */
+static UBYTE cpu_mem[65536];
+
+/* base RAM, banks 0-3 for CPU and ANTIC, bank 0 for ANTIC only and for CPU only */
+static const UBYTE bank_portb[] = { 0xff, 0xc3, 0xc7, 0xcb, 0xcf, 0xd3, 0xe3 };
+
+static int write_heatmap(const char *filename, const heatmap_t *h)
+{
+	FILE *fp = fopen(filename, "w");
+	int page;
+
+	if (fp == NULL)
+		return 0;
+	fprintf(fp, "page,cpu_read,cpu_write,cpu_fetch,antic,hardware\n");
+	for (page = 0; page < 256; page++)
+		fprintf(fp, "%02x,%llu,%llu,%llu,%llu,%llu\n", page, h->cpu_read[page], h->cpu_write[page],
+		        h->cpu_fetch[page], h->antic[page], h->hardware[page]);
+	return fclose(fp) == 0;
+}
+
+static volatile int render_running;
+
+static void *render_thread(void *arg)
+{
+	while (render_running)
+		if (!ANTIC_RenderLine())
+			sched_yield();
+	return NULL;
+}
+
+#ifdef SCANLINE_RING
+static volatile int display_running;
+
+static void *display_thread(void *arg)
+{
+	struct timespec t;
+	int y;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	while (display_running) {
+		for (y = 0; y < 262; y++) {
+			/* 63.556 us a line */
+			t.tv_nsec += 63556;
+			if (t.tv_nsec >= 1000000000) {
+				t.tv_nsec -= 1000000000;
+				t.tv_sec++;
+			}
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+			if (y < Screen_HEIGHT)
+				SCANLINE_RING_GetLine(y);
+			else if (y == Screen_HEIGHT)
+				SCANLINE_RING_EndFrame();
+		}
+	}
+	return NULL;
+}
+#endif
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+	int frames = 3000;
+	int warmup = 0;
+	const char *heatmap_file = NULL;
+	const char *profile_file = NULL;
+	long banks = 0;
+	int cycle_exact = LIBATARI800_CYCLE_EXACT_OFF;
+	int batch = -1;
+	int render_split = 0;
+	int line_cache = 0;
+	int display = 0;
+	int beam_race = 0;
+	int pm_colls = -1;
+	int frameskip = 0;
+	unsigned int frame_budget = 0;
+	pthread_t render;
+#ifdef SCANLINE_RING
+	pthread_t display_tid;
+#endif
+	int i, j;
+	double start, elapsed, total_nsec = 0;
+	input_template_t input;
+	timing_stats_t stats;
+	idle_stats_t idle;
+	predecode_stats_t predecode;
+	scanline_ring_stats_t ring;
+	render_split_stats_t split;
+	frame_skip_stats_t skip;
+	line_cache_stats_t cache;
+	pm_colls_stats_t colls;
+
+	for (i = j = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-warmup") == 0 && i + 1 < argc)
+			warmup = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-heatmap") == 0 && i + 1 < argc)
+			heatmap_file = argv[++i];
+		else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+			profile_file = argv[++i];
+		else if (strcmp(argv[i], "-banks") == 0 && i + 1 < argc)
+			banks = atol(argv[++i]);
+		else if (strcmp(argv[i], "-batch") == 0)
+			batch = 0;
+		else if (strcmp(argv[i], "-batch-collisions") == 0)
+			batch = LIBATARI800_RUN_COLLISIONS;
+		else if (strcmp(argv[i], "-frameskip") == 0 && i + 1 < argc)
+			frameskip = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-frame-budget") == 0 && i + 1 < argc)
+			frame_budget = (unsigned int) atol(argv[++i]);
+		else if (strcmp(argv[i], "-render-split") == 0)
+			render_split = 1;
+		else if (strcmp(argv[i], "-line-cache") == 0)
+			line_cache = 1;
+		else if (strcmp(argv[i], "-display") == 0)
+			display = 1;
+		else if (strcmp(argv[i], "-beam-race") == 0)
+			beam_race = 1;
+		else if (strcmp(argv[i], "-pm-colls") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "bytes") == 0)
+				pm_colls = LIBATARI800_PM_COLLS_BYTES;
+			else if (strcmp(argv[i], "masks") == 0)
+				pm_colls = LIBATARI800_PM_COLLS_MASKS;
+			else if (strcmp(argv[i], "check") == 0)
+				pm_colls = LIBATARI800_PM_COLLS_CHECK;
+		}
+		else if (strcmp(argv[i], "-cycle-exact") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "on") == 0)
+				cycle_exact = LIBATARI800_CYCLE_EXACT_ON;
+			else if (strcmp(argv[i], "off") == 0)
+				cycle_exact = LIBATARI800_CYCLE_EXACT_OFF;
+			else if (strcmp(argv[i], "auto") == 0)
+				cycle_exact = LIBATARI800_CYCLE_EXACT_AUTO;
+		}
+		else
+			argv[j++] = argv[i];
+	}
+	argv[j] = NULL;
+
+	if (!libatari800_init(j, argv)) {
+		fprintf(stderr, "bench: libatari800_init failed\n");
+		return 1;
+	}
+	if (!libatari800_set_cycle_exact(cycle_exact)) {
+		fprintf(stderr, "bench: cycle-exact timing not available\n");
+		return 1;
+	}
+	if (!libatari800_set_frame_skip(frameskip, frame_budget)) {
+		fprintf(stderr, "bench: frame skip not available\n");
+		return 1;
+	}
+	libatari800_clear_input_array(&input);
+	if (render_split) {
+		render_running = 1;
+		if (pthread_create(&render, NULL, render_thread, NULL) != 0) {
+			fprintf(stderr, "bench: cannot start the render thread\n");
+			return 1;
+		}
+		libatari800_set_render_split(1);
+	}
+	libatari800_set_line_cache(line_cache);
+	if (pm_colls >= 0)
+		libatari800_set_pm_collisions(pm_colls);
+	if (!libatari800_set_beam_racing(beam_race)) {
+		fprintf(stderr, "bench: beam racing needs SCANLINE_RING\n");
+		return 1;
+	}
+	if (display) {
+#ifdef SCANLINE_RING
+		SCANLINE_RING_Attach(1);
+		display_running = 1;
+		if (pthread_create(&display_tid, NULL, display_thread, NULL) != 0) {
+			fprintf(stderr, "bench: cannot start the display thread\n");
+			return 1;
+		}
+#else
+		fprintf(stderr, "bench: -display needs SCANLINE_RING\n");
+		return 1;
+#endif
+	}
+
+	for (i = 0; i < warmup; i++)
+		libatari800_next_frame(&input);
+
+	libatari800_reset_timing_stats();
+	libatari800_reset_heatmap();
+	libatari800_reset_idle_stats();
+	libatari800_reset_profile();
+	libatari800_reset_predecode_stats();
+	libatari800_reset_scanline_ring_stats();
+	libatari800_reset_render_split_stats();
+	libatari800_reset_frame_skip_stats();
+	libatari800_reset_line_cache_stats();
+	libatari800_reset_pm_colls_stats();
+	start = now();
+	/* The error code is sticky and also reports a transient empty display
+	   list during boot, so only a CPU crash ends the run early. */
+	if (batch >= 0) {
+		i = libatari800_run_frames(frames, batch);
+		if (i < frames)
+			fprintf(stderr, "bench: stopped at frame %d: %s\n", i, libatari800_error_message());
+	}
+	else for (i = 0; i < frames; i++) {
+		if (!libatari800_next_frame(&input) && libatari800_error_code == LIBATARI800_CPU_CRASH) {
+			fprintf(stderr, "bench: stopped at frame %d: %s\n", i, libatari800_error_message());
+			break;
+		}
+	}
+	elapsed = now() - start;
+	libatari800_get_timing_stats(&stats);
+	libatari800_get_idle_stats(&idle);
+	libatari800_get_predecode_stats(&predecode);
+	libatari800_get_scanline_ring_stats(&ring);
+	libatari800_get_render_split_stats(&split);
+	libatari800_get_frame_skip_stats(&skip);
+	libatari800_get_line_cache_stats(&cache);
+	libatari800_get_pm_colls_stats(&colls);
+#ifdef SCANLINE_RING
+	if (display) {
+		display_running = 0;
+		pthread_join(display_tid, NULL);
+		SCANLINE_RING_Attach(0);
+	}
+#endif
+	if (render_split) {
+		libatari800_set_render_split(0);
+		render_running = 0;
+		pthread_join(render, NULL);
+	}
+
+	printf("timing:      %s (title %08x)\n", libatari800_get_cycle_exact() ? "cycle-exact" : "scanline",
+	       (unsigned int) libatari800_get_title_crc());
+	printf("frames:      %lu in %.3f s\n", (unsigned long) stats.frames, elapsed);
+	printf("frames/sec:  %.1f\n", stats.frames / elapsed);
+	printf("cycles/sec:  %.0f (%.2f MHz)\n", stats.cpu_cycles / elapsed, stats.cpu_cycles / elapsed * 1e-6);
+	printf("idle skips:  %llu (%llu passes, %.1f%% of cycles)\n", idle.loops, idle.iterations,
+	       stats.cpu_cycles ? 100.0 * idle.cycles / stats.cpu_cycles : 0.0);
+	if (predecode.pages > 0) {
+		printf("predecoded:  %llu pages, %llu flushes\n", predecode.pages, predecode.flushes);
+		if (predecode.fetches > 0)
+			printf("             %.1f%% of fetches, %llu mismatches\n",
+			       100.0 * predecode.hits / predecode.fetches, predecode.mismatches);
+	}
+	if (frameskip > 0)
+		printf("frame skip:  %llu of %llu skipped, %llu capped, longest run %u\n",
+		       skip.skipped, skip.frames, skip.capped, skip.longest_run);
+	if (render_split)
+		printf("render:      %llu lines, %llu waits\n", split.lines, split.waits);
+	if (line_cache)
+		printf("line cache:  %llu drawn, %llu skipped (%.1f%%)\n", cache.drawn, cache.skipped,
+		       cache.drawn + cache.skipped ? 100.0 * cache.skipped / (cache.drawn + cache.skipped) : 0.0);
+	if (pm_colls > LIBATARI800_PM_COLLS_BYTES) {
+		printf("collisions:  %llu lines with players or missiles", colls.lines);
+		if (pm_colls == LIBATARI800_PM_COLLS_CHECK)
+			printf(", %llu checked, %llu mismatches", colls.checked, colls.mismatches);
+		printf("\n");
+	}
+	if (libatari800_get_screen_ptr() != NULL)
+		printf("screen crc:  %08x\n", (unsigned int) ~CRC32_Update(0xffffffff, libatari800_get_screen_ptr(), Screen_WIDTH * Screen_HEIGHT));
+	else
+		printf("line ring:   %llu shown, %llu underruns, %llu stalls, %llu late frames\n",
+		       ring.lines, ring.underruns, ring.stalls, ring.late_frames);
+	if (ring.latency_frames > 0)
+		printf("latency:     %.0f us average, %llu us max (%llu frames)\n",
+		       (double) ring.latency_us / ring.latency_frames, ring.latency_max_us, ring.latency_frames);
+	libatari800_get_main_memory(cpu_mem);
+	printf("memory crc:  %08x\n", (unsigned int) ~CRC32_Update(0xffffffff, cpu_mem, 65536));
+	for (i = 0; i < LIBATARI800_TIMING_SLOTS; i++)
+		total_nsec += stats.nsec[i];
+	if (total_nsec > 0) {
+		for (i = 0; i < LIBATARI800_TIMING_SLOTS; i++)
+			printf("%-12s %9.3f ms %5.1f%%  %7.2f us/frame\n", slot_names[i],
+			       stats.nsec[i] * 1e-6, 100.0 * stats.nsec[i] / total_nsec,
+			       stats.frames ? stats.nsec[i] * 1e-3 / stats.frames : 0.0);
+	}
+	if (banks > 0) {
+		long n;
+		UBYTE pbctl = PIA_PBCTL;
+		PIA_PutByte(PIA_OFFSET_PBCTL, pbctl | 0x04);	/* select ORB */
+		start = now();
+		for (n = 0; n < banks; n++)
+			PIA_PutByte(PIA_OFFSET_PORTB, bank_portb[n % sizeof(bank_portb)]);
+		elapsed = now() - start;
+		PIA_PutByte(PIA_OFFSET_PORTB, 0xff);
+		PIA_PutByte(PIA_OFFSET_PBCTL, pbctl);
+		printf("banks/sec:   %.0f\n", banks / elapsed);
+	}
+	if (profile_file != NULL && !libatari800_dump_profile(profile_file)) {
+		fprintf(stderr, "bench: cannot write %s\n", profile_file);
+		return 1;
+	}
+	if (heatmap_file != NULL) {
+		libatari800_get_heatmap(NULL, &heat);
+		if (!write_heatmap(heatmap_file, &heat)) {
+			fprintf(stderr, "bench: cannot write %s\n", heatmap_file);
+			return 1;
+		}
+	}
+	return 0;
+}
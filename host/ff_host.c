@@ -0,0 +1,90 @@
+/*
+ * POSIX implementation of the host FatFs stand-in (see include/ff.h).
+ */
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* FatFs and POSIX both call their directory handle DIR. */
+#define DIR FF_DIR
+#include "ff.h"
+#undef DIR
+#include <dirent.h>
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode)
+{
+	return FR_NO_FILE;
+}
+
+FRESULT f_close(FIL *fp)
+{
+	return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+	*br = 0;
+	return FR_INVALID_OBJECT;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+	*bw = 0;
+	return FR_INVALID_OBJECT;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+	return fseek(fp, (long) ofs, SEEK_SET) == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FSIZE_t f_size(FIL *fp)
+{
+	long pos = ftell(fp);
+	long len;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, pos, SEEK_SET);
+	return (FSIZE_t) len;
+}
+
+FRESULT f_opendir(FF_DIR *dp, const TCHAR *path)
+{
+	dp->handle = opendir(path);
+	return dp->handle != NULL ? FR_OK : FR_NO_PATH;
+}
+
+FRESULT f_closedir(FF_DIR *dp)
+{
+	if (dp->handle != NULL)
+		closedir((DIR *) dp->handle);
+	dp->handle = NULL;
+	return FR_OK;
+}
+
+FRESULT f_readdir(FF_DIR *dp, FILINFO *fno)
+{
+	struct dirent *entry;
+	do
+		entry = readdir((DIR *) dp->handle);
+	while (entry != NULL && entry->d_name[0] == '.');
+	if (entry == NULL) {
+		fno->fname[0] = '\0';
+		return FR_OK;
+	}
+	strncpy(fno->fname, entry->d_name, sizeof(fno->fname) - 1);
+	fno->fname[sizeof(fno->fname) - 1] = '\0';
+	fno->fattrib = entry->d_type == DT_DIR ? AM_DIR : 0;
+	fno->fsize = 0;
+	return FR_OK;
+}
+
+FRESULT f_mkdir(const TCHAR *path)
+{
+	return mkdir(path, 0777) == 0 ? FR_OK : FR_DENIED;
+}
+
+FRESULT f_rmdir(const TCHAR *path)
+{
+	return rmdir(path) == 0 ? FR_OK : FR_DENIED;
+}
@@ -0,0 +1,77 @@
+/*
+ * Host stand-in for the FatFs API used by the Atari800 core.
+ *
+ * The core mixes FatFs objects (SYSROM scanning, DBG_WRITE) with plain stdio
+ * streams that reach FatFs helpers through Util_flen()/Util_rewind().  On the
+ * host FIL is therefore the stdio FILE itself: f_size()/f_lseek() operate on
+ * real streams, while f_open() never succeeds, so the built-in Altirra ROMs
+ * are used and debug logging is dropped.  Directory calls map onto POSIX.
+ */
+#ifndef HOST_FF_H_
+#define HOST_FF_H_
+
+#include <stdio.h>
+
+typedef unsigned int	UINT;
+typedef unsigned char	BYTE;
+typedef unsigned long	FSIZE_t;
+typedef char			TCHAR;
+
+typedef FILE FIL;
+
+typedef struct {
+	void *handle;
+} DIR;
+
+typedef struct {
+	FSIZE_t	fsize;
+	BYTE	fattrib;
+	TCHAR	fname[256];
+} FILINFO;
+
+typedef enum {
+	FR_OK = 0,
+	FR_DISK_ERR,
+	FR_INT_ERR,
+	FR_NOT_READY,
+	FR_NO_FILE,
+	FR_NO_PATH,
+	FR_INVALID_NAME,
+	FR_DENIED,
+	FR_EXIST,
+	FR_INVALID_OBJECT,
+	FR_WRITE_PROTECTED,
+	FR_INVALID_DRIVE,
+	FR_NOT_ENABLED,
+	FR_NO_FILESYSTEM,
+	FR_MKFS_ABORTED,
+	FR_TIMEOUT,
+	FR_LOCKED,
+	FR_NOT_ENOUGH_CORE,
+	FR_TOO_MANY_OPEN_FILES,
+	FR_INVALID_PARAMETER
+} FRESULT;
+
+#define	FA_READ				0x01
+#define	FA_WRITE			0x02
+#define	FA_OPEN_EXISTING	0x00
+#define	FA_CREATE_NEW		0x04
+#define	FA_CREATE_ALWAYS	0x08
+#define	FA_OPEN_ALWAYS		0x10
+#define	FA_OPEN_APPEND		0x30
+
+#define AM_DIR	0x10
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FSIZE_t f_size(FIL *fp);
+FRESULT f_opendir(DIR *dp, const TCHAR *path);
+FRESULT f_closedir(DIR *dp);
+FRESULT f_readdir(DIR *dp, FILINFO *fno);
+FRESULT f_mkdir(const TCHAR *path);
+FRESULT f_rmdir(const TCHAR *path);
+
+#endif /* HOST_FF_H_ */
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the pico-sdk hardware headers used by the Atari800 core.
+ * There is no activity LED on a workstation, so GPIO writes are dropped.
+ */
+#ifndef HOST_HARDWARE_PIO_H_
+#define HOST_HARDWARE_PIO_H_
+
+#include <stdbool.h>
+
+#ifndef PICO_DEFAULT_LED_PIN
+#define PICO_DEFAULT_LED_PIN 25
+#endif
+
+static inline void gpio_put(unsigned int gpio, bool value)
+{
+}
+
+#endif /* HOST_HARDWARE_PIO_H_ */
@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the pico-sdk time functions used by the Atari800 core.
+ */
+#ifndef HOST_PICO_TIME_H_
+#define HOST_PICO_TIME_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+static inline uint64_t time_us_64(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000u + (uint64_t) ts.tv_nsec / 1000u;
+}
+
+static inline void sleep_us(uint64_t us)
+{
+	usleep((useconds_t) us);
+}
+
+#endif /* HOST_PICO_TIME_H_ */
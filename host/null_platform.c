@@ -0,0 +1,41 @@
+/*
+ * Null platform layer for the host build: no keyboard, joysticks or mouse,
+ * and the default sound setup that src/main.cpp uses on the device.
+ */
+#include "config.h"
+#include "akey.h"
+#include "atari.h"
+#include "platform.h"
+#include "sound.h"
+
+int LIBATARI800_Input_Initialise(int *argc, char *argv[])
+{
+	return TRUE;
+}
+
+int PLATFORM_Keyboard(void)
+{
+	return AKEY_NONE;
+}
+
+void LIBATARI800_Mouse(void)
+{
+}
+
+int PLATFORM_PORT(int num)
+{
+	return 0xff;
+}
+
+int PLATFORM_TRIG(int num)
+{
+	return 1;
+}
+
+Sound_setup_t Sound_desired = {
+	15720,
+	1,  /* 8 bit */
+	1,  /* 1 channel */
+	0,
+	0
+};
@@ -0,0 +1,420 @@
+/*
+ * pokey_bench - time the POKEY mixers on scripted register writes.
+ *
+ * Usage: pokey_bench [-seconds N] [-rate HZ] [-volume PERCENT] [-stereo] [atari800 options]
+ *
+ * Each scenario writes the POKEY registers at a fixed rate and renders the
+ * sound between the writes, SECONDS of it at RATE, from POKEYSND_Init each
+ * time: with the 8-bit mixer, then with the 16-bit one taking the nearest
+ * sample, the box filter and the band-limited steps (POKEYSND_resample).
+ * The 8-bit mixer is timed with the box filter and the band-limited steps
+ * too.  Only the time spent in POKEYSND_Process counts.  For each the
+ * samples per second are printed, and whether every 16-bit nearest sample
+ * is the 8-bit one signed and times POKEYSND_volume, as the 16-bit mixer
+ * must give.
+ *
+ * Then the filtered output is checked against the nearest sample: the mean
+ * of every scenario must stay within DC_TOLERANCE of it, and a 125 Hz tone,
+ * far below the sample rate, must keep its amplitude within TONE_TOLERANCE.
+ * Last, the alias level of each: the power of a 2 kHz square wave at 1.79
+ * MHz that falls off its harmonics, relative to all of it.
+ *
+ * -stereo, in a core built with -DSTEREO_SOUND=ON, runs the scenarios on two
+ * POKEYs, the second one some writes behind and on the right channel, so
+ * that the outputs compared are interleaved stereo.  The tone checks stay
+ * on one POKEY.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "antic.h"
+#include "pokey.h"
+#include "pokeysnd.h"
+#include "libatari800.h"
+
+typedef struct {
+	const char *name;
+	int writes;		/* register updates per second */
+	void (*step)(int i, ULONG *seed);
+} scenario_t;
+
+/* 1, or 2 for the second POKEY on the right (-stereo) */
+static int pokeys = 1;
+/* the POKEY the scenario writes to */
+static UWORD chip = 0;
+
+static void put(UWORD addr, UBYTE byte)
+{
+	POKEY_PutByte(chip + addr, byte);
+}
+
+static const UBYTE notes[16] = {
+	0x79, 0x6c, 0x60, 0x5b, 0x51, 0x48, 0x40, 0x3c,
+	0x35, 0x2f, 0x2d, 0x28, 0x23, 0x1f, 0x1d, 0x1a
+};
+
+static void silence(int i, ULONG *seed)
+{
+	int c;
+	for (c = 0; c < 4; c++)
+		put(POKEY_OFFSET_AUDC1 + 2 * c, 0);
+}
+
+/* three pure tones, a new note every frame */
+static void tones(int i, ULONG *seed)
+{
+	int c;
+	put(POKEY_OFFSET_AUDCTL, 0);
+	for (c = 0; c < 3; c++) {
+		put(POKEY_OFFSET_AUDF1 + 2 * c, notes[(i / (4 << c) + 5 * c) & 15]);
+		put(POKEY_OFFSET_AUDC1 + 2 * c, 0xa4 + 2 * c);
+	}
+	put(POKEY_OFFSET_AUDC4, 0);
+}
+
+/* every polynomial, poly9 and poly17 by turns */
+static void noise(int i, ULONG *seed)
+{
+	put(POKEY_OFFSET_AUDCTL, (i / 60) & 1 ? POKEY_POLY9 : 0);
+	put(POKEY_OFFSET_AUDF1, i & 0x3f);
+	put(POKEY_OFFSET_AUDC1, 0x08);
+	put(POKEY_OFFSET_AUDF2, notes[i & 15]);
+	put(POKEY_OFFSET_AUDC2, 0x26);
+	put(POKEY_OFFSET_AUDF3, notes[(i >> 2) & 15]);
+	put(POKEY_OFFSET_AUDC3, 0x46);
+	put(POKEY_OFFSET_AUDF4, 0x20 + (i & 0x1f));
+	put(POKEY_OFFSET_AUDC4, 0xc4);
+}
+
+/* channel 1 at 1.79 MHz filtered by channel 3, 3 and 4 joined */
+static void filters(int i, ULONG *seed)
+{
+	UWORD period = 0x400 + 0x10 * (i & 0x3f);
+	put(POKEY_OFFSET_AUDCTL, POKEY_CH1_179 | POKEY_CH3_179 | POKEY_CH3_CH4 | POKEY_CH1_FILTER);
+	put(POKEY_OFFSET_AUDF1, 0x80 + notes[i & 15]);
+	put(POKEY_OFFSET_AUDC1, 0xa8);
+	put(POKEY_OFFSET_AUDF2, notes[(i >> 3) & 15]);
+	put(POKEY_OFFSET_AUDC2, 0xa6);
+	put(POKEY_OFFSET_AUDF3, period & 0xff);
+	put(POKEY_OFFSET_AUDF4, period >> 8);
+	put(POKEY_OFFSET_AUDC3, 0);
+	put(POKEY_OFFSET_AUDC4, 0xa6);
+}
+
+/* 4-bit samples through volume-only channel 1 */
+static void digi(int i, ULONG *seed)
+{
+	static const UBYTE wave[16] = { 8, 11, 13, 14, 15, 14, 13, 11, 8, 5, 3, 2, 1, 2, 3, 5 };
+	put(POKEY_OFFSET_AUDC1, POKEY_VOL_ONLY | wave[i & 15]);
+}
+
+/* any value in any register */
+static void random_writes(int i, ULONG *seed)
+{
+	int r;
+	for (r = POKEY_OFFSET_AUDF1; r <= POKEY_OFFSET_AUDCTL; r++) {
+		*seed = *seed * 1103515245 + 12345;
+		put(r, (UBYTE) (*seed >> 16));
+	}
+}
+
+/* channel 1 at 64 kHz, 63921 / 2 / 256 = 124.8 Hz */
+static void low_tone(int i, ULONG *seed)
+{
+	put(POKEY_OFFSET_AUDCTL, 0);
+	put(POKEY_OFFSET_AUDF1, 0xff);
+	put(POKEY_OFFSET_AUDC1, 0xa8);
+}
+
+/* channels 1 and 2 joined at 1.79 MHz, 1789790 / 2 / (HIGH_TONE + 7) Hz */
+#define HIGH_TONE 420
+static void high_tone(int i, ULONG *seed)
+{
+	put(POKEY_OFFSET_AUDCTL, POKEY_CH1_179 | POKEY_CH1_CH2);
+	put(POKEY_OFFSET_AUDF1, HIGH_TONE & 0xff);
+	put(POKEY_OFFSET_AUDF2, HIGH_TONE >> 8);
+	put(POKEY_OFFSET_AUDC1, 0);
+	put(POKEY_OFFSET_AUDC2, 0xa8);
+}
+
+static const scenario_t scenarios[] = {
+	{ "silence", 60, silence },
+	{ "tones", 60, tones },
+	{ "noise", 60, noise },
+	{ "filters", 60, filters },
+	{ "digi", 7860, digi },
+	{ "random", 240, random_writes }
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* Renders SAMPLES frames of scenario SC into BUFFER with the mixer of FLAGS
+   and RESAMPLE and returns the seconds spent in POKEYSND_Process */
+static double run(const scenario_t *sc, int rate, int flags, int resample, void *buffer, long samples)
+{
+	unsigned int clock = ANTIC_screenline_cpu_clock;
+	int size = flags & POKEYSND_BIT16 ? 2 : 1;
+	int chunk = rate / sc->writes;
+	ULONG seed = 1;
+	double secs = 0;
+	long done;
+	int i;
+
+	POKEYSND_resample = resample;
+#ifdef STEREO_SOUND
+	POKEYSND_stereo_enabled = pokeys == 2;
+#endif
+	POKEYSND_Init(POKEYSND_FREQ_17_EXACT, rate, pokeys, flags);
+	for (chip = 0; chip < pokeys * POKEY_OFFSET_POKEY2; chip += POKEY_OFFSET_POKEY2)
+		for (i = POKEY_OFFSET_AUDF1; i <= POKEY_OFFSET_AUDCTL; i++)
+			put(i, 0);
+	for (done = 0, i = 0; done < samples; done += chunk, i++) {
+		int n = samples - done < chunk ? samples - done : chunk;
+		double t;
+		chip = 0;
+		sc->step(i, &seed);
+		if (pokeys == 2) {
+			chip = POKEY_OFFSET_POKEY2;
+			sc->step(i + 7, &seed);
+		}
+		t = now();
+		POKEYSND_Process((UBYTE *) buffer + done * size * pokeys, n * pokeys);
+		secs += now() - t;
+		/* volume-only writes are placed by the CPU clock */
+		ANTIC_screenline_cpu_clock += POKEYSND_FREQ_17_EXACT / sc->writes;
+	}
+	ANTIC_screenline_cpu_clock = clock;
+	POKEYSND_resample = POKEYSND_RESAMPLE_NEAREST;
+	return secs;
+}
+
+/* The mean of N samples of size SIZE, as 16-bit signed samples */
+static double mean(const void *buffer, int size, long n)
+{
+	double sum = 0;
+	long k;
+	for (k = 0; k < n; k++)
+		sum += size == 2 ? ((const SWORD *) buffer)[k] : (((const UBYTE *) buffer)[k] - 0x80) * POKEYSND_volume;
+	return sum / n;
+}
+
+/* in place radix-2 FFT of N complex values, N a power of 2 */
+static void fft(double *re, double *im, int n)
+{
+	const double pi = 3.14159265358979323846;
+	int i, j, k, len;
+
+	for (i = 1, j = 0; i < n; i++) {
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j) {
+			double t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+	for (len = 2; len <= n; len <<= 1)
+		for (k = 0; k < len / 2; k++) {
+			double wr = cos(-2 * pi * k / len);
+			double wi = sin(-2 * pi * k / len);
+			for (i = k; i < n; i += len) {
+				int m = i + len / 2;
+				double tr = re[m] * wr - im[m] * wi;
+				double ti = re[m] * wi + im[m] * wr;
+				re[m] = re[i] - tr;
+				im[m] = im[i] - ti;
+				re[i] += tr;
+				im[i] += ti;
+			}
+		}
+}
+
+#define FFT_SIZE 32768
+#define FFT_GUARD 4		/* bins either side of a line, for the window */
+#define DC_TOLERANCE 64
+#define TONE_TOLERANCE 0.02
+
+/* The power spectrum of FFT_SIZE samples of X, Hann windowed, in POWER */
+static void spectrum(const SWORD *x, double *power)
+{
+	static double re[FFT_SIZE], im[FFT_SIZE];
+	const double pi = 3.14159265358979323846;
+	int k;
+
+	for (k = 0; k < FFT_SIZE; k++) {
+		re[k] = x[k] * (0.5 - 0.5 * cos(2 * pi * k / FFT_SIZE));
+		im[k] = 0;
+	}
+	fft(re, im, FFT_SIZE);
+	for (k = 0; k <= FFT_SIZE / 2; k++)
+		power[k] = re[k] * re[k] + im[k] * im[k];
+}
+
+/* The power of POWER within FFT_GUARD bins of F Hz, at RATE */
+static double line_power(const double *power, double f, int rate)
+{
+	int c = (int) (f * FFT_SIZE / rate + 0.5);
+	double sum = 0;
+	int k;
+	for (k = c - FFT_GUARD; k <= c + FFT_GUARD; k++)
+		if (k > 0 && k <= FFT_SIZE / 2)
+			sum += power[k];
+	return sum;
+}
+
+/* The share of the power of POWER, leaving out DC, that is not on a
+   harmonic of F Hz below RATE / 2, in dB */
+static double alias_db(const double *power, double f, int rate)
+{
+	double total = 0, on = 0;
+	int h, k;
+	for (k = FFT_GUARD + 1; k <= FFT_SIZE / 2; k++)
+		total += power[k];
+	for (h = 1; h * f < rate / 2.0; h++)
+		on += line_power(power, h * f, rate);
+	return 10 * log10((total - on) / total);
+}
+
+/* Renders scenario SC with RESAMPLE into BUFFER, a quarter second for the
+   output filter to settle and then FFT_SIZE samples, and leaves the power
+   spectrum of these in POWER */
+static void tone_spectrum(const scenario_t *sc, int rate, int resample, SWORD *buffer, double *power)
+{
+	run(sc, rate, POKEYSND_BIT16, resample, buffer, rate / 4 + FFT_SIZE);
+	spectrum(buffer + rate / 4, power);
+}
+
+int main(int argc, char **argv)
+{
+	int seconds = 60;
+	int rate = 15720;
+	int volume = -1;
+	static const scenario_t low = { "low tone", 60, low_tone };
+	static const scenario_t high = { "high tone", 60, high_tone };
+	static const char *const resample_names[3] = { "nearest", "box", "blep" };
+	static double power[FFT_SIZE / 2 + 1];
+	double dc[sizeof(scenarios) / sizeof(scenarios[0])][4];
+	double low_power[3];
+	long samples, total;
+	UBYTE *out8;
+	SWORD *out16;
+	int ok = TRUE;
+	int i, j;
+
+	for (i = j = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc)
+			seconds = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-rate") == 0 && i + 1 < argc)
+			rate = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-volume") == 0 && i + 1 < argc)
+			volume = atoi(argv[++i]);
+#ifdef STEREO_SOUND
+		else if (strcmp(argv[i], "-stereo") == 0)
+			pokeys = 2;
+#endif
+		else
+			argv[j++] = argv[i];
+	}
+	argv[j] = NULL;
+
+	if (!libatari800_init(j, argv)) {
+		fprintf(stderr, "pokey_bench: libatari800_init failed\n");
+		return 1;
+	}
+	if (volume >= 0)
+		POKEYSND_SetVolume(volume);
+	samples = (long) seconds * rate;
+	if (samples < rate / 4 + FFT_SIZE)
+		samples = rate / 4 + FFT_SIZE;
+	total = samples * pokeys;
+	out8 = malloc(total);
+	out16 = malloc(total * sizeof(SWORD));
+	if (out8 == NULL || out16 == NULL) {
+		fprintf(stderr, "pokey_bench: out of memory\n");
+		return 1;
+	}
+
+	printf("%d s at %d Hz, volume 0x%x%s\n", seconds, rate, POKEYSND_volume, pokeys == 2 ? ", stereo" : "");
+	printf("%-8s  %-59s  %-13s  %s\n", "", "Msamples/s", "cost / 16-bit", "16-bit =");
+	printf("%-8s  %8s  %8s  %8s  %8s  %8s  %8s  %6s  %6s  %s\n", "", "8-bit", "8 box", "8 blep",
+	       "16-bit", "box", "blep", "box", "blep", "8-bit * volume");
+	for (i = 0; i < (int) (sizeof(scenarios) / sizeof(scenarios[0])); i++) {
+		const scenario_t *sc = &scenarios[i];
+		double t8box = run(sc, rate, 0, POKEYSND_RESAMPLE_BOX, out8, samples);
+		double t8blep, tbox, tblep, t16, t8;
+		long k;
+
+		dc[i][0] = mean(out8, 1, total);
+		t8blep = run(sc, rate, 0, POKEYSND_RESAMPLE_BLEP, out8, samples);
+		dc[i][1] = mean(out8, 1, total);
+		tbox = run(sc, rate, POKEYSND_BIT16, POKEYSND_RESAMPLE_BOX, out16, samples);
+		dc[i][2] = mean(out16, 2, total);
+		tblep = run(sc, rate, POKEYSND_BIT16, POKEYSND_RESAMPLE_BLEP, out16, samples);
+		dc[i][3] = mean(out16, 2, total);
+		t8 = run(sc, rate, 0, POKEYSND_RESAMPLE_NEAREST, out8, samples);
+		t16 = run(sc, rate, POKEYSND_BIT16, POKEYSND_RESAMPLE_NEAREST, out16, samples);
+
+		for (k = 0; k < total; k++) {
+			int v = (out8[k] - 0x80) * POKEYSND_volume;
+			if (out16[k] != (v > 32767 ? 32767 : v < -32768 ? -32768 : v))
+				break;
+		}
+		printf("%-8s  %8.2f  %8.2f  %8.2f  %8.2f  %8.2f  %8.2f  %5.2fx  %5.2fx  ", sc->name,
+		       total / t8 * 1e-6, total / t8box * 1e-6, total / t8blep * 1e-6,
+		       total / t16 * 1e-6, total / tbox * 1e-6, total / tblep * 1e-6,
+		       tbox / t16, tblep / t16);
+		if (k == total)
+			printf("yes\n");
+		else {
+			printf("no, from sample %ld\n", k);
+			ok = FALSE;
+		}
+		/* against the nearest sample */
+		for (k = 0; k < 4; k++)
+			dc[i][k] -= mean(out16, 2, total);
+	}
+
+	printf("\nmean - nearest mean, within %d\n", DC_TOLERANCE);
+	printf("%-8s  %8s  %8s  %8s  %8s\n", "", "8 box", "8 blep", "box", "blep");
+	for (i = 0; i < (int) (sizeof(scenarios) / sizeof(scenarios[0])); i++) {
+		printf("%-8s", scenarios[i].name);
+		for (j = 0; j < 4; j++) {
+			printf("  %8.1f", dc[i][j]);
+			if (fabs(dc[i][j]) > DC_TOLERANCE)
+				ok = FALSE;
+		}
+		printf("\n");
+	}
+
+	/* the tones on one POKEY */
+	pokeys = 1;
+	for (i = 0; i < 3; i++) {
+		tone_spectrum(&low, rate, i, out16, power);
+		low_power[i] = line_power(power, 63921.0 / 2 / 256, rate);
+	}
+	printf("\n124.8 Hz tone amplitude / nearest, within %g:", TONE_TOLERANCE);
+	for (i = 1; i < 3; i++) {
+		double a = sqrt(low_power[i] / low_power[0]);
+		printf(" %s %.4f", resample_names[i], a);
+		if (fabs(a - 1) > TONE_TOLERANCE)
+			ok = FALSE;
+	}
+	printf("\n%.1f Hz square wave, power off its harmonics:",
+	       POKEYSND_FREQ_17_EXACT / 2.0 / (HIGH_TONE + 7));
+	for (i = 0; i < 3; i++) {
+		tone_spectrum(&high, rate, i, out16, power);
+		printf(" %s %.1f dB", resample_names[i],
+		       alias_db(power, POKEYSND_FREQ_17_EXACT / 2.0 / (HIGH_TONE + 7), rate));
+	}
+	printf("\n%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+	return ok ? 0 : 1;
+}
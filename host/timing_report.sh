@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Compatibility and speed of the cycle-exact display timing.
+#
+# Usage: host/timing_report.sh BENCH FRAMES IMAGE...
+#
+#   host/timing_report.sh build-host/bench 3000 data/atari800/*.xex
+#
+# BENCH must come from a host build configured with -DCYCLE_EXACT=ON.
+#
+# Runs every image for FRAMES frames with the scanline and the cycle-exact
+# timing (bench -cycle-exact off/on) and prints one row per image: the
+# CRC32 that keys the title table in libatari800_main.c, frames per second
+# of both runs and whether the final screen and memory agree.  Images that
+# render differently are candidates for the title table, once the cycle maps
+# are checked and the cycle-exact screen is shown to be the right one; a run
+# that stops early is marked "stop".  Extra bench options go in BENCH_ARGS (default
+# -xl).
+
+bench=$1
+frames=$2
+shift 2
+
+field() {
+	sed -n "s|^$1: *\([^ ]*\).*|\1|p"
+}
+
+printf '%-24s %-8s %9s %9s %6s %-6s %-6s\n' image title scanline exact ratio screen memory
+for image in "$@"; do
+	fast=$("$bench" -frames "$frames" -cycle-exact off ${BENCH_ARGS:--xl} "$image" 2>&1)
+	exact=$("$bench" -frames "$frames" -cycle-exact on ${BENCH_ARGS:--xl} "$image" 2>&1)
+	title=$(echo "$fast" | sed -n 's/^timing:.*(title \([0-9a-f]*\)).*/\1/p')
+	fast_fps=$(echo "$fast" | field frames/sec)
+	exact_fps=$(echo "$exact" | field frames/sec)
+	screen=same
+	memory=same
+	[ "$(echo "$fast" | field 'screen crc')" = "$(echo "$exact" | field 'screen crc')" ] || screen=differ
+	[ "$(echo "$fast" | field 'memory crc')" = "$(echo "$exact" | field 'memory crc')" ] || memory=differ
+	echo "$exact" | grep -q 'stopped at frame' && screen=stop
+	printf '%-24s %-8s %9.1f %9.1f %6.2f %-6s %-6s\n' "$(basename "$image")" "$title" \
+		"$fast_fps" "$exact_fps" "$(echo "$exact_fps $fast_fps" | awk '{ print $1 / $2 }')" "$screen" "$memory"
+done
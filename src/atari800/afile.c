@@ -39,6 +39,9 @@
 #include <zlib.h>
 #endif
 #include <stdio.h>
+#ifdef LIBATARI800
+#include "libatari800_main.h"
+#endif
 
 
 int AFILE_DetectFileType(const char *filename)
@@ -241,5 +244,9 @@ int AFILE_OpenFile(const char *filename, int reboot, int diskno, int readonly)
 	default:
 		break;
 	}
+#ifdef LIBATARI800
+	if (type != AFILE_ERROR && (reboot || diskno == 1))
+		LIBATARI800_SelectTiming(filename);
+#endif
 	return type;
 }
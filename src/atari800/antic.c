@@ -32,6 +32,7 @@
 #include "atari.h"
 #include "cpu.h"
 #include "gtia.h"
+#include "libatari800_timing.h"
 #include "log.h"
 #include "memory.h"
 #include "platform.h"
@@ -47,6 +48,17 @@
 #ifdef NEW_CYCLE_EXACT
 #include "cycle_map.h"
 #endif
+#ifdef SCANLINE_RING
+#include "scanline_ring.h"
+#endif
+#ifdef PICO_ON_DEVICE
+#include <pico/platform.h>
+#define RENDER_WAIT_IDLE() tight_loop_contents()
+#else
+#include <sched.h>
+/* the render thread may share a CPU with this one */
+#define RENDER_WAIT_IDLE() sched_yield()
+#endif
 
 #define LCHOP 3			/* do not build leftmost 0..3 characters in wide mode */
 #define RCHOP 3			/* do not build rightmost 0..3 characters in wide mode */
@@ -60,8 +72,9 @@ static void draw_partial_scanline(int l,int r);
 static void update_scanline_chbase(void);
 static void update_scanline_invert(void);
 static void update_scanline_blank(void);
-const int *ANTIC_cpu2antic_ptr;
-const int *ANTIC_antic2cpu_ptr;
+const UBYTE *ANTIC_cpu2antic_ptr;
+const UBYTE *ANTIC_antic2cpu_ptr;
+int ANTIC_cycle_exact = FALSE;
 int ANTIC_delayed_wsync = 0;
 static int dmactl_changed = 0;
 static UBYTE delayed_DMACTL;
@@ -248,6 +261,19 @@ static UBYTE antic_memory[52];
    ------------------------------------------------------------------------ */
 
 static UWORD *scrn_ptr;
+
+/* With SCANLINE_RING every finished line goes to the display and scrn_ptr
+   moves on to a free slot of the ring. */
+#ifdef SCANLINE_RING
+#define FIRST_SCRN_LINE (scrn_ptr = SCANLINE_RING_BeginFrame())
+#define NEXT_SCRN_LINE (scrn_ptr = SCANLINE_RING_NextLine())
+#else
+#define FIRST_SCRN_LINE (scrn_ptr = (UWORD *) Screen_atari)
+#define NEXT_SCRN_LINE (scrn_ptr += Screen_WIDTH / 2)
+#endif
+
+/* ANTIC_DRAW_COLLISIONS draws every line here; it is never shown */
+static ULONG collision_line[Screen_WIDTH / 4];
 #endif /* !defined(BASIC) && !defined(CURSES_BASIC) */
 
 /* Separate access to XE extended memory ----------------------------------- */
@@ -436,7 +462,7 @@ unsigned int ANTIC_screenline_cpu_clock = 0;
 	ANTIC_screenline_cpu_clock += ANTIC_LINE_C; \
 	ANTIC_ypos++; \
 	GTIA_UpdatePmplColls();
-#define GOEOL CPU_GO(ANTIC_LINE_C); ANTIC_xpos -= ANTIC_LINE_C; ANTIC_screenline_cpu_clock += ANTIC_LINE_C; UPDATE_DMACTL; ANTIC_ypos++; UPDATE_GTIA_BUG
+#define GOEOL CPU_GO(ANTIC_LINE_C); ANTIC_RENDER_SYNC; ANTIC_xpos -= ANTIC_LINE_C; ANTIC_screenline_cpu_clock += ANTIC_LINE_C; UPDATE_DMACTL; ANTIC_ypos++; UPDATE_GTIA_BUG
 #define OVERSCREEN_LINE	ANTIC_xpos += ANTIC_DMAR; GOEOL
 
 int ANTIC_xpos = 0;
@@ -1158,6 +1184,18 @@ static const UBYTE hold_missiles_tab[16] = {
 
 static void pmg_dma(void)
 {
+#ifdef MEMORY_HEATMAP
+	if (ANTIC_player_dma_enabled && ANTIC_player_gra_enabled) {
+		UWORD addr = singleline ? pmbase_s + ANTIC_ypos + 0x400 : pmbase_d + (ANTIC_ypos >> 1) + 0x200;
+		int step = singleline ? 0x100 : 0x80;
+		MEMORY_HEAT(MEMORY_HEAT_ANTIC, addr);
+		MEMORY_HEAT(MEMORY_HEAT_ANTIC, addr + step);
+		MEMORY_HEAT(MEMORY_HEAT_ANTIC, addr + 2 * step);
+		MEMORY_HEAT(MEMORY_HEAT_ANTIC, addr + 3 * step);
+	}
+	if (ANTIC_missile_dma_enabled && ANTIC_missile_gra_enabled)
+		MEMORY_HEAT(MEMORY_HEAT_ANTIC, singleline ? pmbase_s + ANTIC_ypos + 0x300 : pmbase_d + (ANTIC_ypos >> 1) + 0x180);
+#endif
 	/* VDELAY bit set == GTIA ignores PMG DMA in even lines */
 	if (ANTIC_player_dma_enabled) {
 		if (ANTIC_player_gra_enabled) {
@@ -1166,7 +1204,7 @@ static void pmg_dma(void)
 				if (ANTIC_xe_ptr != NULL && pmbase_s < 0x8000 && pmbase_s >= 0x4000)
 					base = ANTIC_xe_ptr + pmbase_s - 0x4000 + ANTIC_ypos;
 				else
-					base = MEMORY_mem + pmbase_s + ANTIC_ypos;
+					base = MEMORY_dPtr(pmbase_s + ANTIC_ypos);
 				if (ANTIC_ypos & 1) {
 					GTIA_GRAFP0 = base[0x400];
 					GTIA_GRAFP1 = base[0x500];
@@ -1188,7 +1226,7 @@ static void pmg_dma(void)
 				if (ANTIC_xe_ptr != NULL && pmbase_d < 0x8000 && pmbase_d >= 0x4000)
 					base = ANTIC_xe_ptr + (pmbase_d - 0x4000) + (ANTIC_ypos >> 1);
 				else
-					base = MEMORY_mem + pmbase_d + (ANTIC_ypos >> 1);
+					base = MEMORY_dPtr(pmbase_d + (ANTIC_ypos >> 1));
 				if (ANTIC_ypos & 1) {
 					GTIA_GRAFP0 = base[0x200];
 					GTIA_GRAFP1 = base[0x280];
@@ -1350,12 +1388,6 @@ int ANTIC_Initialise(int *argc, char *argv[])
 	mode_e_an_lookup[1] = mode_e_an_lookup[4] = mode_e_an_lookup[0x10] = mode_e_an_lookup[0x40] = 0;
 	mode_e_an_lookup[2] = mode_e_an_lookup[8] = mode_e_an_lookup[0x20] = mode_e_an_lookup[0x80] = 1;
 	mode_e_an_lookup[3] = mode_e_an_lookup[12] = mode_e_an_lookup[0x30] = mode_e_an_lookup[0xc0] = 2;
-#ifdef NEW_CYCLE_EXACT
-	CYCLE_MAP_Create();
-	ANTIC_cpu2antic_ptr = &CYCLE_MAP_cpu2antic[0];
-	ANTIC_antic2cpu_ptr = &CYCLE_MAP_antic2cpu[0];
-#endif /* NEW_CYCLE_EXACT */
-
 #endif /* !defined(BASIC) && !defined(CURSES_BASIC) */
 
 	return TRUE;
@@ -1789,10 +1821,54 @@ static void draw_an_gtia_bug(const ULONG *t_pm_scanline_ptr)
 
 #endif /* USE_COLOUR_TRANSLATION_TABLE */
 
+/* Long-at-a-time cells
+   A character cell with no players or missiles over it is drawn with two
+   long writes, each 4 pixels looked up by 4 bits of the playfield byte:
+   two colour clocks in modes 4, 5 and d-e, four hi-res pixels in modes
+   2, 3 and f.  The tables are filled from the word lookups at the start
+   of the line; entry 0 is the background.  A line that starts at an odd
+   word (horizontal scrolling) cannot be written with aligned longs and is
+   drawn a word at a time as before. */
+
+#ifdef WORDS_BIGENDIAN
+#define LONG_OF_WORDS(first, second) (((ULONG) (first) << 16) | (second))
+#else
+#define LONG_OF_WORDS(first, second) (((ULONG) (second) << 16) | (first))
+#endif
+
+#define LONG_ALIGNED(ptr) (((size_t) (ptr) & 3) == 0)
+
+static ULONG lookup4[16];
+static ULONG lookup4_inverse[16];	/* mode 4 and 5 characters with bit 7 set */
+static ULONG hires_lookup4[16];
+
+/* TABLE[a << 2 | b] is the colour clock a followed by b, COLOURS[a] and
+   COLOURS[b] */
+static void fill_lookup4(ULONG *table, UWORD c0, UWORD c1, UWORD c2, UWORD c3)
+{
+	const UWORD colours[4] = { c0, c1, c2, c3 };
+	int i;
+	for (i = 0; i < 16; i++)
+		table[i] = LONG_OF_WORDS(colours[i >> 2], colours[i & 3]);
+}
+
+#define INIT_HIRES_LOOKUP4 fill_lookup4(hires_lookup4, hires_norm(0x00), hires_norm(0x40), hires_norm(0x80), hires_norm(0xc0))
+
+#define DRAW_CELL_LOOKUP4(table, data) {\
+		WRITE_VIDEO_LONG((ULONG *) ptr, (table)[(data) >> 4]);\
+		WRITE_VIDEO_LONG((ULONG *) ptr + 1, (table)[(data) & 0xf]);\
+		ptr += 4;\
+	}
+
+/* lines of the current frame are drawn by ANTIC_RenderLine on the render
+   core, which must leave ANTIC_xpos alone; see ANTIC_Frame */
+static int render_split_frame = FALSE;
+
 #ifdef NEW_CYCLE_EXACT
-#define ADD_FONT_CYCLES
+/* draw_partial_scanline runs on the cycle maps, which include font fetches */
+#define ADD_FONT_CYCLES if (!ANTIC_cycle_exact && !render_split_frame) ANTIC_xpos += font_cycles[md]
 #else
-#define ADD_FONT_CYCLES ANTIC_xpos += font_cycles[md]
+#define ADD_FONT_CYCLES if (!render_split_frame) ANTIC_xpos += font_cycles[md]
 #endif
 
 #ifdef PAGED_MEM
@@ -1812,7 +1888,7 @@ static void draw_an_gtia_bug(const ULONG *t_pm_scanline_ptr)
 	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)\
 		chptr = ANTIC_xe_ptr + ((dctr ^ chbase_20) & 0x3c07);\
 	else\
-		chptr = MEMORY_mem + ((dctr ^ chbase_20) & 0xfc07);\
+		chptr = MEMORY_dPtr(((dctr ^ chbase_20) & 0xfc07));\
 	ADD_FONT_CYCLES;\
 	blank_lookup[0x60] = (anticmode == 2 || dctr & 0xe) ? 0xff : 0;\
 	blank_lookup[0x00] = blank_lookup[0x20] = blank_lookup[0x40] = (dctr & 0xe) == 8 ? 0 : 0xff;
@@ -1823,11 +1899,15 @@ static void draw_an_gtia_bug(const ULONG *t_pm_scanline_ptr)
 
 #endif /* PAGED_MEM */
 
+/* also draws mode 3: INIT_ANTIC_2 blanks the rows around its descenders
+   through blank_lookup, so its cells take the same long-write path */
 static void draw_antic_2(int nchars, const UBYTE *antic_memptr, UWORD *ptr, const ULONG *t_pm_scanline_ptr)
 {
 	INIT_BACKGROUND_6
+	int aligned = LONG_ALIGNED(ptr);
 	INIT_ANTIC_2
 	INIT_HIRES
+	INIT_HIRES_LOOKUP4;
 
 	CHAR_LOOP_BEGIN
 		UBYTE screendata = *antic_memptr++;
@@ -1835,7 +1915,9 @@ static void draw_antic_2(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 
 		GET_CHDATA_ANTIC_2
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
-			if (chdata) {
+			if (aligned)
+				DRAW_CELL_LOOKUP4(hires_lookup4, chdata)
+			else if (chdata) {
 				WRITE_VIDEO(ptr++, hires_norm(chdata & 0xc0));
 				WRITE_VIDEO(ptr++, hires_norm(chdata & 0x30));
 				WRITE_VIDEO(ptr++, hires_norm(chdata & 0x0c));
@@ -1969,7 +2051,7 @@ static void prepare_an_antic_2(int nchars, const UBYTE *antic_memptr, const ULON
 	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
 		chptr = ANTIC_xe_ptr + ((dctr ^ chbase_20) & 0x3c07);
 	else
-		chptr = MEMORY_mem + ((dctr ^ chbase_20) & 0xfc07);
+		chptr = MEMORY_dPtr(((dctr ^ chbase_20) & 0xfc07));
 #endif
 
 	CHAR_LOOP_BEGIN
@@ -2151,6 +2233,7 @@ static void draw_antic_2_gtia_bug(int nchars, const UBYTE *antic_memptr, UWORD *
 static void draw_antic_4(int nchars, const UBYTE *antic_memptr, UWORD *ptr, const ULONG *t_pm_scanline_ptr)
 {
 	INIT_BACKGROUND_8
+	int aligned = LONG_ALIGNED(ptr);
 #ifdef PAGED_MEM
 	UWORD t_chbase = ((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0xfc07;
 #else
@@ -2158,7 +2241,7 @@ static void draw_antic_4(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
 		chptr = ANTIC_xe_ptr + (((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0x3c07);
 	else
-		chptr = MEMORY_mem + (((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0xfc07);
+		chptr = MEMORY_dPtr((((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0xfc07));
 #endif
 
 	ADD_FONT_CYCLES;
@@ -2169,6 +2252,8 @@ static void draw_antic_4(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	lookup2[0x80] = lookup2[0x20] = lookup2[0x08] = lookup2[0x02] = ANTIC_cl[C_PF1];
 	lookup2[0xc0] = lookup2[0x30] = lookup2[0x0c] = lookup2[0x03] = ANTIC_cl[C_PF2];
 	lookup2[0xcf] = lookup2[0x3f] = lookup2[0x1b] = lookup2[0x12] = ANTIC_cl[C_PF3];
+	fill_lookup4(lookup4, ANTIC_cl[C_BAK], ANTIC_cl[C_PF0], ANTIC_cl[C_PF1], ANTIC_cl[C_PF2]);
+	fill_lookup4(lookup4_inverse, ANTIC_cl[C_BAK], ANTIC_cl[C_PF0], ANTIC_cl[C_PF1], ANTIC_cl[C_PF3]);
 
 	CHAR_LOOP_BEGIN
 		UBYTE screendata = *antic_memptr++;
@@ -2184,7 +2269,9 @@ static void draw_antic_4(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 		chdata = chptr[(screendata & 0x7f) << 3];
 #endif
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
-			if (chdata) {
+			if (aligned)
+				DRAW_CELL_LOOKUP4(screendata & 0x80 ? lookup4_inverse : lookup4, chdata)
+			else if (chdata) {
 				WRITE_VIDEO(ptr++, lookup[chdata & 0xc0]);
 				WRITE_VIDEO(ptr++, lookup[chdata & 0x30]);
 				WRITE_VIDEO(ptr++, lookup[chdata & 0x0c]);
@@ -2221,7 +2308,7 @@ static void prepare_an_antic_4(int nchars, const UBYTE *antic_memptr, const ULON
 	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
 		chptr = ANTIC_xe_ptr + (((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0x3c07);
 	else
-		chptr = MEMORY_mem + (((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0xfc07);
+		chptr = MEMORY_dPtr((((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0xfc07));
 #endif
 
 	ADD_FONT_CYCLES;
@@ -2256,7 +2343,7 @@ static void draw_antic_6(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
 		chptr = ANTIC_xe_ptr + (((anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20) - 0x4000);
 	else
-		chptr = MEMORY_mem + ((anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20);
+		chptr = MEMORY_dPtr(((anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20));
 #endif
 
 	ADD_FONT_CYCLES;
@@ -2336,7 +2423,7 @@ static void prepare_an_antic_6(int nchars, const UBYTE *antic_memptr, const ULON
 	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
 		chptr = ANTIC_xe_ptr + (((anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20) - 0x4000);
 	else
-		chptr = MEMORY_mem + ((anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20);
+		chptr = MEMORY_dPtr(((anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20));
 #endif
 
 	ADD_FONT_CYCLES;
@@ -2560,15 +2647,19 @@ static void draw_antic_c(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 static void draw_antic_e(int nchars, const UBYTE *antic_memptr, UWORD *ptr, const ULONG *t_pm_scanline_ptr)
 {
 	INIT_BACKGROUND_8
+	int aligned = LONG_ALIGNED(ptr);
 	lookup2[0x00] = ANTIC_cl[C_BAK];
 	lookup2[0x40] = lookup2[0x10] = lookup2[0x04] = lookup2[0x01] = ANTIC_cl[C_PF0];
 	lookup2[0x80] = lookup2[0x20] = lookup2[0x08] = lookup2[0x02] = ANTIC_cl[C_PF1];
 	lookup2[0xc0] = lookup2[0x30] = lookup2[0x0c] = lookup2[0x03] = ANTIC_cl[C_PF2];
+	fill_lookup4(lookup4, ANTIC_cl[C_BAK], ANTIC_cl[C_PF0], ANTIC_cl[C_PF1], ANTIC_cl[C_PF2]);
 
 	CHAR_LOOP_BEGIN
 		UBYTE screendata = *antic_memptr++;
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
-			if (screendata) {
+			if (aligned)
+				DRAW_CELL_LOOKUP4(lookup4, screendata)
+			else if (screendata) {
 				WRITE_VIDEO(ptr++, lookup2[screendata & 0xc0]);
 				WRITE_VIDEO(ptr++, lookup2[screendata & 0x30]);
 				WRITE_VIDEO(ptr++, lookup2[screendata & 0x0c]);
@@ -2671,12 +2762,16 @@ static void draw_antic_e_gtia11 (int nchars, const UBYTE *antic_memptr, UWORD *p
 static void draw_antic_f(int nchars, const UBYTE *antic_memptr, UWORD *ptr, const ULONG *t_pm_scanline_ptr)
 {
 	INIT_BACKGROUND_6
+	int aligned = LONG_ALIGNED(ptr);
 	INIT_HIRES
+	INIT_HIRES_LOOKUP4;
 
 	CHAR_LOOP_BEGIN
 		int screendata = *antic_memptr++;
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
-			if (screendata) {
+			if (aligned)
+				DRAW_CELL_LOOKUP4(hires_lookup4, screendata)
+			else if (screendata) {
 				WRITE_VIDEO(ptr++, hires_norm(screendata & 0xc0));
 				WRITE_VIDEO(ptr++, hires_norm(screendata & 0x30));
 				WRITE_VIDEO(ptr++, hires_norm(screendata & 0x0c));
@@ -3110,6 +3205,218 @@ void ANTIC_UpdateArtifacting(void)
 	}
 }
 #endif
+
+/* Render split ------------------------------------------------------------ */
+
+/* In the scanline timing ANTIC_Frame draws a whole line at SCR_C and then
+   runs the CPU to the end of the line.  With ANTIC_render_split it hands the
+   line to the render core instead and runs the CPU at once, so that the line
+   is drawn while the CPU runs.  One line is in flight at a time: whatever the
+   drawing depends on or produces - GTIA and ANTIC registers, collisions, the
+   PORTB and cartridge banks, the screen pointer at the end of the line - is
+   only touched after ANTIC_RENDER_SYNC has waited for the line to be done.
+   The line's screen data is already in antic_memory; font bytes the CPU
+   writes while the line is drawn may or may not be in it. */
+
+int ANTIC_render_split = FALSE;
+volatile int ANTIC_render_busy = FALSE;
+
+static struct {
+	draw_antic_function draw;	/* NULL: draw_antic_0 variant in draw_0 */
+	void (*draw_0)(void);
+	int nchars;
+	const UBYTE *antic_memptr;
+	UWORD *ptr;
+	const ULONG *t_pm_scanline_ptr;
+} render_line;
+
+static unsigned long long render_lines = 0;
+static unsigned long long render_waits = 0;
+
+static void render_submit(draw_antic_function draw, int nchars, const UBYTE *antic_memptr,
+                          UWORD *ptr, const ULONG *t_pm_scanline_ptr)
+{
+	render_line.draw = draw;
+	render_line.draw_0 = draw_antic_0_ptr;
+	render_line.nchars = nchars;
+	render_line.antic_memptr = antic_memptr;
+	render_line.ptr = ptr;
+	render_line.t_pm_scanline_ptr = t_pm_scanline_ptr;
+	render_lines++;
+	/* the render core must see the line before the flag */
+	__sync_synchronize();
+	ANTIC_render_busy = TRUE;
+}
+
+int ANTIC_RenderLine(void)
+{
+	if (!ANTIC_render_busy)
+		return FALSE;
+	__sync_synchronize();
+	if (render_line.draw != NULL)
+		render_line.draw(render_line.nchars, render_line.antic_memptr, render_line.ptr, render_line.t_pm_scanline_ptr);
+	else
+		render_line.draw_0();
+	/* pixels and collisions before the flag */
+	__sync_synchronize();
+	ANTIC_render_busy = FALSE;
+	return TRUE;
+}
+
+void ANTIC_RenderWait(void)
+{
+	render_waits++;
+	while (ANTIC_render_busy)
+		RENDER_WAIT_IDLE();
+	__sync_synchronize();
+}
+
+#ifdef LIBATARI800
+void ANTIC_GetRenderStats(render_split_stats_t *stats)
+{
+	stats->lines = render_lines;
+	stats->waits = render_waits;
+}
+
+void ANTIC_ResetRenderStats(void)
+{
+	render_lines = 0;
+	render_waits = 0;
+}
+#endif /* LIBATARI800 */
+
+/* Line cache -------------------------------------------------------------- */
+
+/* With ANTIC_line_cache set, every line the scanline timing draws gets a
+   signature: a hash of all it is drawn from - the renderer, the mode, scroll
+   and width, the delta counter, CHACTL and CHBASE, the screen data in
+   antic_memory, the character set and the colour and PRIOR registers.  A
+   line whose signature is the one it had when it was last drawn is still
+   right in Screen_atari and is not drawn again.  Lines with players or
+   missiles are always drawn, because the drawing detects the collisions.
+   The character set is hashed when a frame first uses it, so font writes in
+   the middle of a frame are only seen from the next frame on. */
+
+int ANTIC_line_cache = FALSE;
+UBYTE ANTIC_dirty_lines[Screen_HEIGHT];
+
+/* 0: unknown, else the signature of what the line holds, with bit 0 set */
+static ULONG line_sig[Screen_HEIGHT];
+static ULONG row_sig;			/* of antic_memory, after each antic_load */
+static ULONG line_cache_frames = 0;
+static unsigned long long line_cache_drawn = 0;
+static unsigned long long line_cache_skipped = 0;
+
+/* font signatures by CHBASE page: the character set hashed, the frame it
+   was hashed in and the signature, so that a display list switching
+   between a few fonts hashes each of them once a frame */
+static struct {
+	const UBYTE *ptr;
+	ULONG frame;
+	ULONG value;
+} font_sig[0x40];
+
+#define LINE_SIG_MIX(h, x) ((h) = ((h) ^ (ULONG) (x)) * 0x01000193)
+
+static ULONG line_sig_bytes(ULONG h, const UBYTE *p, int n)
+{
+	while (--n >= 0)
+		LINE_SIG_MIX(h, *p++);
+	return h;
+}
+
+static ULONG line_sig_font(void)
+{
+	/* 1 KB of font for modes 2-5 covers the 512 bytes of modes 6-7 */
+	const UBYTE *ptr;
+	int page;
+	if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
+		ptr = ANTIC_xe_ptr + (chbase_20 & 0x3c00);
+	else
+		ptr = MEMORY_dPtr(chbase_20 & 0xfc00);
+	page = chbase_20 >> 10;
+	if (ptr != font_sig[page].ptr || font_sig[page].frame != line_cache_frames) {
+		font_sig[page].ptr = ptr;
+		font_sig[page].frame = line_cache_frames;
+		font_sig[page].value = line_sig_bytes(0x811c9dc5, ptr, 0x400);
+	}
+	return font_sig[page].value;
+}
+
+static ULONG line_sig_colours(ULONG h)
+{
+	LINE_SIG_MIX(h, GTIA_COLBK | GTIA_COLPF0 << 8 | GTIA_COLPF1 << 16 | (ULONG) GTIA_COLPF2 << 24);
+	LINE_SIG_MIX(h, GTIA_COLPF3 | GTIA_PRIOR << 8);
+	/* GTIA mode 10 and the fifth player show the P/M colours */
+	LINE_SIG_MIX(h, GTIA_COLPM0 | GTIA_COLPM1 << 8 | GTIA_COLPM2 << 16 | (ULONG) GTIA_COLPM3 << 24);
+	return h;
+}
+
+/* TRUE if the line at ANTIC_ypos, of signature SIG, need not be drawn */
+static int line_cache_skip(ULONG sig)
+{
+	int y = ANTIC_ypos - 8;
+	if (GTIA_pm_dirty)
+		sig = 0;
+	else {
+		sig |= 1;
+		if (line_sig[y] == sig) {
+			line_cache_skipped++;
+			return TRUE;
+		}
+	}
+	line_sig[y] = sig;
+	ANTIC_dirty_lines[y] = TRUE;
+	line_cache_drawn++;
+	return FALSE;
+}
+
+static int blank_line_cache_skip(void)
+{
+	return line_cache_skip(line_sig_colours(0x811c9dc5 ^ (ULONG) (size_t) draw_antic_0_ptr));
+}
+
+static int mode_line_cache_skip(void)
+{
+	ULONG h = row_sig;
+	LINE_SIG_MIX(h, (size_t) draw_antic_ptr);
+	LINE_SIG_MIX(h, dctr | anticmode << 4 | md << 8 | (ANTIC_DMACTL & 3) << 12);
+	LINE_SIG_MIX(h, x_min[md] | chars_displayed[md] << 10 | ch_offset[md] << 20);
+	LINE_SIG_MIX(h, left_border_chars | right_border_start << 10);
+	LINE_SIG_MIX(h, chbase_20 | invert_mask << 16 | (ULONG) blank_mask << 24);
+	if (anticmode <= 7)
+		LINE_SIG_MIX(h, line_sig_font());
+	return line_cache_skip(line_sig_colours(h));
+}
+
+void ANTIC_ForgetLines(int y, int n)
+{
+	if (y < 0) {
+		n += y;
+		y = 0;
+	}
+	if (y + n > Screen_HEIGHT)
+		n = Screen_HEIGHT - y;
+	if (n > 0) {
+		memset(line_sig + y, 0, n * sizeof(ULONG));
+		memset(ANTIC_dirty_lines + y, TRUE, n);
+	}
+}
+
+#ifdef LIBATARI800
+void ANTIC_GetLineCacheStats(line_cache_stats_t *stats)
+{
+	stats->drawn = line_cache_drawn;
+	stats->skipped = line_cache_skipped;
+}
+
+void ANTIC_ResetLineCacheStats(void)
+{
+	line_cache_drawn = 0;
+	line_cache_skipped = 0;
+}
+#endif /* LIBATARI800 */
+
 #endif /* !defined(BASIC) && !defined(CURSES_BASIC) */
 
 /* Display List ------------------------------------------------------------ */
@@ -3118,6 +3425,7 @@ UBYTE ANTIC_GetDLByte(UWORD *paddr)
 {
 	int addr = *paddr;
 	UBYTE result;
+	MEMORY_HEAT(MEMORY_HEAT_ANTIC, addr);
 	if (ANTIC_xe_ptr != NULL && addr < 0x8000 && addr >= 0x4000)
 		result = ANTIC_xe_ptr[addr - 0x4000];
 	else
@@ -3141,10 +3449,28 @@ UWORD ANTIC_GetDLWord(UWORD *paddr)
 
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 
+#ifdef MEMORY_HEATMAP
+/* Counts the character set reads of a scanline of modes 2-7: one per
+   character shown, in the page that holds its cell. */
+static void heat_font(void)
+{
+	const UBYTE *antic_memptr = antic_memory + ANTIC_margin + ch_offset[md];
+	UWORD base = chbase_20 & (anticmode <= 5 ? 0xfc00 : 0xfe00);
+	UBYTE mask = anticmode <= 5 ? 0x7f : 0x3f;
+	int i;
+	for (i = 0; i < chars_displayed[md]; i++)
+		MEMORY_HEAT(MEMORY_HEAT_ANTIC, base + ((antic_memptr[i] & mask) << 3));
+}
+#define HEAT_FONT do { if (anticmode < 8) heat_font(); } while (0)
+#else
+#define HEAT_FONT do {} while (0)
+#endif /* MEMORY_HEATMAP */
+
 /* Real ANTIC doesn't fetch beginning bytes in HSC
    nor screen+47 in wide playfield. This function does. */
 static void antic_load(void)
 {
+	MEMORY_HeatSpan(MEMORY_HEAT_ANTIC, screenaddr, chars_read[md]);
 #ifdef PAGED_MEM
 	UBYTE *antic_memptr = antic_memory + ANTIC_margin;
 	UWORD new_screenaddr = screenaddr + chars_read[md];
@@ -3199,6 +3525,14 @@ static int scanlines_to_curses_display = 0;
 #endif
 
 /* This function emulates one frame drawing screen at Screen_atari */
+/* The font cycles of a line that is not drawn here: what ADD_FONT_CYCLES
+   would have added.  The GTIA bug routine for modes 2 and 3 adds none. */
+static void add_line_font_cycles(void)
+{
+	if (anticmode < 8 && draw_antic_ptr != draw_antic_2_gtia_bug)
+		ANTIC_xpos += font_cycles[md];
+}
+
 void ANTIC_Frame(int draw_display)
 {
 	static const UBYTE mode_type[32] = {
@@ -3211,6 +3545,9 @@ void ANTIC_Frame(int draw_display)
 		{ 0, 0, 7, 9, 7, 15, 7, 15, 7, 3, 3, 1, 0, 1, 0, 0 };
 	UBYTE vscrol_flag = FALSE;
 	UBYTE no_jvb = TRUE;
+	/* a line without players or missiles has no collisions to draw */
+	int collisions_only = draw_display == ANTIC_DRAW_COLLISIONS;
+	int line_cache_frame;
 #ifndef NEW_CYCLE_EXACT
 	UBYTE need_load;
 #endif
@@ -3219,13 +3556,42 @@ void ANTIC_Frame(int draw_display)
 	int cpu2antic_index;
 #endif /* NEW_CYCLE_EXACT */
 
+#ifdef NEW_CYCLE_EXACT
+	/* the cycle-exact timing draws the whole screen */
+	if (ANTIC_cycle_exact)
+		collisions_only = FALSE;
+	render_split_frame = ANTIC_render_split && draw_display && !collisions_only && !ANTIC_cycle_exact;
+#else
+	render_split_frame = ANTIC_render_split && draw_display && !collisions_only;
+#endif
+	/* lines left by the ring or blended with the line above are not kept */
+	line_cache_frame = ANTIC_line_cache && draw_display && !collisions_only;
+#ifdef NEW_CYCLE_EXACT
+	if (ANTIC_cycle_exact)
+		line_cache_frame = FALSE;
+#endif
+#ifdef SCANLINE_RING
+	line_cache_frame = FALSE;
+#endif
+#ifndef NO_SIMPLE_PAL_BLENDING
+	if (ANTIC_pal_blending)
+		line_cache_frame = FALSE;
+#endif
+	if (line_cache_frame)
+		line_cache_frames++;
+	else if (draw_display && !collisions_only)
+		/* every line is drawn, and marked dirty */
+		ANTIC_ForgetLines(0, Screen_HEIGHT);
 	ANTIC_ypos = 0;
 	do {
 		POKEY_Scanline();		/* check and generate IRQ */
 		OVERSCREEN_LINE;
 	} while (ANTIC_ypos < 8);
 
-	scrn_ptr = (UWORD *) Screen_atari;
+	if (collisions_only)
+		scrn_ptr = (UWORD *) collision_line;
+	else if (draw_display)
+		FIRST_SCRN_LINE;
 #ifdef NEW_CYCLE_EXACT
 	ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
 #endif
@@ -3322,37 +3688,39 @@ void ANTIC_Frame(int draw_display)
 			}
 		}
 #ifdef NEW_CYCLE_EXACT
-		cpu2antic_index = 0;
-		if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0 ||
-			(anticmode >= 8 && !need_load)) {
+		if (ANTIC_cycle_exact) {
 			cpu2antic_index = 0;
-		}
-		else {
-/* TODO: use a cleaner lookup table here */
-			if (!(IR & 0x10) && ((ANTIC_DMACTL & 3) == 1))
-				cpu2antic_index = 1;
-			else if ((!(IR &0x10) && ((ANTIC_DMACTL & 3) == 2)) ||
-				((IR & 0x10) && ((ANTIC_DMACTL & 3) == 1))) {
-				cpu2antic_index = 2;
+			if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0 ||
+				(anticmode >= 8 && !need_load)) {
+				cpu2antic_index = 0;
 			}
-			else
-				cpu2antic_index = 10;
-			if (IR & 0x10) {
-				cpu2antic_index += (ANTIC_HSCROL >> 1);
+			else {
+/* TODO: use a cleaner lookup table here */
+				if (!(IR & 0x10) && ((ANTIC_DMACTL & 3) == 1))
+					cpu2antic_index = 1;
+				else if ((!(IR &0x10) && ((ANTIC_DMACTL & 3) == 2)) ||
+					((IR & 0x10) && ((ANTIC_DMACTL & 3) == 1))) {
+					cpu2antic_index = 2;
+				}
+				else
+					cpu2antic_index = 10;
+				if (IR & 0x10) {
+					cpu2antic_index += (ANTIC_HSCROL >> 1);
+				}
+				if (anticmode >=2 && anticmode <=7 && !need_load)
+					cpu2antic_index += 17;
+				if (anticmode ==6 || anticmode ==7)
+					cpu2antic_index += 17 * 2;
+			 	else if (anticmode==8 || anticmode == 9)
+					cpu2antic_index += 17 * 6;
+				else if (anticmode >=0xa && anticmode <=0xc)
+					cpu2antic_index += 17 * 5;
+				else if (anticmode >=0x0d)
+					cpu2antic_index += 17 * 4;
 			}
-			if (anticmode >=2 && anticmode <=7 && !need_load)
-				cpu2antic_index += 17;
-			if (anticmode ==6 || anticmode ==7)
-				cpu2antic_index += 17 * 2;
-		 	else if (anticmode==8 || anticmode == 9)
-				cpu2antic_index += 17 * 6;
-			else if (anticmode >=0xa && anticmode <=0xc)
-				cpu2antic_index += 17 * 5;
-			else if (anticmode >=0x0d)
-				cpu2antic_index += 17 * 4;
+			ANTIC_cpu2antic_ptr = &CYCLE_MAP_cpu2antic[CYCLE_MAP_SIZE * cpu2antic_index];
+			ANTIC_antic2cpu_ptr = &CYCLE_MAP_antic2cpu[CYCLE_MAP_SIZE * cpu2antic_index];
 		}
-		ANTIC_cpu2antic_ptr = &CYCLE_MAP_cpu2antic[CYCLE_MAP_SIZE * cpu2antic_index];
-		ANTIC_antic2cpu_ptr = &CYCLE_MAP_antic2cpu[CYCLE_MAP_SIZE * cpu2antic_index];
 #endif /* NEW_CYCLE_EXACT */
 
 		if ((IR & 0x4f) == 1 && (ANTIC_DMACTL & 0x20)) {
@@ -3362,7 +3730,7 @@ void ANTIC_Frame(int draw_display)
 
 #ifdef NEW_CYCLE_EXACT
 		/* begin drawing here */
-		if (draw_display) {
+		if (draw_display && ANTIC_cycle_exact) {
 			ANTIC_cur_screen_pos = LBORDER_START;
 			ANTIC_xpos = ANTIC_antic2cpu_ptr[ANTIC_xpos]; /* convert antic to cpu(need for WSYNC) */
 			if (dctr == lastline) {
@@ -3427,29 +3795,36 @@ void ANTIC_Frame(int draw_display)
 #endif /* NO_YPOS_BREAK_FLICKER */
 
 #ifdef NEW_CYCLE_EXACT
-		GTIA_NewPmScanline();
-		if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
+		if (ANTIC_cycle_exact) {
+			GTIA_NewPmScanline();
+			if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
+				GOEOL_CYCLE_EXACT;
+				draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
+				UPDATE_DMACTL;
+				UPDATE_GTIA_BUG;
+				ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
+				YPOS_BREAK_FLICKER;
+				NEXT_SCRN_LINE;
+				if (no_jvb) {
+					dctr++;
+					dctr &= 0xf;
+				}
+				continue;
+			}
+
 			GOEOL_CYCLE_EXACT;
 			draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
+			HEAT_FONT;
 			UPDATE_DMACTL;
 			UPDATE_GTIA_BUG;
 			ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
 			YPOS_BREAK_FLICKER;
-			scrn_ptr += Screen_WIDTH / 2;
-			if (no_jvb) {
-				dctr++;
-				dctr &= 0xf;
-			}
+			NEXT_SCRN_LINE;
+			dctr++;
+			dctr &= 0xf;
 			continue;
 		}
-
-		GOEOL_CYCLE_EXACT;
-		draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
-		UPDATE_DMACTL;
-		UPDATE_GTIA_BUG;
-		ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
-
-#else /* NEW_CYCLE_EXACT not defined */
+#endif /* NEW_CYCLE_EXACT */
 		if (need_load && anticmode <= 5 && ANTIC_DMACTL & 3)
 			ANTIC_xpos += before_cycles[md];
 
@@ -3459,10 +3834,20 @@ void ANTIC_Frame(int draw_display)
 		ANTIC_xpos += ANTIC_DMAR;
 
 		if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
-			draw_antic_0_ptr();
+			{
+				LIBATARI800_TIMING_BEGIN(t);
+				if (line_cache_frame ? !blank_line_cache_skip() : !collisions_only || GTIA_pm_dirty) {
+					if (render_split_frame)
+						render_submit(NULL, 0, NULL, NULL, NULL);
+					else
+						draw_antic_0_ptr();
+				}
+				LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_VIDEO);
+			}
 			GOEOL;
 			YPOS_BREAK_FLICKER;
-			scrn_ptr += Screen_WIDTH / 2;
+			if (!collisions_only)
+				NEXT_SCRN_LINE;
 			if (no_jvb) {
 				dctr++;
 				dctr &= 0xf;
@@ -3484,24 +3869,44 @@ void ANTIC_Frame(int draw_display)
 			ANTIC_xpos += load_cycles[md];
 			if (anticmode <= 5)	/* extra cycles in font modes */
 				ANTIC_xpos -= extra_cycles[md];
+			if (line_cache_frame)
+				row_sig = line_sig_bytes(0x811c9dc5, antic_memory, sizeof(antic_memory));
+		}
+		HEAT_FONT;
+
+		{
+			LIBATARI800_TIMING_BEGIN(t);
+			if ((collisions_only && !GTIA_pm_dirty) || (line_cache_frame && mode_line_cache_skip()))
+				add_line_font_cycles();
+			else if (render_split_frame) {
+				add_line_font_cycles();
+				render_submit(draw_antic_ptr, chars_displayed[md],
+					antic_memory + ANTIC_margin + ch_offset[md],
+					scrn_ptr + x_min[md],
+					(ULONG *) &GTIA_pm_scanline[x_min[md]]);
+			}
+			else
+				draw_antic_ptr(chars_displayed[md],
+					antic_memory + ANTIC_margin + ch_offset[md],
+					scrn_ptr + x_min[md],
+					(ULONG *) &GTIA_pm_scanline[x_min[md]]);
+			LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_VIDEO);
 		}
-
-		draw_antic_ptr(chars_displayed[md],
-			antic_memory + ANTIC_margin + ch_offset[md],
-			scrn_ptr + x_min[md],
-			(ULONG *) &GTIA_pm_scanline[x_min[md]]);
 
 		GOEOL;
-#endif /* NEW_CYCLE_EXACT */
 		YPOS_BREAK_FLICKER;
-		scrn_ptr += Screen_WIDTH / 2;
+		if (!collisions_only)
+			NEXT_SCRN_LINE;
 		dctr++;
 		dctr &= 0xf;
 	} while (ANTIC_ypos < (Screen_HEIGHT + 8));
+	/* GOEOL has waited for the last line */
+	render_split_frame = FALSE;
 
-#ifndef NO_SIMPLE_PAL_BLENDING
-	/* Simple PAL blending, using only the base 256 color palette. */
-	if (ANTIC_pal_blending)
+#if !defined(NO_SIMPLE_PAL_BLENDING) && !defined(SCANLINE_RING)
+	/* Simple PAL blending, using only the base 256 color palette.
+	   It reads the line above, which SCANLINE_RING has passed on. */
+	if (ANTIC_pal_blending && !collisions_only)
 	{
 		int ypos = ANTIC_ypos - 1;
 		/* Start at the last screen line (248). */
@@ -3550,6 +3955,19 @@ void ANTIC_Frame(int draw_display)
 
 #ifdef NEW_CYCLE_EXACT
 
+int ANTIC_SetCycleExact(int enable)
+{
+	if (enable) {
+		if (!CYCLE_MAP_Create())
+			return FALSE;
+		ANTIC_cpu2antic_ptr = &CYCLE_MAP_cpu2antic[0];
+		ANTIC_antic2cpu_ptr = &CYCLE_MAP_antic2cpu[0];
+	}
+	ANTIC_cycle_exact = enable != 0;
+	ANTIC_delayed_wsync = 0;
+	return TRUE;
+}
+
 /* update the scanline from the last changed position to the current
 position, when a change was made to a display register during drawing */
 void ANTIC_UpdateScanline(void)
@@ -4033,6 +4451,9 @@ void ANTIC_SetPrior(UBYTE byte)
 
 void ANTIC_PutByte(UWORD addr, UBYTE byte)
 {
+	/* WSYNC only halts the CPU */
+	if ((addr & 0xf) != ANTIC_OFFSET_WSYNC)
+		ANTIC_RENDER_SYNC;
 	switch (addr & 0xf) {
 	case ANTIC_OFFSET_DLISTL:
 		ANTIC_dlist = (ANTIC_dlist & 0xff00) | byte;
@@ -4047,7 +4468,7 @@ glitch */
 #ifdef NEW_CYCLE_EXACT
 		dmactl_changed=0;
 		/* has DMACTL width changed?  */
-		if ((byte & 3) != (ANTIC_DMACTL & 3) ){
+		if (ANTIC_cycle_exact && (byte & 3) != (ANTIC_DMACTL & 3) ){
 			/* DMACTL width changed from 0 */
 			if ((ANTIC_DMACTL & 3) == 0) {
 				int glitch_cycle = (3 + 32) - 8*(byte & 3);
@@ -4497,3 +4918,28 @@ void ANTIC_StateRead(void)
 }
 
 #endif /* BASIC */
+
+#ifdef LIBATARI800
+void ANTIC_GetState(antic_state_t *state)
+{
+	state->DMACTL = ANTIC_DMACTL;
+	state->CHACTL = ANTIC_CHACTL;
+	state->HSCROL = ANTIC_HSCROL;
+	state->VSCROL = ANTIC_VSCROL;
+	state->PMBASE = ANTIC_PMBASE;
+	state->CHBASE = ANTIC_CHBASE;
+	state->NMIEN = ANTIC_NMIEN;
+	state->NMIST = ANTIC_NMIST;
+	state->IR = IR;
+	state->anticmode = anticmode;
+	state->dctr = dctr;
+	state->lastline = lastline;
+	state->need_dl = need_dl;
+	state->vscrol_off = vscrol_off;
+	state->dlist = ANTIC_dlist;
+	state->screenaddr = screenaddr;
+	state->xpos = ANTIC_xpos;
+	state->xpos_limit = ANTIC_xpos_limit;
+	state->ypos = ANTIC_ypos;
+}
+#endif /* LIBATARI800 */
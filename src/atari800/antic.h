@@ -74,6 +74,10 @@ extern UBYTE ANTIC_PENV_input;
 int ANTIC_Initialise(int *argc, char *argv[]);
 void ANTIC_Reset(void);
 void ANTIC_Frame(int draw_display);
+/* draw_display for a frame that is not shown: only the scanlines with
+   players or missiles on them are drawn, for their collisions, and the
+   screen is left as it was.  The CPU timing is that of TRUE. */
+#define ANTIC_DRAW_COLLISIONS 2
 UBYTE ANTIC_GetByte(UWORD addr, int no_side_effects);
 void ANTIC_PutByte(UWORD addr, UBYTE byte);
 
@@ -94,6 +98,12 @@ void ANTIC_SetPrior(UBYTE prior);
 void ANTIC_StateSave(void);
 void ANTIC_StateRead(void);
 
+#ifdef LIBATARI800
+#include "libatari800.h"
+/* Register snapshot without going through the savestate path */
+void ANTIC_GetState(antic_state_t *state);
+#endif
+
 /* Pointer to 16 KB seen by ANTIC in 0x4000-0x7fff.
    If it's the same what the CPU sees (and what's in memory[0x4000..0x7fff],
    then NULL. */
@@ -118,16 +128,56 @@ extern UWORD ANTIC_hires_lookup_l[128];
 #define ANTIC_DRAWING_SCREEN (ANTIC_cur_screen_pos!=ANTIC_NOT_DRAWING)
 extern int ANTIC_delayed_wsync;
 extern int ANTIC_cur_screen_pos;
-extern const int *ANTIC_cpu2antic_ptr;
-extern const int *ANTIC_antic2cpu_ptr;
+extern const UBYTE *ANTIC_cpu2antic_ptr;
+extern const UBYTE *ANTIC_antic2cpu_ptr;
 void ANTIC_UpdateScanline(void);
 void ANTIC_UpdateScanlinePrior(UBYTE byte);
 
 #define ANTIC_XPOS ( ANTIC_DRAWING_SCREEN ? ANTIC_cpu2antic_ptr[ANTIC_xpos] : ANTIC_xpos )
+
+/* Both timings are compiled in; ANTIC_cycle_exact selects the cycle-exact
+   one at run time.  Change it only between frames, with ANTIC_SetCycleExact,
+   which returns FALSE if the cycle maps cannot be allocated. */
+extern int ANTIC_cycle_exact;
+int ANTIC_SetCycleExact(int enable);
 #else
 #define ANTIC_XPOS ANTIC_xpos
 #endif /* NEW_CYCLE_EXACT */
 
+/* Render split: with ANTIC_render_split set, ANTIC_Frame leaves the drawing
+   of each scanline to another core, which must call ANTIC_RenderLine in a
+   loop; it draws the line handed over, if any, and returns TRUE if it did.
+   Applies to the scanline timing only.  Change it between frames.
+   ANTIC_RENDER_SYNC waits until the line in flight is drawn and is used
+   before anything the drawing depends on changes. */
+extern int ANTIC_render_split;
+extern volatile int ANTIC_render_busy;
+int ANTIC_RenderLine(void);
+void ANTIC_RenderWait(void);
+#define ANTIC_RENDER_SYNC do { if (ANTIC_render_busy) ANTIC_RenderWait(); } while (0)
+
+#ifdef LIBATARI800
+void ANTIC_GetRenderStats(render_split_stats_t *stats);
+void ANTIC_ResetRenderStats(void);
+#endif
+
+/* Line cache: with ANTIC_line_cache set, the scanline timing leaves alone
+   the lines of Screen_atari that would be drawn just as they were last time;
+   see antic.c.  It is not used with the cycle-exact timing, SCANLINE_RING or
+   PAL blending.  ANTIC_dirty_lines[y] is set for every line drawn, which
+   without the cache is every line of every frame drawn, and is for the
+   display driver to clear.  Whatever draws over
+   Screen_atari outside ANTIC calls ANTIC_ForgetLines for the lines it
+   touched, Y to Y + N - 1, so that they are drawn in full and marked. */
+extern int ANTIC_line_cache;
+extern UBYTE ANTIC_dirty_lines[];
+void ANTIC_ForgetLines(int y, int n);
+
+#ifdef LIBATARI800
+void ANTIC_GetLineCacheStats(line_cache_stats_t *stats);
+void ANTIC_ResetLineCacheStats(void);
+#endif
+
 #ifndef NO_SIMPLE_PAL_BLENDING
 /* Set to 1 to enable simplified emulation of PAL blending, that uses only
    the standard 8-bit palette. */
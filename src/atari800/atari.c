@@ -359,18 +359,17 @@ int Atari800_InitialiseMachine(void)
 /* Initialise any modules before loading the config file. */
 static void PreInitialise(void)
 {
-    if (!under_atarixl_os) {
-        printf("under_atarixl_os on ESP will fail\n");
-        //under_atarixl_os = Util_malloc(16*1024);
-    }
-
-    // dynamic on esp32
-    if (!MEMORY_mem) {
-        //MEMORY_mem  = Util_malloc(65536+2);
-        //under_atarixl_os = Util_malloc(16*1024);
-        //if (!MEMORY_mem || !under_atarixl_os)
-        //    printf("MEMORY_mem/under_atarixl_os allocation in atari800 failed\n");
-    }
+    // dynamic on esp32, platform-specific code can initialize them
+    if (!MEMORY_mem)
+        MEMORY_mem = (UBYTE *) Util_malloc(65536 + 2);
+#ifndef PAGED_ROM
+    if (!under_atarixl_os)
+        under_atarixl_os = (UBYTE *) Util_malloc(16*1024);
+    if (!under_cart809F)
+        under_cart809F = (UBYTE *) Util_malloc(8*1024);
+    if (!under_cartA0BF)
+        under_cartA0BF = (UBYTE *) Util_malloc(8*1024);
+#endif
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 	//Colours_PreInitialise();
 #endif
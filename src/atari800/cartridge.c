@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "antic.h"
 #include "atari.h"
 #include "binload.h" /* BINLOAD_loading_basic */
 #include "cartridge.h"
@@ -278,6 +279,7 @@ static void SwitchBank(int old_state)
 	   this swithch. The BBSB cartridges are not bank-switched by
 	   access to page $D5, but in CARTRIDGE_BountyBob1() and
 	   CARTRIDGE_BountyBob2(), so they need not be processed here. */
+	ANTIC_RENDER_SYNC;	/* a font may be in the bank */
 	switch (active_cart->type) {
 	case CARTRIDGE_OSS_034M_16:
 	case CARTRIDGE_OSS_043M_16:
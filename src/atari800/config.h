@@ -33,6 +33,10 @@
 /* Define to allow console sound (keyboard clicks). */
 #define CONSOLE_SOUND 1
 
+/* Define to count 6502 opcodes, sampled PC pages and hardware register
+   accesses (libatari800_get_profile). */
+/* #undef CPU_PROFILE */
+
 /* Define to activate crash menu after CIM instruction. */
 //#define CRASH_MENU 1
 
@@ -349,12 +353,22 @@
 /* Define to add IDE harddisk emulation. */
 //#define IDE 1
 
+/* Define to fast-forward side-effect-free 6502 polling loops in CPU_GO
+   (libatari800_get_idle_stats). */
+#define IDLE_LOOP_SKIP 1
+
 /* Define to allow sound interpolation. */
 //#define INTERPOLATE_SOUND 1
 
 /* Target: Atari800 as a library. */
 #define LIBATARI800 1
 
+/* Define to collect per-subsystem frame timing (libatari800_get_timing_stats). */
+/* #undef LIBATARI800_TIMING */
+
+/* Define to count memory accesses per page (libatari800_get_heatmap). */
+/* #undef MEMORY_HEATMAP */
+
 /* Define to use LINUX joystick. */
 /* #undef LINUX_JOYSTICK */
 
@@ -432,6 +446,18 @@
 /* #undef PAGED_ATTRIB */
 #define PAGED_ATTRIB
 
+/* Define to switch XE memory banks by remapping pages instead of copying. */
+/* #undef PAGED_BANKS */
+
+/* Define to map OS, BASIC and cartridge ROM pages straight from the ROM
+   images instead of copying them into RAM (needs PAGED_BANKS). */
+/* #undef PAGED_ROM */
+
+/* OS ROM 2 KB blocks copied into SRAM at machine init with PAGED_ROM, e.g.
+   0xe800, 0xf800, 0xc000 - the busiest blocks by cpu_fetch count in
+   bench -heatmap runs with the Altirra XL OS. */
+/* #undef PAGED_ROM_PIN */
+
 /* Use accurate PAL color blending. */
 #define PAL_BLENDING 1
 
@@ -456,6 +482,14 @@
 /* Use 8-bit signed samples. */
 /* #undef POKEYSND_SIGNED_SAMPLES */
 
+/* Define to run 6502 code in busy ROM pages from predecoded copies
+   (needs PAGED_ROM; PREDECODE_ROM_PAGES slots of 1 KB, default 8). */
+/* #undef PREDECODE_ROM */
+
+/* Define to compare every predecoded instruction with memory
+   (libatari800_get_predecode_stats). */
+/* #undef PREDECODE_CHECK */
+
 /* Target: Sony PlayStation 2. */
 /* #undef PS2 */
 
@@ -27,7 +27,10 @@
 	=====================
 
 	Define CPU65C02 if you don't want 6502 JMP() bug emulation.
+	Define CPU_PROFILE to count opcodes, sampled PC pages and hardware
+	register accesses (CPU_PROFILE_PERIOD instructions per PC sample).
 	Define CYCLES_PER_OPCODE to update ANTIC_xpos in each opcode's emulation.
+	Define IDLE_LOOP_SKIP to fast-forward polling loops without side effects.
 	Define MONITOR_BREAK if you want code breakpoints and execution history.
 	Define MONITOR_BREAKPOINTS if you want user-defined breakpoints.
 	Define MONITOR_PROFILE if you want 6502 opcode profiling.
@@ -35,6 +38,9 @@
 	Define NO_GOTO if you compile with GCC, but want switch() rather than goto *.
 	Define NO_V_FLAG_VARIABLE to don't use local (static) variable V for the V flag.
 	Define PC_PTR to emulate 6502 Program Counter using UBYTE *.
+	Define PREDECODE_ROM to fetch code in ROM pages from predecoded pages
+	(needs PAGED_ROM, implies PREFETCH_CODE). Define PREDECODE_CHECK to
+	compare every predecoded instruction with memory.
 	Define PREFETCH_CODE to always fetch 2 bytes after the opcode.
 	Define WRAP_64K to correctly emulate instructions that wrap at 64K.
 	Define WRAP_ZPAGE to prevent incorrect access to the address 0x0100 in zeropage
@@ -58,6 +64,7 @@
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>	/* exit() */
+#include <string.h>	/* memset() */
 
 #include "cpu.h"
 #ifdef ASAP /* external project, see http://asap.sf.net */
@@ -79,6 +86,9 @@
 #ifdef LIBATARI800
 #include "libatari800_main.h"
 #endif
+#ifdef CPU_PROFILE
+#include "libatari800_timing.h"
+#endif
 
 /* For Atari Basic loader */
 void (*CPU_rts_handler)(void) = NULL;
@@ -124,6 +134,17 @@ UBYTE CPU_IRQ;
 /* If PREFETCH_CODE is defined, 2 bytes after the opcode are always fetched. */
 /* #define PREFETCH_CODE */
 
+#ifdef PREDECODE_ROM
+#ifndef PAGED_ROM
+#error "PREDECODE_ROM needs PAGED_ROM"
+#endif
+#if defined(MONITOR_BREAKPOINTS) || defined(MONITOR_PROFILE)
+#error "PREDECODE_ROM does not support MONITOR_BREAKPOINTS and MONITOR_PROFILE"
+#endif
+/* predecoded instructions carry their operand word */
+#define PREFETCH_CODE
+#endif
+
 
 /* 6502 stack handling */
 #define PL                  MEMORY_dGetByte(0x0100 + ++S)
@@ -131,6 +152,9 @@ UBYTE CPU_IRQ;
 #define PHW(x)              PH((x) >> 8); PH((x) & 0xff)
 
 /* 6502 code fetching */
+#if defined(PC_PTR) && defined(PAGED_BANKS)
+#error "PC_PTR needs a flat MEMORY_mem, undefine PAGED_BANKS"
+#endif
 #ifdef PC_PTR
 #define GET_PC()            (PC - MEMORY_mem)
 #define SET_PC(newpc)       (PC = MEMORY_mem + (newpc))
@@ -163,7 +187,7 @@ UBYTE CPU_IRQ;
 #define RMW_GetByte(x, addr) \
 	if (MEMORY_attrib[addr] == MEMORY_HARDWARE) { \
 		x = MEMORY_HwGetByte(addr, FALSE); \
-		if ((addr & 0xed00) == 0xc000) { \
+		if ((addr & 0xed00) == 0xc000 && ANTIC_cycle_exact) { \
 			ANTIC_xpos--; \
 			MEMORY_HwPutByte(addr, x); \
 			ANTIC_xpos++; \
@@ -173,7 +197,7 @@ UBYTE CPU_IRQ;
 #else /* PAGED_ATTRIB */
 #define RMW_GetByte(x, addr) \
 	x = MEMORY_GetByte(addr); \
-	if ((addr & 0xed00) == 0xc000) { \
+	if ((addr & 0xed00) == 0xc000 && ANTIC_cycle_exact) { \
 		ANTIC_xpos--; \
 		MEMORY_PutByte(addr, x); \
 		ANTIC_xpos++; \
@@ -184,6 +208,143 @@ UBYTE CPU_IRQ;
 #define RMW_GetByte(x, addr) x = MEMORY_GetByte(addr);
 #endif /* NEW_CYCLE_EXACT */
 
+#ifdef MEMORY_HEATMAP
+/* Count the 6502 data accesses per page. The wrappers are defined before
+   the memory macros are redirected to them, so inside they still expand to
+   the plain accesses. Code bytes are counted once per instruction. */
+static UBYTE heat_GetByte(UWORD addr)
+{
+	MEMORY_HEAT(MEMORY_HEAT_CPU_READ, addr);
+#ifdef PAGED_ATTRIB
+	if (MEMORY_readmap[addr >> 8] != NULL)
+#else
+	if (MEMORY_attrib[addr] == MEMORY_HARDWARE)
+#endif
+		MEMORY_HEAT(MEMORY_HEAT_HARDWARE, addr);
+	return MEMORY_GetByte(addr);
+}
+
+static void heat_PutByte(UWORD addr, UBYTE byte)
+{
+	MEMORY_HEAT(MEMORY_HEAT_CPU_WRITE, addr);
+#ifdef PAGED_ATTRIB
+	if (MEMORY_writemap[addr >> 8] != NULL && MEMORY_writemap[addr >> 8] != MEMORY_ROM_PutByte)
+#else
+	if (MEMORY_attrib[addr] == MEMORY_HARDWARE)
+#endif
+		MEMORY_HEAT(MEMORY_HEAT_HARDWARE, addr);
+	MEMORY_PutByte(addr, byte);
+}
+
+/* zero page and stack accesses bypass the page maps */
+static UBYTE heat_dGetByte(UWORD addr)
+{
+	MEMORY_HEAT(MEMORY_HEAT_CPU_READ, addr);
+	return MEMORY_dGetByte(addr);
+}
+
+static void heat_dPutByte(UWORD addr, UBYTE byte)
+{
+	MEMORY_HEAT(MEMORY_HEAT_CPU_WRITE, addr);
+	MEMORY_dPutByte(addr, byte);
+}
+
+static UBYTE heat_CodeByte(UWORD addr)
+{
+	return MEMORY_dGetByte(addr);
+}
+
+#undef MEMORY_GetByte
+#define MEMORY_GetByte(addr)		heat_GetByte(addr)
+#undef MEMORY_PutByte
+#define MEMORY_PutByte(addr, byte)	heat_PutByte(addr, byte)
+#undef MEMORY_dGetByte
+#define MEMORY_dGetByte(addr)		heat_dGetByte(addr)
+#undef MEMORY_dPutByte
+#define MEMORY_dPutByte(addr, byte)	heat_dPutByte(addr, byte)
+#ifndef PC_PTR
+#undef GET_CODE_BYTE
+#define GET_CODE_BYTE()     heat_CodeByte(PC++)
+#undef PEEK_CODE_BYTE
+#define PEEK_CODE_BYTE()    heat_CodeByte(PC)
+#undef PEEK_CODE_WORD
+#define PEEK_CODE_WORD()    (heat_CodeByte(PC) + (heat_CodeByte((UWORD) (PC + 1)) << 8))
+#endif /* PC_PTR */
+#endif /* MEMORY_HEATMAP */
+
+#ifdef CPU_PROFILE
+/* Execution profile. Opcodes are counted exactly; the PC page is sampled
+   every CPU_PROFILE_PERIOD instructions and the host time of a hardware
+   access is measured for one access in CPU_PROFILE_PERIOD, so the hot
+   path costs a few increments. Like the heat map wrappers, the hardware
+   wrappers go on top of whatever MEMORY_GetByte/PutByte are. */
+#ifndef CPU_PROFILE_PERIOD
+#define CPU_PROFILE_PERIOD 64
+#endif
+
+/* hardware register as (page & 7) << 5 | (addr & 0x1f) */
+#define PROFILE_REG(addr) ((((addr) >> 3) & 0xe0) | ((addr) & 0x1f))
+
+static unsigned long long profile_insns[256];
+static unsigned long long profile_cycles[256];
+static unsigned long long profile_pc[256];
+static unsigned long long profile_hw_reads[256];
+static unsigned long long profile_hw_writes[256];
+static unsigned long long profile_hw_nsec[256];
+static int profile_pc_countdown = CPU_PROFILE_PERIOD;
+static int profile_hw_countdown = CPU_PROFILE_PERIOD;
+
+static UBYTE profile_GetByte(UWORD addr)
+{
+	UBYTE byte;
+#ifdef PAGED_ATTRIB
+	if (MEMORY_readmap[addr >> 8] == NULL)
+#else
+	if (MEMORY_attrib[addr] != MEMORY_HARDWARE)
+#endif
+		return MEMORY_GetByte(addr);
+	profile_hw_reads[PROFILE_REG(addr)]++;
+#ifdef LIBATARI800_TIMING
+	if (--profile_hw_countdown == 0) {
+		unsigned long long t = LIBATARI800_Timing_Now();
+		profile_hw_countdown = CPU_PROFILE_PERIOD;
+		byte = MEMORY_GetByte(addr);
+		profile_hw_nsec[PROFILE_REG(addr)] += (LIBATARI800_Timing_Now() - t) * CPU_PROFILE_PERIOD;
+		return byte;
+	}
+#endif
+	return MEMORY_GetByte(addr);
+}
+
+static void profile_PutByte(UWORD addr, UBYTE byte)
+{
+#ifdef PAGED_ATTRIB
+	if (MEMORY_writemap[addr >> 8] == NULL || MEMORY_writemap[addr >> 8] == MEMORY_ROM_PutByte) {
+#else
+	if (MEMORY_attrib[addr] != MEMORY_HARDWARE) {
+#endif
+		MEMORY_PutByte(addr, byte);
+		return;
+	}
+	profile_hw_writes[PROFILE_REG(addr)]++;
+#ifdef LIBATARI800_TIMING
+	if (--profile_hw_countdown == 0) {
+		unsigned long long t = LIBATARI800_Timing_Now();
+		profile_hw_countdown = CPU_PROFILE_PERIOD;
+		MEMORY_PutByte(addr, byte);
+		profile_hw_nsec[PROFILE_REG(addr)] += (LIBATARI800_Timing_Now() - t) * CPU_PROFILE_PERIOD;
+		return;
+	}
+#endif
+	MEMORY_PutByte(addr, byte);
+}
+
+#undef MEMORY_GetByte
+#define MEMORY_GetByte(addr)		profile_GetByte(addr)
+#undef MEMORY_PutByte
+#define MEMORY_PutByte(addr, byte)	profile_PutByte(addr, byte)
+#endif /* CPU_PROFILE */
+
 /* 6502 registers. */
 UWORD CPU_regPC;
 UBYTE CPU_regA;
@@ -231,7 +392,8 @@ void CPU_PutStatus(void)
 #define zGetWord(x) MEMORY_dGetWord(x)
 #endif
 #ifdef PREFETCH_CODE
-#if defined(WORDS_BIGENDIAN) || !defined(WORDS_UNALIGNED_OK)
+/* PREDECODE_ROM takes the operand word of ROM code from the predecoded page */
+#if (defined(WORDS_BIGENDIAN) || !defined(WORDS_UNALIGNED_OK)) && !defined(PREDECODE_ROM)
 #warning PREFETCH_CODE is efficient only on little-endian machines with WORDS_UNALIGNED_OK
 #endif
 #define OP_BYTE     ((UBYTE) addr)
@@ -302,6 +464,7 @@ void CPU_PutStatus(void)
 		if ((addr ^ GET_PC()) & 0xff00) \
 			ANTIC_xpos++; \
 		ANTIC_xpos++; \
+		IDLE_LOOP(addr, GET_PC() - 2); \
 		SET_PC(addr); \
 		DONE \
 	} \
@@ -377,6 +540,376 @@ static const int cycles[256] =
 	2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7		/* Fx */
 };
 
+/* The monitor must see every executed instruction */
+#if defined(MONITOR_BREAK) || defined(MONITOR_BREAKPOINTS) || defined(MONITOR_TRACE) || defined(MONITOR_PROFILE)
+#undef IDLE_LOOP_SKIP
+#endif
+
+#ifdef IDLE_LOOP_SKIP
+/* Idle loop fast-forward.
+
+   Polling loops such as
+     wait: LDA VCOUNT / CMP #n / BNE wait
+     wait: LDA RTCLOK / CMP RTCLOK+... / BEQ wait
+     wait: JMP wait
+   are closed by a backward branch or JMP of at most IDLE_LOOP_BYTES.
+   When such a jump is taken, IdleLoop() evaluates the next pass of the
+   loop without executing it. The body may only read memory and change
+   registers and flags: loads, compares, logic, BIT, transfers,
+   increments, flag clears/sets and forward branches inside the loop.
+   Memory cannot change inside CPU_GO (ANTIC, POKEY and interrupts run
+   between calls) and reads are limited to RAM, ROM, NMIST and - while the
+   whole call lies before ANTIC_LINE_C - VCOUNT, so if the pass ends at
+   the head with the same registers and flags, every further pass is
+   identical. ANTIC_xpos is then advanced by whole passes for as long as
+   the interpreter would still start them, which keeps the emulation
+   cycle-exact. */
+#define IDLE_LOOP_BYTES 32
+
+/* loop that failed the last check, as (head << 16) | close; cleared on
+   each CPU_GO entry because code and VCOUNT stability may change */
+static unsigned int idle_fail;
+
+/* last loop fast-forwarded and the cycles of its pass; a shorter rest of
+   the call cannot hold another pass, so the loop is not evaluated again */
+static UWORD idle_head;
+static UWORD idle_close;
+static int idle_cost;
+
+static unsigned long long idle_loops;
+static unsigned long long idle_iterations;
+static unsigned long long idle_cycles;
+
+static int IdleReadable(UWORD addr)
+{
+	if ((addr & 0xff00) == 0xd400) {
+		switch (addr & 0x0f) {
+		case ANTIC_OFFSET_NMIST:
+			return TRUE;
+		case ANTIC_OFFSET_VCOUNT:
+#ifdef NEW_CYCLE_EXACT
+			if (ANTIC_DRAWING_SCREEN)
+				return FALSE;
+#endif
+			return ANTIC_xpos_limit <= ANTIC_LINE_C;
+		default:
+			return FALSE;
+		}
+	}
+#ifdef PAGED_ATTRIB
+	return MEMORY_readmap[addr >> 8] == NULL;
+#else
+	return MEMORY_attrib[addr] != MEMORY_HARDWARE;
+#endif
+}
+
+/* Called when the jump at close to head is taken, with ANTIC_xpos at the
+   start of the next pass. */
+static void IdleLoop(UWORD head, UWORD close, UBYTE A, UBYTE X, UBYTE Y)
+{
+	UBYTE a = A;
+	UBYTE x = X;
+	UBYTE y = Y;
+	UBYTE n = N;
+	UBYTE z = Z;
+	UBYTE c = C;
+#ifndef NO_V_FLAG_VARIABLE
+	UBYTE v = V;
+#else
+	UBYTE v = CPU_regP & 0x40;
+#endif
+	UWORD pc = head;
+	UWORD addr;
+	UBYTE insn;
+	UBYTE data = 0;
+	int cost = 0;
+	int passes;
+
+	if (head == idle_head && close == idle_close && ANTIC_xpos_limit - 1 - ANTIC_xpos < idle_cost)
+		return;
+	for (;;) {
+		insn = MEMORY_dGetByte(pc);
+		cost += cycles[insn];
+		switch (insn) {
+		case 0x09: case 0x29: case 0x49: case 0xa9: case 0xc9:
+		case 0xa0: case 0xa2: case 0xc0: case 0xe0:
+			data = MEMORY_dGetByte((UWORD) (pc + 1));
+			pc += 2;
+			break;
+		case 0x05: case 0x25: case 0x45: case 0xa5: case 0xc5:
+		case 0xa4: case 0xa6: case 0xc4: case 0xe4: case 0x24:
+			data = MEMORY_dGetByte(MEMORY_dGetByte((UWORD) (pc + 1)));
+			pc += 2;
+			break;
+		case 0x0d: case 0x2d: case 0x4d: case 0xad: case 0xcd:
+		case 0xac: case 0xae: case 0xcc: case 0xec: case 0x2c:
+			addr = MEMORY_dGetByte((UWORD) (pc + 1)) + (MEMORY_dGetByte((UWORD) (pc + 2)) << 8);
+			if (!IdleReadable(addr))
+				goto fail;
+			data = MEMORY_GetByte(addr);
+			pc += 3;
+			break;
+		case 0x10: case 0x30: case 0x50: case 0x70:
+		case 0x90: case 0xb0: case 0xd0: case 0xf0:
+			data = MEMORY_dGetByte((UWORD) (pc + 1));
+			pc += 2;
+			break;
+		case 0x4c:
+			/* only the closing JMP, whose target is head */
+			if (pc != close)
+				goto fail;
+			goto pass;
+		case 0x18: case 0x38: case 0xb8: case 0xea:
+		case 0x8a: case 0x98: case 0xa8: case 0xaa:
+		case 0x88: case 0xc8: case 0xca: case 0xe8:
+			pc++;
+			break;
+		default:
+			goto fail;
+		}
+
+		switch (insn) {
+		case 0x09: case 0x05: case 0x0d:
+			z = n = a |= data;
+			break;
+		case 0x29: case 0x25: case 0x2d:
+			z = n = a &= data;
+			break;
+		case 0x49: case 0x45: case 0x4d:
+			z = n = a ^= data;
+			break;
+		case 0xa9: case 0xa5: case 0xad:
+			z = n = a = data;
+			break;
+		case 0xa2: case 0xa6: case 0xae:
+			z = n = x = data;
+			break;
+		case 0xa0: case 0xa4: case 0xac:
+			z = n = y = data;
+			break;
+		case 0xc9: case 0xc5: case 0xcd:
+			z = n = a - data;
+			c = (a >= data);
+			break;
+		case 0xe0: case 0xe4: case 0xec:
+			z = n = x - data;
+			c = (x >= data);
+			break;
+		case 0xc0: case 0xc4: case 0xcc:
+			z = n = y - data;
+			c = (y >= data);
+			break;
+		case 0x24: case 0x2c:
+			n = data;
+			v = data & 0x40;
+			z = a & data;
+			break;
+		case 0x18:
+			c = 0;
+			break;
+		case 0x38:
+			c = 1;
+			break;
+		case 0xb8:
+			v = 0;
+			break;
+		case 0x8a:
+			z = n = a = x;
+			break;
+		case 0x98:
+			z = n = a = y;
+			break;
+		case 0xa8:
+			z = n = y = a;
+			break;
+		case 0xaa:
+			z = n = x = a;
+			break;
+		case 0x88:
+			z = n = --y;
+			break;
+		case 0xc8:
+			z = n = ++y;
+			break;
+		case 0xca:
+			z = n = --x;
+			break;
+		case 0xe8:
+			z = n = ++x;
+			break;
+		case 0xea:
+			break;
+		default:
+			{
+				/* branch: bits 7-6 select N, V, C or Z, bit 5 the value */
+				static const UBYTE flag_mask[4] = { 0x80, 0x40, 0x01, 0x02 };
+				UBYTE p = (n & 0x80) | (v ? 0x40 : 0) | (z == 0 ? 0x02 : 0) | c;
+				int taken = ((p & flag_mask[insn >> 6]) != 0) == ((insn & 0x20) != 0);
+				UWORD target = pc + (SBYTE) data;
+				if ((UWORD) (pc - 2) == close) {
+					if (!taken || target != head)
+						goto fail;
+					cost += ((target ^ pc) & 0xff00) ? 2 : 1;
+					goto pass;
+				}
+				if (taken) {
+					/* forward only, so that a pass is finite */
+					if ((UWORD) (target - pc) > (UWORD) (close - pc))
+						goto fail;
+					cost += ((target ^ pc) & 0xff00) ? 2 : 1;
+					pc = target;
+				}
+			}
+			break;
+		}
+		if ((UWORD) (pc - head) > (UWORD) (close - head))
+			goto fail;
+	}
+
+pass:
+	if (a != A || x != X || y != Y
+	 || (n & 0x80) != (N & 0x80) || (z == 0) != (Z == 0) || c != C
+#ifndef NO_V_FLAG_VARIABLE
+	 || (v != 0) != (V != 0)
+#endif
+	)
+		goto fail;
+	/* every skipped pass must start before the limit */
+	idle_head = head;
+	idle_close = close;
+	idle_cost = cost;
+	passes = (ANTIC_xpos_limit - 1 - ANTIC_xpos) / cost;
+	if (passes > 0) {
+		ANTIC_xpos += passes * cost;
+		idle_loops++;
+		idle_iterations += passes;
+		idle_cycles += (unsigned long long) passes * cost;
+	}
+	return;
+
+fail:
+	idle_fail = ((unsigned int) head << 16) | close;
+}
+
+#define IDLE_LOOP(head, close) \
+	if ((UWORD) ((close) - (head)) < IDLE_LOOP_BYTES \
+	 && (((unsigned int) (head) << 16) | (UWORD) (close)) != idle_fail) \
+		IdleLoop(head, close, A, X, Y)
+#else /* IDLE_LOOP_SKIP */
+#define IDLE_LOOP(head, close)
+#endif /* IDLE_LOOP_SKIP */
+
+#ifdef PREDECODE_ROM
+/* Predecoded ROM pages.
+
+   A ROM page executed often enough is decoded into a slot holding, for
+   every offset, the opcode, its cycles and the two bytes after it, so that
+   fetching the instruction is one load instead of three reads through the
+   page table (and, on the device, flash). Any offset may start an
+   instruction, so every offset is decoded; the last two, whose operands
+   are in the next page, are left to the plain fetch (cycles == 0).
+
+   A slot is valid while MEMORY_page still points where it was decoded
+   from. PORTB, cartridge bank switches and MEMORY_SetRAM remap ROM by
+   changing that pointer, so they invalidate the page without being told,
+   and a bank switched back in finds its slot again. Only pinned ROM
+   blocks are rewritten in place; memory.c flushes the slots then. */
+#ifndef PREDECODE_ROM_PAGES
+#define PREDECODE_ROM_PAGES 8
+#endif
+
+/* misses of an undecoded ROM page before it is decoded */
+#define PREDECODE_MISSES 64
+
+struct predecoded {
+	UBYTE op;
+	UBYTE cycles;	/* 0 if not decoded */
+	UWORD operand;
+};
+
+static struct {
+	int page;	/* -1 if unused */
+	struct predecoded code[256];
+} predecode_slot[PREDECODE_ROM_PAGES];
+
+/* page -> its slot and the MEMORY_page pointer it was decoded from */
+static struct predecoded *predecode_page[256];
+static const UBYTE *predecode_src[256];
+static UBYTE predecode_miss[256];
+static int predecode_next;
+
+static unsigned long long predecode_pages;
+static unsigned long long predecode_flushes;
+#ifdef PREDECODE_CHECK
+static unsigned long long predecode_fetches;
+static unsigned long long predecode_hits;
+static unsigned long long predecode_mismatches;
+#endif
+
+void CPU_FlushPredecoded(void)
+{
+	int i;
+	for (i = 0; i < PREDECODE_ROM_PAGES; i++)
+		predecode_slot[i].page = -1;
+	memset(predecode_src, 0, sizeof(predecode_src));
+	memset(predecode_miss, 0, sizeof(predecode_miss));
+	predecode_flushes++;
+}
+
+static void Predecode(int page)
+{
+	const UBYTE *src = MEMORY_page[page];
+	struct predecoded *d = predecode_slot[predecode_next].code;
+	int i;
+
+	if (predecode_slot[predecode_next].page >= 0)
+		predecode_src[predecode_slot[predecode_next].page] = NULL;
+	predecode_slot[predecode_next].page = page;
+	predecode_next = (predecode_next + 1) % PREDECODE_ROM_PAGES;
+
+	for (i = 0; i < 0xfe; i++) {
+		d[i].op = src[i];
+		d[i].cycles = cycles[src[i]];
+		d[i].operand = src[i + 1] + (src[i + 2] << 8);
+	}
+	d[0xfe].cycles = d[0xff].cycles = 0;
+	predecode_page[page] = d;
+	predecode_src[page] = src;
+	predecode_pages++;
+}
+
+/* Returns the predecoded instruction at PC, or NULL to fetch it from
+   memory. */
+static const struct predecoded *Predecoded(UWORD pc)
+{
+	int const page = pc >> 8;
+	const struct predecoded *d;
+
+#ifdef PREDECODE_CHECK
+	predecode_fetches++;
+#endif
+	if (predecode_src[page] != MEMORY_page[page]) {
+		if (MEMORY_writemap[page] == MEMORY_ROM_PutByte && ++predecode_miss[page] == PREDECODE_MISSES) {
+			predecode_miss[page] = 0;
+			Predecode(page);
+		}
+		return NULL;
+	}
+	d = predecode_page[page] + (pc & 0xff);
+	if (d->cycles == 0)
+		return NULL;
+#ifdef PREDECODE_CHECK
+	if (d->op != MEMORY_dGetByte(pc) || d->cycles != cycles[d->op]
+	    || d->operand != MEMORY_dGetWord((UWORD) (pc + 1))) {
+		predecode_mismatches++;
+		return NULL;
+	}
+	predecode_hits++;
+#endif
+	return d;
+}
+#endif /* PREDECODE_ROM */
+
 /* 6502 emulation routine */
 #ifndef NO_GOTO
 __extension__ /* suppress -ansi -pedantic warnings */
@@ -492,6 +1025,9 @@ void CPU_GO(int limit)
 	UWORD addr;
 	UBYTE data;
 #define insn data
+#ifdef PREDECODE_ROM
+	const struct predecoded *decoded;
+#endif
 
 #else /* FALCON_CPUASM */
 
@@ -585,6 +1121,9 @@ void CPU_GO(int limit)
 	ANTIC_xpos_limit = limit;			/* needed for WSYNC store inside ANTIC */
 
 	UPDATE_LOCAL_REGS;
+#ifdef IDLE_LOOP_SKIP
+	idle_fail = 0xffffffff;
+#endif
 
 	CPUCHECKIRQ;
 
@@ -594,6 +1133,15 @@ void CPU_GO(int limit)
 		int old_xpos = ANTIC_xpos;
 		UWORD old_PC = GET_PC();
 #endif
+#ifdef CPU_PROFILE
+		int profile_xpos = ANTIC_xpos;
+		UBYTE profile_op;
+
+		if (--profile_pc_countdown == 0) {
+			profile_pc_countdown = CPU_PROFILE_PERIOD;
+			profile_pc[GET_PC() >> 8]++;
+		}
+#endif
 
 
 #ifdef MONITOR_BREAKPOINTS
@@ -653,7 +1201,27 @@ void CPU_GO(int limit)
 		MEMORY_mem[0x10000] = MEMORY_mem[0];
 #endif
 
+		MEMORY_HEAT(MEMORY_HEAT_CPU_FETCH, GET_PC());
+#ifdef PREDECODE_ROM
+		decoded = Predecoded(PC);
+		if (decoded != NULL) {
+			insn = decoded->op;
+			addr = decoded->operand;
+			PC++;
+#ifndef CYCLES_PER_OPCODE
+			ANTIC_xpos += decoded->cycles;
+#endif
+		}
+		else {
+			insn = GET_CODE_BYTE();
+			addr = PEEK_CODE_WORD();
+#ifndef CYCLES_PER_OPCODE
+			ANTIC_xpos += cycles[insn];
+#endif
+		}
+#else
 		insn = GET_CODE_BYTE();
+#endif
 
 #ifdef MONITOR_BREAKPOINTS
 #ifdef MONITOR_BREAK
@@ -823,7 +1391,7 @@ void CPU_GO(int limit)
 		}
 #endif /* MONITOR_BREAKPOINTS */
 
-#ifndef CYCLES_PER_OPCODE
+#if !defined(CYCLES_PER_OPCODE) && !defined(PREDECODE_ROM)
 		ANTIC_xpos += cycles[insn];
 #endif
 
@@ -833,10 +1401,14 @@ void CPU_GO(int limit)
 		MONITOR_coverage_insns++;
 #endif
 
-#ifdef PREFETCH_CODE
+#if defined(PREFETCH_CODE) && !defined(PREDECODE_ROM)
 		addr = PEEK_CODE_WORD();
 #endif
 
+#ifdef CPU_PROFILE
+		profile_op = insn;
+#endif
+
 #ifdef NO_GOTO
 		switch (insn) {
 #else
@@ -1299,7 +1871,13 @@ void CPU_GO(int limit)
 		CPU_remember_JMP[CPU_remember_jmp_curpos] = GET_PC() - 1;
 		CPU_remember_jmp_curpos = (CPU_remember_jmp_curpos + 1) % CPU_REMEMBER_JMP_STEPS;
 #endif
+#ifdef IDLE_LOOP_SKIP
+		addr = OP_WORD;
+		IDLE_LOOP(addr, GET_PC() - 1);
+		SET_PC(addr);
+#else
 		SET_PC(OP_WORD);
+#endif
 		DONE
 
 	OPCODE(4d)				/* EOR abcd */
@@ -2406,6 +2984,12 @@ void CPU_GO(int limit)
 		}
 #endif
 
+#ifdef CPU_PROFILE
+		/* a fast-forwarded idle loop counts for its closing instruction */
+		profile_insns[profile_op]++;
+		profile_cycles[profile_op] += ANTIC_xpos - profile_xpos;
+#endif
+
 #ifdef MONITOR_BREAK
 		if (MONITOR_break_step) {
 			DO_BREAK;
@@ -2479,3 +3063,89 @@ void CPU_StateRead(UBYTE SaveVerbose, UBYTE StateVersion)
 }
 
 #endif
+
+#ifdef LIBATARI800
+void CPU_GetState(cpu_state_t *state)
+{
+	CPU_GetStatus();	/* Make sure flags are all updated */
+	state->A = CPU_regA;
+	state->P = CPU_regP;
+	state->S = CPU_regS;
+	state->X = CPU_regX;
+	state->Y = CPU_regY;
+	state->IRQ = CPU_IRQ;
+}
+
+void CPU_GetIdleStats(idle_stats_t *stats)
+{
+#ifdef IDLE_LOOP_SKIP
+	stats->loops = idle_loops;
+	stats->iterations = idle_iterations;
+	stats->cycles = idle_cycles;
+#else
+	memset(stats, 0, sizeof(idle_stats_t));
+#endif
+}
+
+void CPU_GetProfile(profile_t *profile)
+{
+	memset(profile, 0, sizeof(profile_t));
+#ifdef CPU_PROFILE
+	memcpy(profile->insns, profile_insns, sizeof(profile_insns));
+	memcpy(profile->cycles, profile_cycles, sizeof(profile_cycles));
+	memcpy(profile->pc_samples, profile_pc, sizeof(profile_pc));
+	memcpy(profile->hw_reads, profile_hw_reads, sizeof(profile_hw_reads));
+	memcpy(profile->hw_writes, profile_hw_writes, sizeof(profile_hw_writes));
+	memcpy(profile->hw_nsec, profile_hw_nsec, sizeof(profile_hw_nsec));
+	profile->period = CPU_PROFILE_PERIOD;
+#endif
+}
+
+void CPU_ResetProfile(void)
+{
+#ifdef CPU_PROFILE
+	memset(profile_insns, 0, sizeof(profile_insns));
+	memset(profile_cycles, 0, sizeof(profile_cycles));
+	memset(profile_pc, 0, sizeof(profile_pc));
+	memset(profile_hw_reads, 0, sizeof(profile_hw_reads));
+	memset(profile_hw_writes, 0, sizeof(profile_hw_writes));
+	memset(profile_hw_nsec, 0, sizeof(profile_hw_nsec));
+#endif
+}
+
+void CPU_GetPredecodeStats(predecode_stats_t *stats)
+{
+	memset(stats, 0, sizeof(predecode_stats_t));
+#ifdef PREDECODE_ROM
+	stats->pages = predecode_pages;
+	stats->flushes = predecode_flushes;
+#ifdef PREDECODE_CHECK
+	stats->fetches = predecode_fetches;
+	stats->hits = predecode_hits;
+	stats->mismatches = predecode_mismatches;
+#endif
+#endif
+}
+
+void CPU_ResetPredecodeStats(void)
+{
+#ifdef PREDECODE_ROM
+	predecode_pages = 0;
+	predecode_flushes = 0;
+#ifdef PREDECODE_CHECK
+	predecode_fetches = 0;
+	predecode_hits = 0;
+	predecode_mismatches = 0;
+#endif
+#endif
+}
+
+void CPU_ResetIdleStats(void)
+{
+#ifdef IDLE_LOOP_SKIP
+	idle_loops = 0;
+	idle_iterations = 0;
+	idle_cycles = 0;
+#endif
+}
+#endif /* LIBATARI800 */
@@ -21,8 +21,21 @@ void CPU_PutStatus(void);
 void CPU_Reset(void);
 void CPU_StateSave(UBYTE SaveVerbose);
 void CPU_StateRead(UBYTE SaveVerbose, UBYTE StateVersion);
+#ifdef LIBATARI800
+#include "libatari800.h"
+void CPU_GetState(cpu_state_t *state);
+void CPU_GetIdleStats(idle_stats_t *stats);
+void CPU_ResetIdleStats(void);
+void CPU_GetProfile(profile_t *profile);
+void CPU_ResetProfile(void);
+void CPU_GetPredecodeStats(predecode_stats_t *stats);
+void CPU_ResetPredecodeStats(void);
+#endif
 void CPU_NMI(void);
 void CPU_GO(int limit);
+#ifdef PREDECODE_ROM
+void CPU_FlushPredecoded(void);
+#endif
 #define CPU_GenerateIRQ() (CPU_IRQ = 1)
 
 extern UWORD CPU_regPC;
@@ -0,0 +1,155 @@
+/*
+ * cycle_map.c - CPU/ANTIC cycle maps for NEW_CYCLE_EXACT
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "antic.h"
+#include "cycle_map.h"
+
+#ifdef NEW_CYCLE_EXACT
+
+/* The maps describe the cycles ANTIC steals from the CPU after the
+   missile, display list and player fetches at the start of the line
+   (those are counted in ANTIC_xpos before the map is selected):
+
+   - memory refresh in cycles 25, 29, ... 57.  A refresh that collides
+     with playfield DMA waits for the next free cycle, but is lost if
+     another refresh falls due in the meantime.
+   - playfield DMA, starting at cycle 28, 20 or 12 for a narrow, normal
+     or wide playfield, delayed by HSCROL / 2 cycles.  A horizontally
+     scrolled line is fetched one width wider.  In character modes the
+     font byte is read 3 cycles after the character name.
+
+   See the diagrams in antic.c for the bitmap modes.
+
+   The maps are built from that description only; they have not been
+   compared with upstream atari800 or with the hardware, so the cycle-exact
+   timing is not selected for any title by default. */
+
+#define REFRESH_FIRST 25
+#define REFRESH_INTERVAL 4
+#define REFRESH_COUNT 9
+
+UBYTE *CYCLE_MAP_cpu2antic = NULL;
+UBYTE *CYCLE_MAP_antic2cpu = NULL;
+
+/* Playfield DMA per map group: cycles between fetches and whether
+   character names and font bytes are fetched. */
+static const struct {
+	int interval;
+	int names;
+	int fonts;
+} groups[7] = {
+	{ 2, TRUE, TRUE },		/* modes 2-5, first line */
+	{ 2, FALSE, TRUE },		/* modes 2-5, other lines */
+	{ 4, TRUE, TRUE },		/* modes 6-7, first line */
+	{ 4, FALSE, TRUE },		/* modes 6-7, other lines */
+	{ 2, TRUE, FALSE },		/* modes d-f */
+	{ 4, TRUE, FALSE },		/* modes a-c */
+	{ 8, TRUE, FALSE }		/* modes 8-9 */
+};
+
+static void mark_playfield(UBYTE *stolen, int group, int pos)
+{
+	int start;
+	int width;
+	int c;
+
+	if (pos == 1) {
+		start = 28;		/* narrow */
+		width = 64;
+	}
+	else if (pos < 10) {
+		start = 20 + pos - 2;	/* normal, or narrow scrolled */
+		width = 80;
+	}
+	else {
+		start = 12 + pos - 10;	/* wide, or normal scrolled */
+		width = 96;
+	}
+	for (c = start; c < start + width; c += groups[group].interval) {
+		if (groups[group].names && c < ANTIC_LINE_C)
+			stolen[c] = TRUE;
+		if (groups[group].fonts && c + 3 < ANTIC_LINE_C)
+			stolen[c + 3] = TRUE;
+	}
+}
+
+static void mark_refresh(UBYTE *stolen)
+{
+	int pending = FALSE;
+	int c;
+
+	for (c = REFRESH_FIRST; c < ANTIC_LINE_C; c++) {
+		if (c <= REFRESH_FIRST + (REFRESH_COUNT - 1) * REFRESH_INTERVAL
+		 && (c - REFRESH_FIRST) % REFRESH_INTERVAL == 0)
+			pending = TRUE;
+		if (pending && !stolen[c]) {
+			stolen[c] = TRUE;
+			pending = FALSE;
+		}
+	}
+}
+
+static void build_map(int index, UBYTE *cpu2antic, UBYTE *antic2cpu)
+{
+	UBYTE stolen[ANTIC_LINE_C];
+	int cpu = 0;
+	int antic;
+
+	memset(stolen, 0, sizeof(stolen));
+	if (index > 0)
+		mark_playfield(stolen, (index - 1) / 17, (index - 1) % 17 + 1);
+	mark_refresh(stolen);
+
+	/* cycles past the end of the line are never stolen */
+	for (antic = 0; cpu < CYCLE_MAP_SIZE; antic++) {
+		if (antic < CYCLE_MAP_SIZE)
+			antic2cpu[antic] = cpu;
+		if (antic >= ANTIC_LINE_C || !stolen[antic])
+			cpu2antic[cpu++] = antic;
+	}
+	for (; antic < CYCLE_MAP_SIZE; antic++)
+		antic2cpu[antic] = cpu;
+}
+
+int CYCLE_MAP_Create(void)
+{
+	int i;
+
+	if (CYCLE_MAP_cpu2antic != NULL)
+		return TRUE;
+	CYCLE_MAP_cpu2antic = (UBYTE *) malloc(CYCLE_MAP_SIZE * CYCLE_MAP_COUNT);
+	CYCLE_MAP_antic2cpu = (UBYTE *) malloc(CYCLE_MAP_SIZE * CYCLE_MAP_COUNT);
+	if (CYCLE_MAP_cpu2antic == NULL || CYCLE_MAP_antic2cpu == NULL) {
+		free(CYCLE_MAP_cpu2antic);
+		free(CYCLE_MAP_antic2cpu);
+		CYCLE_MAP_cpu2antic = CYCLE_MAP_antic2cpu = NULL;
+		return FALSE;
+	}
+	for (i = 0; i < CYCLE_MAP_COUNT; i++)
+		build_map(i, CYCLE_MAP_cpu2antic + CYCLE_MAP_SIZE * i, CYCLE_MAP_antic2cpu + CYCLE_MAP_SIZE * i);
+	return TRUE;
+}
+
+#endif /* NEW_CYCLE_EXACT */
@@ -0,0 +1,23 @@
+#ifndef CYCLE_MAP_H_
+#define CYCLE_MAP_H_
+
+#include "atari.h"
+
+/* One map covers a scanline plus the cycles an instruction can run past
+   its end. */
+#define CYCLE_MAP_SIZE (114 + 9)
+
+/* Number of maps: a blank line, then 7 DMA patterns times 17 playfield
+   width/HSCROL combinations (see ANTIC_Frame for the index). */
+#define CYCLE_MAP_COUNT (17 * 7 + 1)
+
+/* For every map, CYCLE_MAP_cpu2antic[n] is the ANTIC cycle at which the
+   CPU gets its n-th cycle of the line, and CYCLE_MAP_antic2cpu[n] is the
+   number of CPU cycles before ANTIC cycle n.  NULL until created. */
+extern UBYTE *CYCLE_MAP_cpu2antic;
+extern UBYTE *CYCLE_MAP_antic2cpu;
+
+/* Builds the maps on first use. Returns FALSE if out of memory. */
+int CYCLE_MAP_Create(void);
+
+#endif /* CYCLE_MAP_H_ */
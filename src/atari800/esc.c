@@ -102,17 +102,17 @@ void ESC_Add(UWORD address, UBYTE esc_code, ESC_FunctionType function)
 {
 	esc_address[esc_code] = address;
 	esc_function[esc_code] = function;
-	MEMORY_dPutByte(address, 0xf2);			/* ESC */
-	MEMORY_dPutByte(address + 1, esc_code);	/* ESC CODE */
+	MEMORY_PatchByte(address, 0xf2);			/* ESC */
+	MEMORY_PatchByte(address + 1, esc_code);	/* ESC CODE */
 }
 
 void ESC_AddEscRts(UWORD address, UBYTE esc_code, ESC_FunctionType function)
 {
 	esc_address[esc_code] = address;
 	esc_function[esc_code] = function;
-	MEMORY_dPutByte(address, 0xf2);			/* ESC */
-	MEMORY_dPutByte(address + 1, esc_code);	/* ESC CODE */
-	MEMORY_dPutByte(address + 2, 0x60);		/* RTS */
+	MEMORY_PatchByte(address, 0xf2);			/* ESC */
+	MEMORY_PatchByte(address + 1, esc_code);	/* ESC CODE */
+	MEMORY_PatchByte(address + 2, 0x60);		/* RTS */
 }
 
 /* 0xd2 is ESCRTS, which works same as pair of ESC and RTS (I think so...).
@@ -125,8 +125,8 @@ void ESC_AddEscRts2(UWORD address, UBYTE esc_code, ESC_FunctionType function)
 {
 	esc_address[esc_code] = address;
 	esc_function[esc_code] = function;
-	MEMORY_dPutByte(address, 0xd2);			/* ESCRTS */
-	MEMORY_dPutByte(address + 1, esc_code);	/* ESC CODE */
+	MEMORY_PatchByte(address, 0xd2);			/* ESCRTS */
+	MEMORY_PatchByte(address + 1, esc_code);	/* ESC CODE */
 }
 
 void ESC_Remove(UBYTE esc_code)
@@ -287,8 +287,8 @@ void ESC_PatchOS(void)
 			return;
 		}
 		/* Disable setting NGFLAG on wrong OS checksum. */
-		MEMORY_dPutByte(addr, 0xea);
-		MEMORY_dPutByte(addr+1, 0xea);
+		MEMORY_PatchByte(addr, 0xea);
+		MEMORY_PatchByte(addr+1, 0xea);
 	}
 }
 
@@ -296,6 +296,13 @@ bit 7 - Missile 3
 
 UBYTE GTIA_pm_scanline[Screen_WIDTH / 2 + 8];	/* there's a byte for every *pair* of pixels */
 int GTIA_pm_dirty = TRUE;
+int GTIA_pm_colls = GTIA_PM_COLLS_BYTES;
+
+#ifdef LIBATARI800
+static unsigned long long pm_colls_lines = 0;
+static unsigned long long pm_colls_checked = 0;
+static unsigned long long pm_colls_mismatches = 0;
+#endif
 
 #define C_PM0	0x01
 #define C_PM1	0x02
@@ -430,6 +437,8 @@ static void update_partial_pmpl_colls(void)
 {
 	int l = collision_curpos;
 	int r = ANTIC_XPOS * 2 - 37;
+	if (!ANTIC_cycle_exact)
+		return;
 	generate_partial_pmpl_colls(l, r);
 	collision_curpos = r;
 }
@@ -468,8 +477,175 @@ void GTIA_UpdatePmplColls(void)
 
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 
+/* Collisions by masks (GTIA_PM_COLLS_MASKS).  Each player and missile of
+   the line is a 32-bit mask of the colour clocks it covers, bit 0 at
+   GTIA_pm_scanline[pos], and two of them collide if their masks overlap
+   once aligned.  Only the collision bits that GTIA_GetByte reads are set. */
+
+#define PM_MISSILE(n) (4 + (n))
+
+/* Shapes of players 0-3 and missiles 0-3 (PM_MISSILE); returns a bit for
+   each that shows on the line. */
+static int pm_shapes(int pos[8], ULONG shape[8])
+{
+	const UBYTE grafp[4] = { GTIA_GRAFP0, GTIA_GRAFP1, GTIA_GRAFP2, GTIA_GRAFP3 };
+	int shown = 0;
+	int n;
+
+	for (n = 0; n < 4; n++) {
+		shape[n] = grafp_ptr[n][grafp[n]] & hposp_mask[n];
+		pos[n] = hposp_ptr[n] - GTIA_pm_scanline;
+		if (shape[n])
+			shown |= 1 << n;
+	}
+	for (n = 0; n < 4; n++) {
+		/* as DO_MISSILE in pm_scanline_bytes */
+		int bits = (GTIA_GRAFM >> (2 * n)) & 3;
+		int j = global_sizem[n];
+		int l = hposm_ptr[n] - GTIA_pm_scanline;
+		shape[PM_MISSILE(n)] = 0;
+		if (bits == 0)
+			continue;
+		if (bits & 2) {
+			if (bits & 1)
+				j <<= 1;
+		}
+		else
+			l += j;
+		if (l < 2) {
+			j += l - 2;
+			l = 2;
+		}
+		else if (l + j > Screen_WIDTH / 2 - 2)
+			j = Screen_WIDTH / 2 - 2 - l;
+		if (j > 0) {
+			shape[PM_MISSILE(n)] = (1UL << j) - 1;
+			pos[PM_MISSILE(n)] = l;
+			shown |= 1 << PM_MISSILE(n);
+		}
+	}
+	return shown;
+}
+
+/* nonzero if the shapes overlap */
+static ULONG pm_overlap(int pos_a, ULONG a, int pos_b, ULONG b)
+{
+	int d = pos_b - pos_a;
+	if (d >= 32 || d <= -32)
+		return 0;
+	return d >= 0 ? (a >> d) & b : (a << -d) & b;
+}
+
+/* PxPL and MxPL of the line into COLLS, in the order of the registers */
+static void pm_mask_colls(int shown, const int pos[8], const ULONG shape[8], UBYTE colls[8])
+{
+	int n, k;
+
+	memset(colls, 0, 8);
+	/* as pm_scanline_bytes draws them, player N collects 0 .. N-1 */
+	for (n = 1; n < 4; n++)
+		if (shown & (1 << n))
+			for (k = 0; k < n; k++)
+				if ((shown & (1 << k)) && pm_overlap(pos[k], shape[k], pos[n], shape[n]))
+					colls[4 + n] |= 1 << k;
+	for (n = 0; n < 4; n++)
+		if (shown & (1 << PM_MISSILE(n)))
+			for (k = 0; k < 4; k++)
+				if ((shown & (1 << k)) && pm_overlap(pos[k], shape[k], pos[PM_MISSILE(n)], shape[PM_MISSILE(n)]))
+					colls[n] |= 1 << k;
+}
+
+static void pm_scanline_bytes(void);
+
+static void pm_scanline_masks(void)
+{
+	int pos[8];
+	ULONG shape[8];
+	UBYTE colls[8];
+	int shown;
+	int n;
+
+	if (!(GTIA_GRAFP0 | GTIA_GRAFP1 | GTIA_GRAFP2 | GTIA_GRAFP3 | GTIA_GRAFM)) {
+		/* nothing to draw and nothing collides */
+		if (GTIA_pm_dirty) {
+			memset(GTIA_pm_scanline, 0, Screen_WIDTH / 2);
+			GTIA_pm_dirty = FALSE;
+		}
+		return;
+	}
+	shown = pm_shapes(pos, shape);
+	pm_mask_colls(shown, pos, shape, colls);
+#ifdef LIBATARI800
+	if (shown)
+		pm_colls_lines++;
+	if (GTIA_pm_colls == GTIA_PM_COLLS_CHECK) {
+		/* the byte engine draws the line; compare what it collects */
+		UBYTE *regs[8] = { &GTIA_M0PL, &GTIA_M1PL, &GTIA_M2PL, &GTIA_M3PL,
+		                   &GTIA_P0PL, &GTIA_P1PL, &GTIA_P2PL, &GTIA_P3PL };
+		static const UBYTE used[8] = { 0x0f, 0x0f, 0x0f, 0x0f, 0x00, 0x01, 0x03, 0x07 };
+		UBYTE saved[8];
+		int mismatch = FALSE;
+		for (n = 0; n < 8; n++) {
+			saved[n] = *regs[n];
+			*regs[n] = 0;
+		}
+		pm_scanline_bytes();
+		for (n = 0; n < 8; n++) {
+			if ((*regs[n] & used[n]) != colls[n])
+				mismatch = TRUE;
+			*regs[n] |= saved[n];
+		}
+		pm_colls_checked++;
+		if (mismatch)
+			pm_colls_mismatches++;
+		return;
+	}
+#endif
+	GTIA_M0PL |= colls[0];
+	GTIA_M1PL |= colls[1];
+	GTIA_M2PL |= colls[2];
+	GTIA_M3PL |= colls[3];
+	GTIA_P1PL |= colls[5];
+	GTIA_P2PL |= colls[6];
+	GTIA_P3PL |= colls[7];
+
+	/* the renderers still take the line byte by byte */
+	if (GTIA_pm_dirty)
+		memset(GTIA_pm_scanline, 0, Screen_WIDTH / 2);
+	GTIA_pm_dirty = shown != 0;
+	for (n = 0; n < 8; n++) {
+		if (shown & (1 << n)) {
+			UBYTE *ptr = GTIA_pm_scanline + pos[n];
+			ULONG bits = shape[n];
+			UBYTE p = 1 << n;
+			do {
+				if (bits & 1)
+					*ptr |= p;
+				ptr++;
+				bits >>= 1;
+			} while (bits);
+		}
+	}
+}
+
 void GTIA_NewPmScanline(void)
 {
+#ifdef NEW_CYCLE_EXACT
+	/* collisions within a line need the bytes */
+	if (GTIA_pm_colls != GTIA_PM_COLLS_BYTES && !ANTIC_cycle_exact) {
+#else
+	if (GTIA_pm_colls != GTIA_PM_COLLS_BYTES) {
+#endif
+		pm_scanline_masks();
+		return;
+	}
+	pm_scanline_bytes();
+}
+
+/* Collisions by bytes: every colour clock of GTIA_pm_scanline collects the
+   objects drawn on it so far. */
+static void pm_scanline_bytes(void)
+{
 #ifdef NEW_CYCLE_EXACT
 /* reset temporary pm->pl collisions */
 	P1PL_T = P2PL_T = P3PL_T = 0;
@@ -546,10 +722,33 @@ void GTIA_NewPmScanline(void)
 		DO_MISSILE(1, 0x20, 0x0c, 0x08, 0x04)
 		DO_MISSILE(0, 0x10, 0x03, 0x02, 0x01)
 	}
+#ifdef NEW_CYCLE_EXACT
+	/* without cycle-exact timing the whole line collides at once */
+	if (!ANTIC_cycle_exact)
+		GTIA_UpdatePmplColls();
+#endif /* NEW_CYCLE_EXACT */
 }
 
 #endif /* !defined(BASIC) && !defined(CURSES_BASIC) */
 
+#ifdef LIBATARI800
+
+void GTIA_GetPmCollsStats(pm_colls_stats_t *stats)
+{
+	stats->lines = pm_colls_lines;
+	stats->checked = pm_colls_checked;
+	stats->mismatches = pm_colls_mismatches;
+}
+
+void GTIA_ResetPmCollsStats(void)
+{
+	pm_colls_lines = 0;
+	pm_colls_checked = 0;
+	pm_colls_mismatches = 0;
+}
+
+#endif /* LIBATARI800 */
+
 /* GTIA registers ---------------------------------------------------------- */
 
 void GTIA_Frame(void)
@@ -570,6 +769,9 @@ void GTIA_Frame(void)
 
 UBYTE GTIA_GetByte(UWORD addr, int no_side_effects)
 {
+	/* collisions of the line being drawn on the render core */
+	if ((addr & 0x1f) <= GTIA_OFFSET_P3PL)
+		ANTIC_RENDER_SYNC;
 	switch (addr & 0x1f) {
 	case GTIA_OFFSET_M0PF:
 #ifdef NEW_CYCLE_EXACT
@@ -747,6 +949,8 @@ void GTIA_PutByte(UWORD addr, UBYTE byte)
 #else
 #define UPDATE_PM_CYCLE_EXACT
 #endif
+	/* the line being drawn on the render core uses the old values */
+	ANTIC_RENDER_SYNC;
 
 #endif /* !defined(BASIC) && !defined(CURSES_BASIC) */
 
@@ -1195,8 +1399,10 @@ void GTIA_PutByte(UWORD addr, UBYTE byte)
 		GTIA_P0PL = GTIA_P1PL = GTIA_P2PL = GTIA_P3PL = 0;
 		PF0PM = PF1PM = PF2PM = PF3PM = 0;
 #ifdef NEW_CYCLE_EXACT
-		hitclr_pos = ANTIC_XPOS * 2 - 37;
-		collision_curpos = hitclr_pos;
+		if (ANTIC_cycle_exact) {
+			hitclr_pos = ANTIC_XPOS * 2 - 37;
+			collision_curpos = hitclr_pos;
+		}
 #endif
 		break;
 /* TODO: cycle-exact missile HPOS, GRAF, SIZE */
@@ -1224,8 +1430,8 @@ void GTIA_PutByte(UWORD addr, UBYTE byte)
 
 #ifdef NEW_CYCLE_EXACT
 #define CYCLE_EXACT_HPOSP(n) x = ANTIC_XPOS * 2 - 1;\
-	if (GTIA_HPOSP##n < x && byte < x) {\
-	/* case 1: both left of x */\
+	if (!ANTIC_DRAWING_SCREEN || (GTIA_HPOSP##n < x && byte < x)) {\
+	/* case 1: not drawing, or both left of x */\
 		/* do nothing */\
 	}\
 	else if (GTIA_HPOSP##n >= x && byte >= x ) {\
@@ -1475,3 +1681,58 @@ void GTIA_StateRead(UBYTE version)
 }
 
 #endif /* BASIC */
+
+#ifdef LIBATARI800
+void GTIA_GetState(gtia_state_t *state)
+{
+	/* PFxPM are macros over ANTIC_cl and would also expand the member names */
+	UBYTE const pf_pm[4] = { PF0PM, PF1PM, PF2PM, PF3PM };
+#undef PF0PM
+#undef PF1PM
+#undef PF2PM
+#undef PF3PM
+
+	state->HPOSP0 = GTIA_HPOSP0;
+	state->HPOSP1 = GTIA_HPOSP1;
+	state->HPOSP2 = GTIA_HPOSP2;
+	state->HPOSP3 = GTIA_HPOSP3;
+	state->HPOSM0 = GTIA_HPOSM0;
+	state->HPOSM1 = GTIA_HPOSM1;
+	state->HPOSM2 = GTIA_HPOSM2;
+	state->HPOSM3 = GTIA_HPOSM3;
+	state->PF0PM = pf_pm[0];
+	state->PF1PM = pf_pm[1];
+	state->PF2PM = pf_pm[2];
+	state->PF3PM = pf_pm[3];
+	state->M0PL = GTIA_M0PL;
+	state->M1PL = GTIA_M1PL;
+	state->M2PL = GTIA_M2PL;
+	state->M3PL = GTIA_M3PL;
+	state->P0PL = GTIA_P0PL;
+	state->P1PL = GTIA_P1PL;
+	state->P2PL = GTIA_P2PL;
+	state->P3PL = GTIA_P3PL;
+	state->SIZEP0 = GTIA_SIZEP0;
+	state->SIZEP1 = GTIA_SIZEP1;
+	state->SIZEP2 = GTIA_SIZEP2;
+	state->SIZEP3 = GTIA_SIZEP3;
+	state->SIZEM = GTIA_SIZEM;
+	state->GRAFP0 = GTIA_GRAFP0;
+	state->GRAFP1 = GTIA_GRAFP1;
+	state->GRAFP2 = GTIA_GRAFP2;
+	state->GRAFP3 = GTIA_GRAFP3;
+	state->GRAFM = GTIA_GRAFM;
+	state->COLPM0 = GTIA_COLPM0;
+	state->COLPM1 = GTIA_COLPM1;
+	state->COLPM2 = GTIA_COLPM2;
+	state->COLPM3 = GTIA_COLPM3;
+	state->COLPF0 = GTIA_COLPF0;
+	state->COLPF1 = GTIA_COLPF1;
+	state->COLPF2 = GTIA_COLPF2;
+	state->COLPF3 = GTIA_COLPF3;
+	state->COLBK = GTIA_COLBK;
+	state->PRIOR = GTIA_PRIOR;
+	state->VDELAY = GTIA_VDELAY;
+	state->GRACTL = GTIA_GRACTL;
+}
+#endif /* LIBATARI800 */
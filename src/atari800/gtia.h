@@ -113,6 +113,18 @@ extern UWORD GTIA_colour_translation_table[256];
 extern UBYTE GTIA_pm_scanline[Screen_WIDTH / 2 + 8];	/* there's a byte for every *pair* of pixels */
 extern int GTIA_pm_dirty;
 
+/* How GTIA_NewPmScanline finds the player/player and missile/player
+   collisions.  BYTES collects them colour clock by colour clock as it fills
+   GTIA_pm_scanline; MASKS tests the players and missiles against each other
+   as bit masks and leaves the line alone when no GRAF register is set.
+   CHECK computes both and counts the lines on which they differ, keeping
+   BYTES.  Cycle-exact timing always uses BYTES.  Playfield collisions are
+   found by the ANTIC renderers either way. */
+#define GTIA_PM_COLLS_BYTES 0
+#define GTIA_PM_COLLS_MASKS 1
+#define GTIA_PM_COLLS_CHECK 2
+extern int GTIA_pm_colls;
+
 extern UBYTE GTIA_collisions_mask_missile_playfield;
 extern UBYTE GTIA_collisions_mask_player_playfield;
 extern UBYTE GTIA_collisions_mask_missile_player;
@@ -131,6 +143,12 @@ UBYTE GTIA_GetByte(UWORD addr, int no_side_effects);
 void GTIA_PutByte(UWORD addr, UBYTE byte);
 void GTIA_StateSave(void);
 void GTIA_StateRead(UBYTE version);
+#ifdef LIBATARI800
+#include "libatari800.h"
+void GTIA_GetState(gtia_state_t *state);
+void GTIA_GetPmCollsStats(pm_colls_stats_t *stats);
+void GTIA_ResetPmCollsStats(void);
+#endif
 
 #ifdef NEW_CYCLE_EXACT
 void GTIA_UpdatePmplColls(void);
@@ -1024,6 +1024,8 @@ void INPUT_DrawMousePointer(void)
 		int y = mouse_y >> MOUSE_SHIFT;
 		if (x >= 0 && x <= 167 && y >= 0 && y <= 119) {
 			UWORD *ptr = & ((UWORD *) Screen_atari)[12 + x + Screen_WIDTH * y];
+			/* lines 2 * y - 4 to 2 * y + 5 */
+			ANTIC_ForgetLines(2 * y - 4, 10);
 			PLOT(-2, 0);
 			PLOT(-1, 0);
 			PLOT(1, 0);
@@ -159,27 +159,144 @@ typedef struct {
     UBYTE GRACTL;
 } gtia_state_t;
 
+typedef struct {
+    UBYTE PACTL;
+    UBYTE PBCTL;
+    UBYTE PORTA;
+    UBYTE PORTB;
+    UBYTE PORTA_mask;
+    UBYTE PORTB_mask;
+    int CA2;
+    int CB2;
+} pia_state_t;
+
 typedef struct {
     UBYTE KBCODE;
     UBYTE IRQST;
     UBYTE IRQEN;
     UBYTE SKCTL;
 
-    int shift_key;
+    int shift_key;	/* from SKSTAT */
     int keypressed;
     int DELAYED_SERIN_IRQ;
     int DELAYED_SEROUT_IRQ;
     int DELAYED_XMTDONE_IRQ;
 
-    UBYTE AUDF[4];
-    UBYTE AUDC[4];
+    /* AUDF, AUDC, AUDCTL and Base_mult per POKEY: the second one, with
+       STEREO_SOUND, in AUDF[4..7], AUDC[4..7] and index 1 */
+    UBYTE AUDF[16];
+    UBYTE AUDC[16];
     UBYTE AUDCTL[4];
 
-    int DivNIRQ[4];
+    int DivNIRQ[4];	/* the timers of the first POKEY */
     int DivNMax[4];
     int Base_mult[4];
 } pokey_state_t;
 
+/* slots of timing_stats_t.nsec, filled when built with LIBATARI800_TIMING */
+#define LIBATARI800_TIMING_INPUT 0	/* devices, input and on-screen indicators */
+#define LIBATARI800_TIMING_CPU 1	/* ANTIC_Frame minus scanline rendering */
+#define LIBATARI800_TIMING_VIDEO 2	/* draw_antic_* scanline rendering */
+#define LIBATARI800_TIMING_GTIA 3
+#define LIBATARI800_TIMING_POKEY 4
+#define LIBATARI800_TIMING_SOUND 5
+#define LIBATARI800_TIMING_SLOTS 6
+
+typedef struct {
+    ULONG frames;
+    unsigned long long cpu_cycles;
+    unsigned long long nsec[LIBATARI800_TIMING_SLOTS];
+} timing_stats_t;
+
+/* accesses per 256-byte page, filled when built with MEMORY_HEATMAP */
+typedef struct {
+    unsigned long long cpu_read[256];	/* 6502 data reads, including zero page and stack */
+    unsigned long long cpu_write[256];
+    unsigned long long cpu_fetch[256];	/* one per executed instruction */
+    unsigned long long antic[256];	/* display list, screen, character set and PM DMA */
+    unsigned long long hardware[256];	/* CPU accesses that went through a handler */
+} heatmap_t;
+
+/* idle loops fast-forwarded by CPU_GO when built with IDLE_LOOP_SKIP */
+typedef struct {
+    unsigned long long loops;	/* fast-forwards, each over one or more passes */
+    unsigned long long iterations;	/* loop passes not interpreted */
+    unsigned long long cycles;	/* CPU cycles of those passes */
+} idle_stats_t;
+
+/* 6502 execution profile, filled when built with CPU_PROFILE */
+typedef struct {
+    unsigned long long insns[256];	/* executions per opcode */
+    unsigned long long cycles[256];	/* CPU cycles per opcode, with page crossings and taken branches */
+    unsigned long long pc_samples[256];	/* PC page, one sample every period instructions */
+    unsigned long long hw_reads[256];	/* CPU hardware accesses by register (page & 7) << 5 | (addr & 0x1f) */
+    unsigned long long hw_writes[256];
+    unsigned long long hw_nsec[256];	/* host time in the handlers, estimated from every period-th access */
+    unsigned int period;
+} profile_t;
+
+/* ROM pages run from predecoded instructions when built with PREDECODE_ROM */
+typedef struct {
+    unsigned long long pages;	/* pages decoded */
+    unsigned long long flushes;	/* all pages dropped (machine init, ROM patches) */
+    unsigned long long fetches;	/* instruction fetches, with PREDECODE_CHECK only */
+    unsigned long long hits;	/* fetches served predecoded, with PREDECODE_CHECK only */
+    unsigned long long mismatches;	/* predecoded entries that differed from memory */
+} predecode_stats_t;
+
+/* scanlines streamed to the display when built with SCANLINE_RING */
+typedef struct {
+    unsigned long long lines;	/* lines the display took from the ring */
+    unsigned long long underruns;	/* lines the display reached before ANTIC had drawn them */
+    unsigned long long stalls;	/* lines ANTIC waited for because the ring was full */
+    unsigned long long late_frames;	/* frames begun after the display had started them */
+    unsigned long long latency_frames;	/* frames whose input to display latency was measured */
+    unsigned long long latency_us;	/* sum of those latencies, in microseconds */
+    unsigned long long latency_max_us;	/* longest of them */
+} scanline_ring_stats_t;
+
+/* scanlines drawn on the render core, see libatari800_set_render_split */
+typedef struct {
+    unsigned long long lines;	/* lines handed to the render core */
+    unsigned long long waits;	/* times the emulation waited for a line to be drawn */
+} render_split_stats_t;
+
+/* scanlines of drawn frames, see libatari800_set_line_cache */
+typedef struct {
+    unsigned long long drawn;	/* lines drawn */
+    unsigned long long skipped;	/* lines left as they were in the screen buffer */
+} line_cache_stats_t;
+
+/* player/missile collisions, see libatari800_set_pm_collisions */
+typedef struct {
+    unsigned long long lines;	/* lines with players or missiles, by masks */
+    unsigned long long checked;	/* lines compared with the byte engine */
+    unsigned long long mismatches;	/* lines on which the two differed */
+} pm_colls_stats_t;
+
+/* POKEY register writes, see libatari800_set_sound_log */
+typedef struct {
+    unsigned long long writes;	/* writes logged */
+    unsigned long long overflows;	/* frames whose writes did not fit in the log */
+    unsigned int max_queued;	/* most entries waiting to be rendered */
+    unsigned long long frames;	/* frames rendered by libatari800_render_sound_frame */
+    unsigned long long render_us;	/* time spent rendering them, in microseconds */
+    unsigned int render_max_us;	/* longest frame */
+} sound_log_stats_t;
+
+/* frames of libatari800_next_frame, see libatari800_set_frame_skip */
+typedef struct {
+    unsigned long long frames;	/* frames run */
+    unsigned long long skipped;	/* frames not drawn because the emulation was behind */
+    unsigned long long capped;	/* frames drawn while behind because max_skip were skipped in a row */
+    unsigned int longest_run;	/* most frames skipped in a row */
+} frame_skip_stats_t;
+
+/* display timing, see libatari800_set_cycle_exact */
+#define LIBATARI800_CYCLE_EXACT_OFF 0	/* whole scanlines at a time */
+#define LIBATARI800_CYCLE_EXACT_ON 1	/* NEW_CYCLE_EXACT: register changes within a scanline */
+#define LIBATARI800_CYCLE_EXACT_AUTO 2	/* ON for the titles known to need it */
+
 extern int libatari800_error_code;
 #define LIBATARI800_UNIDENTIFIED_CART_TYPE 1
 #define LIBATARI800_CPU_CRASH 2
@@ -197,20 +314,191 @@ void libatari800_clear_input_array(input_template_t *input);
 
 int libatari800_next_frame(input_template_t *input);
 
+/* flags for libatari800_run_frames */
+#define LIBATARI800_RUN_COLLISIONS 1	/* detect P/M collisions in the frames not drawn */
+#define LIBATARI800_RUN_SOUND 2	/* update the sound output in every frame */
+
+/* Runs FRAMES frames on one input snapshot, drawing only the last one.
+   Returns the number of frames run, fewer if the CPU crashed; the outcome
+   is in libatari800_error_code as for libatari800_next_frame. */
+int libatari800_run_frames(int frames, int flags);
+
 int libatari800_mount_disk_image(int diskno, const char *filename, int readonly);
 
 int libatari800_reboot_with_file(const char *filename);
 
+/* MEMORY_mem.  With PAGED_BANKS this is the base RAM only: an XE bank or a
+   ROM mapped in through the page table is not in it, and reads there miss
+   what the CPU sees.  libatari800_get_main_memory copies the CPU view. */
 UBYTE *libatari800_get_main_memory_ptr();
 
+/* Copies the 64 KB the CPU sees now, banks and ROM included, to BUFFER */
+void libatari800_get_main_memory(UBYTE *buffer);
+
+/* NULL when built with SCANLINE_RING, which has no frame buffer */
 UBYTE *libatari800_get_screen_ptr();
 
 cpu_state_t *libatari800_get_cpu_ptr();
 
+/* Format of the samples of libatari800_get_sound_frame */
+int libatari800_get_sound_frequency();
+
+int libatari800_get_num_sound_channels();
+
+int libatari800_get_sound_sample_size();
+
+/* Fills BUFFER with the sound of one frame at the output rate, carrying the
+   fraction of a sample over to the next call, and returns the number of
+   samples (frames of all channels), at most MAX_SAMPLES.  Call it once per
+   emulated frame.  Returns 0 without SOUND. */
+int libatari800_get_sound_frame(void *buffer, int max_samples);
+
+/* sound synthesis, see libatari800_set_sound_log */
+#define LIBATARI800_SOUND_INLINE 0	/* POKEY writes applied as they come, the frame synthesized at its end */
+#define LIBATARI800_SOUND_LOG 1	/* writes logged with their cycle, applied at their sample */
+#define LIBATARI800_SOUND_LOG_FRAME 2	/* writes logged, applied at the frame start as INLINE does; for checking */
+
+/* Selects how the sound of a frame is synthesized; see pokeysnd.h.  In the
+   log modes libatari800_get_sound_frame can still be called as ever.  To
+   synthesize on another core or thread instead, call
+   libatari800_end_sound_frame in its place and libatari800_render_sound_frame
+   on the other side.  Returns FALSE without SOUND or if the log cannot be
+   allocated. */
+int libatari800_set_sound_log(int mode);
+
+/* Log modes: closes the frame just run, for libatari800_render_sound_frame.
+   Waits only if the log is full. */
+void libatari800_end_sound_frame(void);
+
+/* Log modes: synthesizes the oldest closed frame as
+   libatari800_get_sound_frame does and returns its samples, or 0 if no frame
+   is closed.  May run on another core or thread than the emulation. */
+int libatari800_render_sound_frame(void *buffer, int max_samples);
+
+/* how POKEY output becomes samples; see POKEYSND_resample in pokeysnd.h */
+#define LIBATARI800_RESAMPLE_NEAREST 0	/* the output at each sample; aliases */
+#define LIBATARI800_RESAMPLE_BOX 1	/* averaged over the sample */
+#define LIBATARI800_RESAMPLE_BLEP 2	/* band-limited steps; costs the most */
+
+/* Selects the resampler, as -resample does, and restarts the sound with it.
+   Returns FALSE without SOUND or for an unknown mode. */
+int libatari800_set_resampler(int mode);
+
+void libatari800_get_sound_log_stats(sound_log_stats_t *stats);
+
+void libatari800_reset_sound_log_stats(void);
+
+/* Register snapshots that read the chips directly, unlike
+   libatari800_get_current_state which serializes the whole machine */
+UWORD libatari800_get_pc();
+
+void libatari800_get_cpu_state(cpu_state_t *cpu);
+
+void libatari800_get_antic_state(antic_state_t *antic);
+
+void libatari800_get_gtia_state(gtia_state_t *gtia);
+
+void libatari800_get_pia_state(pia_state_t *pia);
+
+void libatari800_get_pokey_state(pokey_state_t *pokey);
+
 void libatari800_get_current_state(emulator_state_t *state);
 
 void libatari800_restore_state(emulator_state_t *state);
 
+void libatari800_reset_timing_stats(void);
+
+void libatari800_get_timing_stats(timing_stats_t *stats);
+
+/* Either pointer may be NULL. last_frame holds the counts of the most
+   recently completed frame, session the totals since the last reset. */
+void libatari800_get_heatmap(heatmap_t *last_frame, heatmap_t *session);
+
+void libatari800_reset_heatmap(void);
+
+void libatari800_get_idle_stats(idle_stats_t *stats);
+
+void libatari800_reset_idle_stats(void);
+
+void libatari800_get_profile(profile_t *profile);
+
+void libatari800_reset_profile(void);
+
+/* Writes the profile as CSV to FILENAME, on the SD card on the device.
+   Returns FALSE if the file cannot be written. */
+int libatari800_dump_profile(const char *filename);
+
+void libatari800_get_predecode_stats(predecode_stats_t *stats);
+
+void libatari800_reset_predecode_stats(void);
+
+void libatari800_get_scanline_ring_stats(scanline_ring_stats_t *stats);
+
+void libatari800_reset_scanline_ring_stats(void);
+
+/* With SCANLINE_RING, makes libatari800_next_frame wait for the display to
+   finish the previous frame before it reads the input, rather than after,
+   so that the input shows from the top of the frame that follows.  The
+   latency fields of scanline_ring_stats_t time it either way.  Returns
+   FALSE if the core was built without SCANLINE_RING. */
+int libatari800_set_beam_racing(int enable);
+
+/* Adaptive frame skip for libatari800_next_frame: a frame that starts more
+   than BUDGET_US of wall time behind the schedule (0: the frame period of the
+   TV system) runs without being drawn, though P/M collisions are still
+   detected, so that slow stretches keep full game speed.  At most MAX_SKIP
+   frames are skipped in a row; 0, the default, turns skipping off.  A
+   skipped frame leaves the previous one in the screen buffer.  Returns FALSE
+   when built with SCANLINE_RING, where a frame that is not drawn is not
+   shown either. */
+int libatari800_set_frame_skip(int max_skip, unsigned int budget_us);
+
+void libatari800_get_frame_skip_stats(frame_skip_stats_t *stats);
+
+void libatari800_reset_frame_skip_stats(void);
+
+/* Draws the scanlines on another core, which must call ANTIC_RenderLine
+   in a loop for as long as the split is on; see antic.h.  The emulation
+   gives the same results either way.  Only the scanline timing is split. */
+void libatari800_set_render_split(int enable);
+
+void libatari800_get_render_split_stats(render_split_stats_t *stats);
+
+void libatari800_reset_render_split_stats(void);
+
+/* Leaves out of each frame drawn the scanlines that would come out the same
+   as in the screen buffer already; see antic.h.  The screen is the same
+   either way.  Lines with players or missiles are always drawn. */
+void libatari800_set_line_cache(int enable);
+
+void libatari800_get_line_cache_stats(line_cache_stats_t *stats);
+
+void libatari800_reset_line_cache_stats(void);
+
+/* collision engines, see libatari800_set_pm_collisions */
+#define LIBATARI800_PM_COLLS_BYTES 0	/* colour clock by colour clock */
+#define LIBATARI800_PM_COLLS_MASKS 1	/* whole players and missiles as bit masks */
+#define LIBATARI800_PM_COLLS_CHECK 2	/* both, counting the lines that differ */
+
+/* Selects how the player/player and missile/player collisions are found;
+   see gtia.h.  The collision registers read the same with either engine. */
+void libatari800_set_pm_collisions(int engine);
+
+void libatari800_get_pm_colls_stats(pm_colls_stats_t *stats);
+
+void libatari800_reset_pm_colls_stats(void);
+
+/* Selects the display timing, OFF by default. AUTO is resolved whenever an
+   image is booted, by the CRC32 of the file. Returns FALSE if the core was
+   built without NEW_CYCLE_EXACT or the cycle maps cannot be allocated. */
+int libatari800_set_cycle_exact(int mode);
+
+/* TRUE while the cycle-exact timing runs */
+int libatari800_get_cycle_exact(void);
+
+/* CRC32 of the image booted last, 0 if none */
+ULONG libatari800_get_title_crc(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,8 +24,15 @@
 */
 
 #include "config.h"
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifdef PICO_ON_DEVICE
+#include <pico/time.h>
+#else
+#include <time.h>
+#endif
 
 /* Atari800 includes */
 #include "atari.h"
@@ -45,18 +52,23 @@
 //#include "videomode.h"
 #include "sio.h"
 #include "cartridge.h"
+#include "crc32.h"
+#include "scanline_ring.h"
 //#include "ui.h"
 #include "libatari800_main.h"
 #include "libatari800_init.h"
 #include "libatari800_input.h"
 #include "libatari800_video.h"
 #include "libatari800_statesav.h"
+#include "libatari800_timing.h"
 
 /* mainloop includes */
 #include "antic.h"
 #include "devices.h"
 #include "gtia.h"
+#include "pia.h"
 #include "pokey.h"
+#include "pokeysnd.h"
 #ifdef PBI_BB
 #include "pbi_bb.h"
 #endif
@@ -127,7 +139,12 @@ int PLATFORM_Initialise(int *argc, char *argv[])
 }
 
 
-void LIBATARI800_Frame(void) {
+/* Emulates a frame. Without DISPLAY the screen and the on-screen indicators
+   are not drawn, and the P/M collisions are only detected with COLLISIONS,
+   which draws just the scanlines with players or missiles on them;
+   Sound_Update is skipped without SOUND. */
+static void RunFrame(int display, int collisions, int sound)
+{
 	switch (INPUT_key_code) {
 	case AKEY_COLDSTART:
 	    ///printf("Atari800_Coldstart");
@@ -152,22 +169,121 @@ void LIBATARI800_Frame(void) {
 #if defined(PBI_XLD) || defined (VOICEBOX)
 	VOTRAXSND_Frame(); /* for the Votrax */
 #endif
-	Devices_Frame();
-	INPUT_Frame();
-	GTIA_Frame();
-	ANTIC_Frame(TRUE);
-	INPUT_DrawMousePointer();
-	Screen_DrawAtariSpeed(Util_time());
-	Screen_DrawDiskLED();
-	Screen_Draw1200LED();
-	POKEY_Frame();
+	{
+		LIBATARI800_TIMING_BEGIN(t);
+		Devices_Frame();
+		INPUT_Frame();
+		LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_INPUT);
+	}
+	{
+		LIBATARI800_TIMING_BEGIN(t);
+		GTIA_Frame();
+		LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_GTIA);
+	}
+	{
+		LIBATARI800_TIMING_BEGIN(t);
+		ANTIC_Frame(display ? TRUE : collisions ? ANTIC_DRAW_COLLISIONS : FALSE);
+		/* VIDEO time booked inside ANTIC_Frame is taken out again in
+		   libatari800_get_timing_stats */
+		LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_CPU);
+	}
+#ifndef SCANLINE_RING
+	/* with SCANLINE_RING the lines are on their way to the display and
+	   there is no frame to draw the indicators on */
+	if (display) {
+		LIBATARI800_TIMING_BEGIN(t);
+		INPUT_DrawMousePointer();
+		Screen_DrawAtariSpeed(Util_time());
+		Screen_DrawDiskLED();
+		Screen_Draw1200LED();
+		LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_INPUT);
+	}
+#endif
+	{
+		LIBATARI800_TIMING_BEGIN(t);
+		POKEY_Frame();
+		LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_POKEY);
+	}
 #ifdef SOUND
-	Sound_Update();
+	if (sound) {
+		LIBATARI800_TIMING_BEGIN(t);
+		Sound_Update();
+		LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_SOUND);
+	}
+#endif
+#ifdef MEMORY_HEATMAP
+	MEMORY_HeatFrame();
 #endif
 	Atari800_nframes++;
 	///printf("LIBATARI800_Frame Atari800_nframes: %d", Atari800_nframes)
 }
 
+void LIBATARI800_Frame(void) {
+	RunFrame(TRUE, TRUE, TRUE);
+}
+
+/* Adaptive frame skip for libatari800_next_frame.  skip_due is the time by
+   which the frame being started should be done; it moves on by the budget
+   every frame, but never more than one budget past now, so time saved while
+   the emulation is ahead cannot be spent on a later slow stretch. */
+
+/* more frames late than this and the schedule starts afresh (a load, a
+   pause) instead of skipping to catch up */
+#define FRAME_SKIP_RESYNC 30
+
+static int skip_max = 0;
+static unsigned int skip_budget_us = 0;
+static unsigned long long skip_due = 0;
+static int skip_run = 0;
+static frame_skip_stats_t skip_stats;
+
+#ifdef SCANLINE_RING
+/* see libatari800_set_beam_racing */
+static int beam_racing = FALSE;
+#endif
+
+static unsigned long long FrameSkipNow(void)
+{
+#ifdef PICO_ON_DEVICE
+	return time_us_64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* Whether the frame about to run is drawn. */
+static int FrameSkipDraw(void)
+{
+	unsigned long long now;
+	unsigned int budget = skip_budget_us;
+
+	skip_stats.frames++;
+	if (skip_max <= 0)
+		return TRUE;
+	if (budget == 0)
+		budget = (unsigned int) (1e6 / (Atari800_tv_mode == Atari800_TV_PAL ? Atari800_FPS_PAL : Atari800_FPS_NTSC));
+	now = FrameSkipNow();
+	skip_due += budget;
+	if (skip_due > now + budget || now > skip_due + FRAME_SKIP_RESYNC * budget)
+		skip_due = now + budget;
+	if (now <= skip_due) {
+		/* started less than a budget late */
+		skip_run = 0;
+		return TRUE;
+	}
+	if (skip_run >= skip_max) {
+		skip_stats.capped++;
+		skip_run = 0;
+		return TRUE;
+	}
+	skip_stats.skipped++;
+	if (++skip_run > skip_stats.longest_run)
+		skip_stats.longest_run = skip_run;
+	return FALSE;
+}
+
 
 /* Stub routines to replace text-based UI */
 
@@ -238,8 +354,15 @@ jmp_buf libatari800_cpu_crash;
 int libatari800_next_frame(input_template_t *input)
 {
 	//LIBATARI800_Input_array = input; // not used
+#ifdef SCANLINE_RING
+	if (beam_racing)
+		SCANLINE_RING_WaitDisplay();
+#endif
 	INPUT_key_code = PLATFORM_Keyboard();
 	LIBATARI800_Mouse();
+#ifdef SCANLINE_RING
+	SCANLINE_RING_InputTaken();
+#endif
 #ifdef HAVE_SETJMP
 	if ((libatari800_error_code = setjmp(libatari800_cpu_crash))) {
 		/* called from within CPU_GO to indicate crash */
@@ -249,7 +372,7 @@ int libatari800_next_frame(input_template_t *input)
 #endif /* HAVE_SETJMP */
 	{
 		/* normal operation */
-		LIBATARI800_Frame();
+		RunFrame(FrameSkipDraw(), TRUE, TRUE);
 		if (CPU_cim_encountered) {
 			printf("CPU_cim_encountered");
 			libatari800_error_code = LIBATARI800_CPU_CRASH;
@@ -263,6 +386,39 @@ int libatari800_next_frame(input_template_t *input)
 	return !libatari800_error_code;
 }
 
+int libatari800_run_frames(int frames, int flags)
+{
+	volatile int done = 0;
+
+	INPUT_key_code = PLATFORM_Keyboard();
+	LIBATARI800_Mouse();
+#ifdef HAVE_SETJMP
+	if ((libatari800_error_code = setjmp(libatari800_cpu_crash))) {
+		/* called from within CPU_GO to indicate crash */
+		Log_print("libatari800_run_frames: notified of CPU crash: %d\n", CPU_cim_encountered);
+	}
+	else
+#endif /* HAVE_SETJMP */
+	{
+		while (done < frames) {
+			int last = done == frames - 1;
+			RunFrame(last, (flags & LIBATARI800_RUN_COLLISIONS) != 0, last || (flags & LIBATARI800_RUN_SOUND));
+			done++;
+			if (CPU_cim_encountered) {
+				libatari800_error_code = LIBATARI800_CPU_CRASH;
+				break;
+			}
+			/* console keys act once, other keys stay held */
+			if (INPUT_key_code == AKEY_COLDSTART || INPUT_key_code == AKEY_WARMSTART || INPUT_key_code == AKEY_UI)
+				INPUT_key_code = AKEY_NONE;
+		}
+		if (!libatari800_error_code && ANTIC_dlist == 0)
+			libatari800_error_code = LIBATARI800_DLIST_ERROR;
+	}
+	PLATFORM_DisplayScreen();
+	return done;
+}
+
 int libatari800_mount_disk_image(int diskno, const char *filename, int readonly)
 {
 	return SIO_Mount(diskno, filename, readonly);
@@ -284,11 +440,511 @@ UBYTE *libatari800_get_main_memory_ptr()
 	return MEMORY_mem;
 }
 
+void libatari800_get_main_memory(UBYTE *buffer)
+{
+	MEMORY_dCopyFromMem(0, buffer, 65536);
+}
+
 UBYTE *libatari800_get_screen_ptr()
 {
 	return (UBYTE *)Screen_atari;
 }
 
+int libatari800_get_sound_frequency()
+{
+#ifdef SOUND
+	return Sound_out.freq;
+#else
+	return 0;
+#endif
+}
+
+int libatari800_get_num_sound_channels()
+{
+#ifdef SOUND
+	return Sound_out.channels;
+#else
+	return 0;
+#endif
+}
+
+int libatari800_get_sound_sample_size()
+{
+#ifdef SOUND
+	return Sound_out.sample_size;
+#else
+	return 0;
+#endif
+}
+
+#ifdef SOUND
+static int sound_log = LIBATARI800_SOUND_INLINE;
+/* CPU cost of libatari800_render_sound_frame */
+static unsigned long long render_frames = 0;
+static unsigned long long render_us = 0;
+static unsigned int render_max_us = 0;
+
+/* Samples in the frame, carrying the fraction of a sample over */
+static int frame_samples(int max_samples)
+{
+	/* frame time not yet turned into samples, in samples * 1000 * fps */
+	static unsigned long carry = 0;
+	/* frames per 1000 s */
+	unsigned long fps = Atari800_tv_mode == Atari800_TV_PAL ? 49861 : 59923;
+	int samples;
+
+	carry += Sound_out.freq * 1000UL;
+	samples = (int) (carry / fps);
+	carry -= samples * fps;
+	if (samples > max_samples)
+		samples = max_samples;
+	return samples;
+}
+#endif
+
+int libatari800_get_sound_frame(void *buffer, int max_samples)
+{
+#ifdef SOUND
+	int samples;
+	LIBATARI800_TIMING_BEGIN(t);
+
+	if (sound_log != LIBATARI800_SOUND_INLINE) {
+		libatari800_end_sound_frame();
+		samples = libatari800_render_sound_frame(buffer, max_samples);
+	}
+	else {
+		samples = frame_samples(max_samples);
+		Sound_Callback((UBYTE *) buffer, samples * Sound_out.channels * Sound_out.sample_size);
+	}
+	LIBATARI800_TIMING_END(t, LIBATARI800_TIMING_SOUND);
+	return samples;
+#else
+	return 0;
+#endif
+}
+
+int libatari800_set_sound_log(int mode)
+{
+#ifdef SOUND
+	if (!POKEYSND_SetLog(mode == LIBATARI800_SOUND_LOG ? POKEYSND_LOG_TIMED :
+	                     mode == LIBATARI800_SOUND_LOG_FRAME ? POKEYSND_LOG_FRAME : POKEYSND_LOG_OFF))
+		return FALSE;
+	sound_log = mode;
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+int libatari800_set_resampler(int mode)
+{
+#ifdef SOUND
+	if (mode < LIBATARI800_RESAMPLE_NEAREST || mode > LIBATARI800_RESAMPLE_BLEP)
+		return FALSE;
+	POKEYSND_resample = mode;
+	/* taken at POKEYSND_Init */
+	if (Sound_enabled)
+		POKEYSND_Init(POKEYSND_FREQ_17_EXACT, Sound_out.freq, Sound_out.channels, Sound_out.sample_size == 2 ? POKEYSND_BIT16 : 0);
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+void libatari800_end_sound_frame(void)
+{
+#ifdef SOUND
+	POKEYSND_LogFrame();
+#endif
+}
+
+int libatari800_render_sound_frame(void *buffer, int max_samples)
+{
+#ifdef SOUND
+	unsigned long long start;
+	unsigned int us;
+	int samples;
+
+	if (POKEYSND_LogPending() == 0)
+		return 0;
+	start = FrameSkipNow();
+	samples = frame_samples(max_samples);
+	POKEYSND_LogRender(buffer, samples * Sound_out.channels);
+	us = (unsigned int) (FrameSkipNow() - start);
+	render_frames++;
+	render_us += us;
+	if (us > render_max_us)
+		render_max_us = us;
+	return samples;
+#else
+	return 0;
+#endif
+}
+
+void libatari800_get_sound_log_stats(sound_log_stats_t *stats)
+{
+#ifdef SOUND
+	POKEYSND_GetLogStats(stats);
+	stats->frames = render_frames;
+	stats->render_us = render_us;
+	stats->render_max_us = render_max_us;
+#else
+	memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+void libatari800_reset_sound_log_stats(void)
+{
+#ifdef SOUND
+	POKEYSND_ResetLogStats();
+	render_frames = 0;
+	render_us = 0;
+	render_max_us = 0;
+#endif
+}
+
+/* The returned snapshot is refreshed on every call */
+cpu_state_t *libatari800_get_cpu_ptr()
+{
+	static cpu_state_t cpu;
+	CPU_GetState(&cpu);
+	return &cpu;
+}
+
+UWORD libatari800_get_pc()
+{
+	return CPU_regPC;
+}
+
+void libatari800_get_cpu_state(cpu_state_t *cpu)
+{
+	CPU_GetState(cpu);
+}
+
+void libatari800_get_antic_state(antic_state_t *antic)
+{
+	ANTIC_GetState(antic);
+}
+
+void libatari800_get_gtia_state(gtia_state_t *gtia)
+{
+	GTIA_GetState(gtia);
+}
+
+void libatari800_get_pia_state(pia_state_t *pia)
+{
+	PIA_GetState(pia);
+}
+
+void libatari800_get_pokey_state(pokey_state_t *pokey)
+{
+	POKEY_GetState(pokey);
+}
+
+#ifdef MEMORY_HEATMAP
+static void heat_rows(heatmap_t *heat, unsigned long long *rows[MEMORY_HEAT_TYPES])
+{
+	rows[MEMORY_HEAT_CPU_READ] = heat->cpu_read;
+	rows[MEMORY_HEAT_CPU_WRITE] = heat->cpu_write;
+	rows[MEMORY_HEAT_CPU_FETCH] = heat->cpu_fetch;
+	rows[MEMORY_HEAT_ANTIC] = heat->antic;
+	rows[MEMORY_HEAT_HARDWARE] = heat->hardware;
+}
+#endif
+
+void libatari800_get_heatmap(heatmap_t *last_frame, heatmap_t *session)
+{
+#ifdef MEMORY_HEATMAP
+	unsigned long long *rows[MEMORY_HEAT_TYPES];
+	int type, page;
+
+	if (last_frame != NULL) {
+		heat_rows(last_frame, rows);
+		for (type = 0; type < MEMORY_HEAT_TYPES; type++)
+			for (page = 0; page < 256; page++)
+				rows[type][page] = MEMORY_heat_frame[type][page];
+	}
+	if (session != NULL) {
+		heat_rows(session, rows);
+		for (type = 0; type < MEMORY_HEAT_TYPES; type++)
+			memcpy(rows[type], MEMORY_heat_session[type], sizeof(MEMORY_heat_session[type]));
+	}
+#else
+	if (last_frame != NULL)
+		memset(last_frame, 0, sizeof(heatmap_t));
+	if (session != NULL)
+		memset(session, 0, sizeof(heatmap_t));
+#endif
+}
+
+void libatari800_reset_heatmap(void)
+{
+#ifdef MEMORY_HEATMAP
+	MEMORY_HeatReset();
+#endif
+}
+
+void libatari800_get_idle_stats(idle_stats_t *stats)
+{
+	CPU_GetIdleStats(stats);
+}
+
+void libatari800_reset_idle_stats(void)
+{
+	CPU_ResetIdleStats();
+}
+
+void libatari800_get_profile(profile_t *profile)
+{
+	CPU_GetProfile(profile);
+}
+
+void libatari800_reset_profile(void)
+{
+	CPU_ResetProfile();
+}
+
+#ifdef PICO_ON_DEVICE
+typedef FIL profile_file_t;
+#else
+typedef FILE *profile_file_t;
+#endif
+
+static int ProfileLine(profile_file_t *out, const char *fmt, ...)
+{
+	char line[96];
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(line, sizeof(line), fmt, args);
+	va_end(args);
+#ifdef PICO_ON_DEVICE
+	{
+		UINT bw;
+		return f_write(out, line, len, &bw) == FR_OK && bw == (UINT) len;
+	}
+#else
+	return fwrite(line, 1, len, *out) == (size_t) len;
+#endif
+}
+
+int libatari800_dump_profile(const char *filename)
+{
+	profile_t *profile = (profile_t *) Util_malloc(sizeof(profile_t));
+	profile_file_t out;
+	int ok;
+	int i;
+
+#ifdef PICO_ON_DEVICE
+	ok = f_open(&out, filename, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK;
+#else
+	out = fopen(filename, "w");
+	ok = out != NULL;
+#endif
+	if (!ok) {
+		free(profile);
+		return FALSE;
+	}
+	CPU_GetProfile(profile);
+	ok = ProfileLine(&out, "opcode,insns,cycles\n");
+	for (i = 0; i < 256 && ok; i++)
+		if (profile->insns[i] != 0)
+			ok = ProfileLine(&out, "%02x,%llu,%llu\n", i, profile->insns[i], profile->cycles[i]);
+	ok = ok && ProfileLine(&out, "\npage,pc_samples\n");
+	for (i = 0; i < 256 && ok; i++)
+		if (profile->pc_samples[i] != 0)
+			ok = ProfileLine(&out, "%02x,%llu\n", i, profile->pc_samples[i]);
+	ok = ok && ProfileLine(&out, "\nregister,reads,writes,nsec\n");
+	for (i = 0; i < 256 && ok; i++)
+		if (profile->hw_reads[i] != 0 || profile->hw_writes[i] != 0)
+			ok = ProfileLine(&out, "%04x,%llu,%llu,%llu\n", 0xd000 + ((i >> 5) << 8) + (i & 0x1f),
+			                 profile->hw_reads[i], profile->hw_writes[i], profile->hw_nsec[i]);
+#ifdef PICO_ON_DEVICE
+	ok = f_close(&out) == FR_OK && ok;
+#else
+	ok = fclose(out) == 0 && ok;
+#endif
+	free(profile);
+	return ok;
+}
+
+void libatari800_get_predecode_stats(predecode_stats_t *stats)
+{
+	CPU_GetPredecodeStats(stats);
+}
+
+void libatari800_reset_predecode_stats(void)
+{
+	CPU_ResetPredecodeStats();
+}
+
+void libatari800_get_scanline_ring_stats(scanline_ring_stats_t *stats)
+{
+	SCANLINE_RING_GetStats(stats);
+}
+
+void libatari800_reset_scanline_ring_stats(void)
+{
+	SCANLINE_RING_ResetStats();
+}
+
+int libatari800_set_beam_racing(int enable)
+{
+#ifdef SCANLINE_RING
+	beam_racing = enable;
+	return TRUE;
+#else
+	return !enable;
+#endif
+}
+
+int libatari800_set_frame_skip(int max_skip, unsigned int budget_us)
+{
+#ifdef SCANLINE_RING
+	/* the display would get no lines for a frame that is not drawn */
+	return max_skip <= 0;
+#else
+	skip_max = max_skip;
+	skip_budget_us = budget_us;
+	skip_due = 0;
+	skip_run = 0;
+	return TRUE;
+#endif
+}
+
+void libatari800_get_frame_skip_stats(frame_skip_stats_t *stats)
+{
+	*stats = skip_stats;
+}
+
+void libatari800_reset_frame_skip_stats(void)
+{
+	memset(&skip_stats, 0, sizeof(skip_stats));
+}
+
+void libatari800_set_render_split(int enable)
+{
+	ANTIC_render_split = enable;
+}
+
+void libatari800_get_render_split_stats(render_split_stats_t *stats)
+{
+	ANTIC_GetRenderStats(stats);
+}
+
+void libatari800_reset_render_split_stats(void)
+{
+	ANTIC_ResetRenderStats();
+}
+
+void libatari800_set_line_cache(int enable)
+{
+	ANTIC_line_cache = enable;
+}
+
+void libatari800_get_line_cache_stats(line_cache_stats_t *stats)
+{
+	ANTIC_GetLineCacheStats(stats);
+}
+
+void libatari800_reset_line_cache_stats(void)
+{
+	ANTIC_ResetLineCacheStats();
+}
+
+#ifdef NEW_CYCLE_EXACT
+/* Images whose effects need register changes within a scanline, by the
+   CRC32 of the file, for LIBATARI800_CYCLE_EXACT_AUTO.  Empty until the
+   cycle maps of cycle_map.c are checked against upstream atari800: a title
+   that looks different in the cycle-exact timing is not yet shown to look
+   right in it. */
+static const ULONG cycle_exact_titles[] = {
+	0
+};
+#endif
+
+static int cycle_exact_mode = LIBATARI800_CYCLE_EXACT_OFF;
+static ULONG title_crc = 0;
+
+static int ApplyCycleExact(void)
+{
+#ifdef NEW_CYCLE_EXACT
+	int enable = cycle_exact_mode == LIBATARI800_CYCLE_EXACT_ON;
+	int i;
+
+	if (cycle_exact_mode == LIBATARI800_CYCLE_EXACT_AUTO)
+		for (i = 0; cycle_exact_titles[i] != 0; i++)
+			if (cycle_exact_titles[i] == title_crc)
+				enable = TRUE;
+	return ANTIC_SetCycleExact(enable);
+#else
+	return cycle_exact_mode != LIBATARI800_CYCLE_EXACT_ON;
+#endif
+}
+
+void LIBATARI800_SelectTiming(const char *filename)
+{
+#ifdef PICO_ON_DEVICE
+	FIL f;
+
+	title_crc = 0;
+	if (f_open(&f, filename, FA_READ) == FR_OK) {
+		CRC32_FromFile(&f, &title_crc);
+		f_close(&f);
+	}
+#else
+	FILE *fp = fopen(filename, "rb");
+	UBYTE buf[1024];
+	ULONG crc = 0xffffffff;
+	size_t len;
+
+	title_crc = 0;
+	if (fp != NULL) {
+		while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+			crc = CRC32_Update(crc, buf, (unsigned int) len);
+		fclose(fp);
+		title_crc = ~crc;
+	}
+#endif
+	ApplyCycleExact();
+}
+
+void libatari800_set_pm_collisions(int engine)
+{
+	GTIA_pm_colls = engine;
+}
+
+void libatari800_get_pm_colls_stats(pm_colls_stats_t *stats)
+{
+	GTIA_GetPmCollsStats(stats);
+}
+
+void libatari800_reset_pm_colls_stats(void)
+{
+	GTIA_ResetPmCollsStats();
+}
+
+int libatari800_set_cycle_exact(int mode)
+{
+	cycle_exact_mode = mode;
+	return ApplyCycleExact();
+}
+
+int libatari800_get_cycle_exact(void)
+{
+#ifdef NEW_CYCLE_EXACT
+	return ANTIC_cycle_exact;
+#else
+	return FALSE;
+#endif
+}
+
+ULONG libatari800_get_title_crc(void)
+{
+	return title_crc;
+}
+
 void libatari800_get_current_state(emulator_state_t *state)
 {
 	LIBATARI800_StateSave(state->state, &state->tags);
@@ -14,6 +14,9 @@ extern jmp_buf libatari800_cpu_crash;
 
 void LIBATARI800_Frame(void);
 
+/* Picks the display timing for the image being booted */
+void LIBATARI800_SelectTiming(const char *filename);
+
 #endif /* LIBATARI800_VIDEO_H_ */
 
 void DBG_WRITE(const char* str);
@@ -0,0 +1,76 @@
+/*
+ * libatari800/timing.c - Atari800 as a library - per-subsystem frame timing
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include <string.h>
+
+#include "atari.h"
+#include "antic.h"
+#include "libatari800_timing.h"
+
+#ifdef LIBATARI800_TIMING
+#ifdef PICO_ON_DEVICE
+#include <pico/time.h>
+#else
+#include <time.h>
+#endif
+
+unsigned long long LIBATARI800_Timing_nsec[LIBATARI800_TIMING_SLOTS];
+
+unsigned long long LIBATARI800_Timing_Now(void)
+{
+#ifdef PICO_ON_DEVICE
+	return time_us_64() * 1000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+#endif /* LIBATARI800_TIMING */
+
+static int base_nframes;
+static unsigned int base_cpu_clock;
+
+void libatari800_reset_timing_stats(void)
+{
+	base_nframes = Atari800_nframes;
+	base_cpu_clock = ANTIC_screenline_cpu_clock;
+#ifdef LIBATARI800_TIMING
+	memset(LIBATARI800_Timing_nsec, 0, sizeof(LIBATARI800_Timing_nsec));
+#endif
+}
+
+void libatari800_get_timing_stats(timing_stats_t *stats)
+{
+	memset(stats, 0, sizeof(timing_stats_t));
+	stats->frames = Atari800_nframes - base_nframes;
+	stats->cpu_cycles = ANTIC_screenline_cpu_clock - base_cpu_clock;
+#ifdef LIBATARI800_TIMING
+	memcpy(stats->nsec, LIBATARI800_Timing_nsec, sizeof(stats->nsec));
+	/* scanline rendering runs nested inside ANTIC_Frame */
+	stats->nsec[LIBATARI800_TIMING_CPU] -= stats->nsec[LIBATARI800_TIMING_VIDEO];
+#endif
+}
+
+/*
+vim:ts=4:sw=4:
+*/
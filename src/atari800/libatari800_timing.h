@@ -0,0 +1,20 @@
+#ifndef LIBATARI800_TIMING_H_
+#define LIBATARI800_TIMING_H_
+
+#include "config.h"
+#include "libatari800.h"
+
+#ifdef LIBATARI800_TIMING
+extern unsigned long long LIBATARI800_Timing_nsec[LIBATARI800_TIMING_SLOTS];
+
+unsigned long long LIBATARI800_Timing_Now(void);
+
+/* Accumulate the time spent between BEGIN and END into a timing slot. */
+#define LIBATARI800_TIMING_BEGIN(t) unsigned long long t = LIBATARI800_Timing_Now()
+#define LIBATARI800_TIMING_END(t, slot) (LIBATARI800_Timing_nsec[slot] += LIBATARI800_Timing_Now() - (t))
+#else
+#define LIBATARI800_TIMING_BEGIN(t)
+#define LIBATARI800_TIMING_END(t, slot)
+#endif /* LIBATARI800_TIMING */
+
+#endif /* LIBATARI800_TIMING_H_ */
@@ -105,9 +105,179 @@ static ULONG atarixe_memory_size = 0;
 #ifndef TIGHT_MEM
 static UBYTE antic_bank_under_selftest[0x800];
 #else
-static UBYTE antic_bank_under_selftest[0];
+/* allocated with the XE banks, only 130XE and Compy Shop separate ANTIC */
+static UBYTE *antic_bank_under_selftest = NULL;
 #endif
 
+#ifdef PAGED_BANKS
+UBYTE *MEMORY_page[256];
+#ifdef PAGED_ROM
+UBYTE *MEMORY_wpage[256];
+#endif
+
+/* Memory of XE bank BANK. Bank 0 is base RAM, which stays in MEMORY_mem;
+   the first 16 KB of atarixe_memory is then only used by savestates. */
+static UBYTE *XEBank(int bank)
+{
+	return bank == 0 ? MEMORY_mem + 0x4000 : atarixe_memory + (bank << 14);
+}
+
+static void MapPages(int page, int count, UBYTE *base)
+{
+	while (--count >= 0) {
+#ifdef PAGED_ROM
+		MEMORY_wpage[page] = base;
+#endif
+		MEMORY_page[page++] = base;
+		base += 256;
+	}
+}
+
+/* CPU view of ADDR in the XE bank window */
+#define XE_CPU_MEM(addr) (MEMORY_page[0x40] + ((addr) - 0x4000))
+
+#ifdef PAGED_ROM
+#ifndef PAGED_ATTRIB
+#error "PAGED_ROM needs PAGED_ATTRIB"
+#endif
+
+/* Writes to ROM pages land in rom_sink. Unconnected ROM areas read rom_ff,
+   which is 2 KB so that MEMORY_dPtr() works as for any other block. */
+#define FF16 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+#define FF256 FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16, FF16
+static const UBYTE rom_ff[0x800] = { FF256, FF256, FF256, FF256, FF256, FF256, FF256, FF256 };
+#undef FF256
+#undef FF16
+static UBYTE rom_sink[0x100];
+
+/* ROM blocks copied into SRAM, either to be patched (ESC_PatchOS) or
+   because they are listed in PAGED_ROM_PIN. A block is pinned for
+   whatever maps its source, so a copy survives ROM being switched out. */
+#ifndef PAGED_ROM_PINS
+#define PAGED_ROM_PINS 8
+#endif
+static struct {
+	const UBYTE *src;	/* NULL if unused */
+	UBYTE *mem;
+} rom_pin[PAGED_ROM_PINS];
+
+#ifdef PAGED_ROM_PIN
+static const UWORD rom_pin_addr[] = { PAGED_ROM_PIN };
+#endif
+
+/* RAM under PAGE. Only the XE bank window may be outside MEMORY_mem, and
+   its first page is never ROM. */
+static UBYTE *RAMPage(int page)
+{
+	if (page >= 0x40 && page < 0x80 && MEMORY_ram_size > 64)
+		return MEMORY_wpage[0x40] + ((page - 0x40) << 8);
+	return MEMORY_mem + (page << 8);
+}
+
+/* Maps pinned copies over the ROM blocks in pages PAGE..PAGE+COUNT-1. */
+static void MapPinned(int page, int count)
+{
+	int block;
+	for (block = page & ~7; block < page + count; block += 8) {
+		int i;
+		if (MEMORY_wpage[block] != rom_sink)
+			continue;
+		for (i = 0; i < PAGED_ROM_PINS; i++) {
+			if (rom_pin[i].src != NULL && rom_pin[i].src == MEMORY_page[block]
+			    && rom_pin[i].src + 0x700 == MEMORY_page[block + 7]) {
+				MapPages(block, 8, rom_pin[i].mem);
+				break;
+			}
+		}
+	}
+}
+
+/* Copies the ROM block of PAGE into SRAM and maps it. Returns FALSE if the
+   block isn't mapped from a single ROM image or no pin is free. */
+static int PinBlock(int page)
+{
+	int block = page & ~7;
+	const UBYTE *src = MEMORY_page[block];
+	int i;
+	for (i = 0; i < 8; i++)
+		if (MEMORY_wpage[block + i] != rom_sink || MEMORY_page[block + i] != src + (i << 8))
+			return FALSE;
+	for (i = 0; i < PAGED_ROM_PINS; i++) {
+		if (rom_pin[i].src == NULL) {
+			if (rom_pin[i].mem == NULL)
+				rom_pin[i].mem = (UBYTE *) Util_malloc(0x800);
+			memcpy(rom_pin[i].mem, src, 0x800);
+			rom_pin[i].src = src;
+			MapPages(block, 8, rom_pin[i].mem);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Drops all pins (keeping their memory) and pins the PAGED_ROM_PIN blocks
+   of the OS just mapped. */
+static void PinOS(void)
+{
+	int i;
+	for (i = 0; i < PAGED_ROM_PINS; i++)
+		rom_pin[i].src = NULL;
+#ifdef PREDECODE_ROM
+	/* the pins are reused for the new OS */
+	CPU_FlushPredecoded();
+#endif
+#ifdef PAGED_ROM_PIN
+	for (i = 0; i < (int) (sizeof(rom_pin_addr) / sizeof(rom_pin_addr[0])); i++)
+		PinBlock(rom_pin_addr[i] >> 8);
+#endif
+}
+
+void MEMORY_MapROM(UWORD addr1, UWORD addr2, const UBYTE *src)
+{
+	int page;
+	for (page = addr1 >> 8; page <= addr2 >> 8; page++) {
+		/* ROM pages are never written through MEMORY_page */
+		MEMORY_page[page] = (UBYTE *) src;
+		MEMORY_wpage[page] = rom_sink;
+		src += 0x100;
+	}
+	MapPinned(addr1 >> 8, (addr2 >> 8) - (addr1 >> 8) + 1);
+}
+
+void MEMORY_MapRAM(UWORD addr1, UWORD addr2)
+{
+	int page;
+	for (page = addr1 >> 8; page <= addr2 >> 8; page++)
+		MEMORY_page[page] = MEMORY_wpage[page] = RAMPage(page);
+}
+
+void MEMORY_PatchByte(UWORD addr, UBYTE byte)
+{
+	if (MEMORY_wpage[addr >> 8] == rom_sink && !PinBlock(addr >> 8)) {
+		Log_print("Cannot patch ROM at %04X, no free SRAM block", addr);
+		return;
+	}
+	MEMORY_dPutByte(addr, byte);
+#ifdef PREDECODE_ROM
+	CPU_FlushPredecoded();
+#endif
+}
+#endif /* PAGED_ROM */
+#else
+#define XE_CPU_MEM(addr) (MEMORY_mem + (addr))
+#endif /* PAGED_BANKS */
+
+/* Returns the XE bank read by ANTIC if it's not the one the CPU sees,
+   otherwise NULL. */
+static UBYTE *AnticOnlyBank(int antic_bank)
+{
+#ifdef PAGED_BANKS
+	return ANTIC_xe_ptr != NULL ? XEBank(antic_bank) : NULL;
+#else
+	return ANTIC_xe_ptr != NULL ? atarixe_memory + (antic_bank << 14) : NULL;
+#endif
+}
+
 int MEMORY_have_basic = FALSE; /* Atari BASIC image has been successfully read (Atari 800 only) */
 
 /* Axlon and Mosaic RAM expansions for Atari 400/800 only */
@@ -177,6 +347,10 @@ static void AllocXEMemory(void)
 			atarixe_memory_size = size;
 			memset(atarixe_memory, 0, size);
 		}
+#ifdef TIGHT_MEM
+		if (antic_bank_under_selftest == NULL)
+			antic_bank_under_selftest = (UBYTE *) Util_malloc(0x800);
+#endif
 	}
 	/* atarixe_memory not needed, free it */
 	else if (atarixe_memory != NULL) {
@@ -214,6 +388,9 @@ void MEMORY_InitialiseMachine(void)
 	                    : 0x4000;
 	int const os_rom_start = 0x10000 - os_size;
 	ANTIC_xe_ptr = NULL;
+#ifdef PAGED_BANKS
+	MapPages(0x00, 0x100, MEMORY_mem);
+#endif
 	cart809F_enabled = FALSE;
 	MEMORY_cartA0BF_enabled = FALSE;
 	if (Atari800_machine_type == Atari800_MACHINE_XLXE) {
@@ -221,7 +398,20 @@ void MEMORY_InitialiseMachine(void)
 		if (GTIA_GRACTL & 4)
 			GTIA_TRIG_latch[3] = 0;
 	}
+#ifdef PAGED_ROM
+	if (os_rom_start < 0xd000) {
+		/* 0xd000-0xd7ff stays RAM for the device tables of devices.c,
+		   filled with what the OS copy used to put there */
+		MEMORY_MapROM(os_rom_start, 0xcfff, MEMORY_os);
+		memcpy(MEMORY_mem + 0xd000, MEMORY_os + 0xd000 - os_rom_start, 0x800);
+		MEMORY_MapROM(0xd800, 0xffff, MEMORY_os + 0xd800 - os_rom_start);
+	}
+	else
+		MEMORY_MapROM(os_rom_start, 0xffff, MEMORY_os);
+	PinOS();
+#else
 	memcpy(MEMORY_mem + os_rom_start, MEMORY_os, os_size);
+#endif
 	switch (Atari800_machine_type) {
 	case Atari800_MACHINE_5200:
 		MEMORY_dFillMem(0x0000, 0x00, 0xf800);
@@ -376,7 +566,14 @@ void MEMORY_StateSave(UBYTE SaveVerbose)
 	temp = MEMORY_ram_size > 64 ? 64 : MEMORY_ram_size;
 	StateSav_SaveINT(&temp, 1);
 	STATESAV_TAG(base_ram);
+#ifdef PAGED_BANKS
+	/* savestates hold the CPU view of memory and base RAM in the first XE
+	   bank, as if the banks and ROM had been copied */
+	for (temp = 0; temp < 256; temp++)
+		StateSav_SaveUBYTE(MEMORY_page[temp], 256);
+#else
 	StateSav_SaveUBYTE(&MEMORY_mem[0], 65536);
+#endif
 	STATESAV_TAG(base_ram_attrib);
 #ifndef PAGED_ATTRIB
 	StateSav_SaveUBYTE(&MEMORY_attrib[0], 65536);
@@ -411,11 +608,22 @@ void MEMORY_StateSave(UBYTE SaveVerbose)
 	if (Atari800_machine_type == Atari800_MACHINE_XLXE) {
 		if (SaveVerbose != 0)
 			StateSav_SaveUBYTE(&MEMORY_basic[0], 8192);
+#ifdef PAGED_ROM
+		/* the RAM under ROM stays in MEMORY_mem */
+		StateSav_SaveUBYTE(&MEMORY_mem[0xa000], 8192);
+#else
 		StateSav_SaveUBYTE(&under_cartA0BF[0], 8192);
+#endif
 
 		if (SaveVerbose != 0)
 			StateSav_SaveUBYTE(&MEMORY_os[0], 16384);
+#ifdef PAGED_ROM
+		StateSav_SaveUBYTE(&MEMORY_mem[0xc000], 0x1000);
+		StateSav_SaveUBYTE(RAMPage(0x50), 0x800);
+		StateSav_SaveUBYTE(&MEMORY_mem[0xd800], 0x2800);
+#else
 		StateSav_SaveUBYTE(&under_atarixl_os[0], 16384);
+#endif
 		if (SaveVerbose != 0)
 			StateSav_SaveUBYTE(MEMORY_xegame, 0x2000);
 	}
@@ -436,7 +644,12 @@ void MEMORY_StateSave(UBYTE SaveVerbose)
 	StateSav_SaveINT(&MEMORY_cartA0BF_enabled, 1);
 
 	if (MEMORY_ram_size > 64) {
+#ifdef PAGED_BANKS
+		StateSav_SaveUBYTE(&MEMORY_mem[0x4000], 0x4000);
+		StateSav_SaveUBYTE(&atarixe_memory[0x4000], atarixe_memory_size - 0x4000);
+#else
 		StateSav_SaveUBYTE(&atarixe_memory[0], atarixe_memory_size);
+#endif
 		if (ANTIC_xe_ptr != NULL && MEMORY_selftest_enabled)
 			StateSav_SaveUBYTE(antic_bank_under_selftest, 0x800);
 	}
@@ -450,11 +663,68 @@ void MEMORY_StateSave(UBYTE SaveVerbose)
 	}
 }
 
+#ifdef PAGED_ROM
+static UBYTE const *builtin_cart(UBYTE portb);
+
+/* Savestates hold ROM as the CPU sees it, and the RAM under BASIC (8 KB)
+   and the OS (16 KB, Self Test at 0x1000) separately in UNDER_ROM. Once
+   MEMORY_StateRead has read everything, puts that RAM back and maps the ROM
+   again. Cartridge banks were already mapped by CARTRIDGE_StateRead. */
+static void StateMapROM(UBYTE portb, const UBYTE *under_rom)
+{
+	int page;
+	for (page = 0; page < 256; page++)
+		if (MEMORY_writemap[page] == NULL)
+			MEMORY_page[page] = MEMORY_wpage[page] = RAMPage(page);
+	if (Atari800_machine_type != Atari800_MACHINE_XLXE)
+		return;
+
+	if (portb & 0x01) {
+		if (MEMORY_ram_size > 48) {
+			memcpy(MEMORY_mem + 0xc000, under_rom + 0x2000, 0x1000);
+			memcpy(MEMORY_mem + 0xd800, under_rom + 0x3800, 0x2800);
+		}
+		MEMORY_MapROM(0xc000, 0xcfff, MEMORY_os);
+		MEMORY_MapROM(0xd800, 0xffff, MEMORY_os + 0x1800);
+	}
+	else if (MEMORY_ram_size <= 48) {
+		/* unconnected, MEMORY_mem holds what the CPU saw */
+		MEMORY_MapRAM(0xc000, 0xcfff);
+		MEMORY_MapRAM(0xd800, 0xffff);
+	}
+
+	if (MEMORY_selftest_enabled) {
+		if (MEMORY_ram_size > 20)
+			memcpy(RAMPage(0x50), under_rom + 0x3000, 0x800);
+		MEMORY_MapROM(0x5000, 0x57ff, MEMORY_os + 0x1000);
+	}
+	else if (mapram_memory != NULL && MEMORY_ram_size > 20 && (portb & 0xb1) == 0x30) {
+		memcpy(mapram_memory, RAMPage(0x50), 0x800);
+		memcpy(RAMPage(0x50), under_rom + 0x3000, 0x800);
+		MapPages(0x50, 8, mapram_memory);
+	}
+	else if (MEMORY_ram_size <= 20)
+		MEMORY_MapRAM(0x5000, 0x57ff);
+
+	if (MEMORY_cartA0BF_enabled || builtin_cart(portb) != NULL) {
+		if (MEMORY_ram_size > 40)
+			memcpy(MEMORY_mem + 0xa000, under_rom, 0x2000);
+		if (!MEMORY_cartA0BF_enabled)
+			MEMORY_MapROM(0xa000, 0xbfff, builtin_cart(portb));
+	}
+	else if (MEMORY_ram_size <= 40)
+		MEMORY_MapRAM(0xa000, 0xbfff);
+}
+#endif /* PAGED_ROM */
+
 void MEMORY_StateRead(UBYTE SaveVerbose, UBYTE StateVersion)
 {
 	int base_ram_kb;
 	int num_xe_banks;
-	UBYTE portb;
+	UBYTE portb = PIA_PORTB | PIA_PORTB_mask;
+#ifdef PAGED_ROM
+	UBYTE *under_rom = NULL;
+#endif
 
 	/* Axlon/Mosaic for 400/800 */
 	if (Atari800_machine_type == Atari800_MACHINE_800 && StateVersion >= 5) {
@@ -588,11 +858,21 @@ void MEMORY_StateRead(UBYTE SaveVerbose, UBYTE StateVersion)
 	if (Atari800_machine_type == Atari800_MACHINE_XLXE) {
 		if (SaveVerbose)
 			StateSav_ReadUBYTE(&MEMORY_basic[0], 8192);
+#ifdef PAGED_ROM
+		/* PORTB isn't known yet, see StateMapROM */
+		under_rom = (UBYTE *) Util_malloc(0x6000);
+		StateSav_ReadUBYTE(under_rom, 0x2000);
+#else
 		StateSav_ReadUBYTE(&under_cartA0BF[0], 8192);
+#endif
 
 		if (SaveVerbose)
 			StateSav_ReadUBYTE(&MEMORY_os[0], 16384);
+#ifdef PAGED_ROM
+		StateSav_ReadUBYTE(under_rom + 0x2000, 0x4000);
+#else
 		StateSav_ReadUBYTE(&under_atarixl_os[0], 16384);
+#endif
 		if (StateVersion >= 7 && SaveVerbose)
 			StateSav_ReadUBYTE(MEMORY_xegame, 0x2000);
 	}
@@ -682,6 +962,26 @@ void MEMORY_StateRead(UBYTE SaveVerbose, UBYTE StateVersion)
 
 		}
 	}
+#ifdef PAGED_BANKS
+#ifdef PAGED_ROM
+	/* keep the cartridge mapping, StateMapROM does the rest */
+	if (MEMORY_ram_size > 64)
+		MapPages(0x40, 0x40, MEMORY_mem + 0x4000);
+#else
+	MapPages(0x00, 0x100, MEMORY_mem);
+#endif
+	if (MEMORY_ram_size > 64 && StateVersion >= 7) {
+		int cpu_bank = (portb & 0x10) ? 0 : MEMORY_xe_bank;
+		if (cpu_bank != 0) {
+			/* move the CPU bank out of base RAM, see MEMORY_StateSave */
+			memcpy(atarixe_memory + (cpu_bank << 14), MEMORY_mem + 0x4000, 0x4000);
+			memcpy(MEMORY_mem + 0x4000, atarixe_memory, 0x4000);
+			MapPages(0x40, 0x40, XEBank(cpu_bank));
+		}
+		if (ANTIC_xe_ptr == atarixe_memory)
+			ANTIC_xe_ptr = XEBank(0);
+	}
+#endif /* PAGED_BANKS */
 
 	/* Simius XL/XE MapRAM expansion */
 	if (StateVersion >= 7 && Atari800_machine_type == Atari800_MACHINE_XLXE && MEMORY_ram_size > 20) {
@@ -691,10 +991,71 @@ void MEMORY_StateRead(UBYTE SaveVerbose, UBYTE StateVersion)
 			StateSav_ReadUBYTE(mapram_memory, 0x800);
 		}
 	}
+#ifdef PAGED_ROM
+	StateMapROM(portb, under_rom);
+	free(under_rom);
+#endif
 }
 
 #endif /* BASIC */
 
+#ifdef PAGED_BANKS
+void MEMORY_dCopyFromMem(UWORD from, UBYTE *to, int size)
+{
+	while (size > 0) {
+		int len = 0x100 - (from & 0xff);
+		if (len > size)
+			len = size;
+		memcpy(to, MEMORY_page[from >> 8] + (from & 0xff), len);
+		from += len;
+		to += len;
+		size -= len;
+	}
+}
+
+void MEMORY_dCopyToMem(const UBYTE *from, UWORD to, int size)
+{
+	while (size > 0) {
+		int len = 0x100 - (to & 0xff);
+		if (len > size)
+			len = size;
+		memcpy(MEMORY_wpage[to >> 8] + (to & 0xff), from, len);
+		from += len;
+		to += len;
+		size -= len;
+	}
+}
+
+void MEMORY_dFillMem(UWORD addr1, UBYTE value, int length)
+{
+	while (length > 0) {
+		int len = 0x100 - (addr1 & 0xff);
+		if (len > length)
+			len = length;
+#ifdef PAGED_ROM
+		if (len == 0x100 && (MEMORY_writemap[addr1 >> 8] == MEMORY_ROM_PutByte
+		                     || MEMORY_wpage[addr1 >> 8] == rom_sink)) {
+			/* Filling ROM: 0xff is an unconnected area, map it without
+			   touching the RAM underneath. Anything else (5200 without
+			   a cartridge) goes to RAM. */
+			int const page = addr1 >> 8;
+			if (value == 0xff) {
+				MEMORY_page[page] = (UBYTE *) rom_ff + ((page & 7) << 8);
+				MEMORY_wpage[page] = rom_sink;
+				addr1 += len;
+				length -= len;
+				continue;
+			}
+			MEMORY_page[page] = MEMORY_wpage[page] = RAMPage(page);
+		}
+#endif
+		memset(MEMORY_wpage[addr1 >> 8] + (addr1 & 0xff), value, len);
+		addr1 += len;
+		length -= len;
+	}
+}
+#endif /* PAGED_BANKS */
+
 void MEMORY_CopyFromMem(UWORD from, UBYTE *to, int size)
 {
 	while (--size >= 0) {
@@ -736,6 +1097,43 @@ static UBYTE const * builtin_cart(UBYTE portb)
 	return NULL;
 }
 
+#ifdef MEMORY_HEATMAP
+ULONG MEMORY_heat[MEMORY_HEAT_TYPES][256];
+ULONG MEMORY_heat_frame[MEMORY_HEAT_TYPES][256];
+unsigned long long MEMORY_heat_session[MEMORY_HEAT_TYPES][256];
+
+void MEMORY_HeatSpan(int type, UWORD addr, int len)
+{
+	while (len > 0) {
+		/* bytes left in this page, without leaving the 4 KB block */
+		int chunk = 0x100 - (addr & 0xff);
+		if (chunk > len)
+			chunk = len;
+		MEMORY_heat[type][addr >> 8] += chunk;
+		len -= chunk;
+		addr = (addr & 0xf000) | ((addr + chunk) & 0x0fff);
+	}
+}
+
+void MEMORY_HeatFrame(void)
+{
+	int type;
+	int page;
+	for (type = 0; type < MEMORY_HEAT_TYPES; type++)
+		for (page = 0; page < 256; page++)
+			MEMORY_heat_session[type][page] += MEMORY_heat[type][page];
+	memcpy(MEMORY_heat_frame, MEMORY_heat, sizeof(MEMORY_heat));
+	memset(MEMORY_heat, 0, sizeof(MEMORY_heat));
+}
+
+void MEMORY_HeatReset(void)
+{
+	memset(MEMORY_heat, 0, sizeof(MEMORY_heat));
+	memset(MEMORY_heat_frame, 0, sizeof(MEMORY_heat_frame));
+	memset(MEMORY_heat_session, 0, sizeof(MEMORY_heat_session));
+}
+#endif /* MEMORY_HEATMAP */
+
 // track 32bit ram accesses on ESP32
 void Map_memcpy(void* dst, const void* src, int len)
 {
@@ -750,6 +1148,9 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 	int mapram_selected = FALSE;
 	int new_mapram_selected = FALSE;
 
+	/* ANTIC may be reading fonts through the old mapping on the render core */
+	ANTIC_RENDER_SYNC;
+
 	/* MapRAM is selected if RAM > 20 KB, Self Test is enabled while OS ROM is disabled,
 	   and both CPU & ANTIC have access to base RAM. */
 	if (mapram_memory != NULL && MEMORY_ram_size > 20) {
@@ -759,8 +1160,12 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 
 	if (mapram_selected && !new_mapram_selected) {
 		/* Restore RAM hidden by MapRAM. */
-		memcpy(mapram_memory, MEMORY_mem + 0x5000, 0x800);
-		Map_memcpy(MEMORY_mem + 0x5000, under_atarixl_os + 0x1000, 0x800);
+#ifdef PAGED_ROM
+		MEMORY_MapRAM(0x5000, 0x57ff);
+#else
+		memcpy(mapram_memory, XE_CPU_MEM(0x5000), 0x800);
+		Map_memcpy(XE_CPU_MEM(0x5000), under_atarixl_os + 0x1000, 0x800);
+#endif
 	}
 
 	/* Switch XE memory bank in 0x4000-0x7fff */
@@ -801,13 +1206,22 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 		        || antic_bank != new_antic_bank
 		        || (MEMORY_ram_size == MEMORY_RAM_320_COMPY_SHOP && (byte & 0x20) == 0))) {
 			/* Disable Self Test ROM */
-			Map_memcpy(MEMORY_mem + 0x5000, under_atarixl_os + 0x1000, 0x800);
-			if (ANTIC_xe_ptr != NULL)
+#ifndef PAGED_ROM
+			Map_memcpy(XE_CPU_MEM(0x5000), under_atarixl_os + 0x1000, 0x800);
+#endif
+			if (AnticOnlyBank(antic_bank) != NULL)
 				/* Also disable Self Test from XE bank accessed by ANTIC. */
-				memcpy(atarixe_memory + (antic_bank << 14) + 0x1000, antic_bank_under_selftest, 0x800);
+				memcpy(AnticOnlyBank(antic_bank) + 0x1000, antic_bank_under_selftest, 0x800);
 			MEMORY_SetRAM(0x5000, 0x57ff);
 			MEMORY_selftest_enabled = FALSE;
 		}
+#ifdef PAGED_BANKS
+		if (cpu_bank != new_cpu_bank)
+			MapPages(0x40, 0x40, XEBank(new_cpu_bank));
+
+		if (MEMORY_ram_size == 128 || MEMORY_ram_size == MEMORY_RAM_320_COMPY_SHOP)
+			ANTIC_xe_ptr = new_antic_bank == new_cpu_bank ? NULL : XEBank(new_antic_bank);
+#else
 		if (cpu_bank != new_cpu_bank) {
 			memcpy(atarixe_memory + (cpu_bank << 14), MEMORY_mem + 0x4000, 0x4000);
 			memcpy(MEMORY_mem + 0x4000, atarixe_memory + (new_cpu_bank << 14), 0x4000);
@@ -815,6 +1229,7 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 
 		if (MEMORY_ram_size == 128 || MEMORY_ram_size == MEMORY_RAM_320_COMPY_SHOP)
 			ANTIC_xe_ptr = new_antic_bank == new_cpu_bank ? NULL : atarixe_memory + (new_antic_bank << 14);
+#endif /* PAGED_BANKS */
 
 		MEMORY_xe_bank = bank;
 		antic_bank = new_antic_bank;
@@ -825,20 +1240,24 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 		if (byte & 0x01) {
 			/* Enable OS ROM */
 			if (MEMORY_ram_size > 48) {
+#ifndef PAGED_ROM
 				Map_memcpy(under_atarixl_os, MEMORY_mem + 0xc000, 0x1000);
 				Map_memcpy(under_atarixl_os + 0x1800, MEMORY_mem + 0xd800, 0x2800);
+#endif
 				MEMORY_SetROM(0xc000, 0xcfff);
 				MEMORY_SetROM(0xd800, 0xffff);
 			}
-			memcpy(MEMORY_mem + 0xc000, MEMORY_os, 0x1000);
-			memcpy(MEMORY_mem + 0xd800, MEMORY_os + 0x1800, 0x2800);
+			MEMORY_CopyROM(0xc000, 0xcfff, MEMORY_os);
+			MEMORY_CopyROM(0xd800, 0xffff, MEMORY_os + 0x1800);
 			ESC_PatchOS();
 		}
 		else {
 			/* Disable OS ROM */
 			if (MEMORY_ram_size > 48) {
+#ifndef PAGED_ROM
 				Map_memcpy(MEMORY_mem + 0xc000, under_atarixl_os, 0x1000);
 				Map_memcpy(MEMORY_mem + 0xd800, under_atarixl_os + 0x1800, 0x2800);
+#endif
 				MEMORY_SetRAM(0xc000, 0xcfff);
 				MEMORY_SetRAM(0xd800, 0xffff);
 			} else {
@@ -848,10 +1267,12 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 			/* When OS ROM is disabled we also have to disable Self Test - Jindroush */
 			if (MEMORY_selftest_enabled) {
 				if (MEMORY_ram_size > 20) {
-					Map_memcpy(MEMORY_mem + 0x5000, under_atarixl_os + 0x1000, 0x800);
-					if (ANTIC_xe_ptr != NULL)
+#ifndef PAGED_ROM
+					Map_memcpy(XE_CPU_MEM(0x5000), under_atarixl_os + 0x1000, 0x800);
+#endif
+					if (AnticOnlyBank(antic_bank) != NULL)
 						/* Also disable Self Test from XE bank accessed by ANTIC. */
-						memcpy(atarixe_memory + (antic_bank << 14) + 0x1000, antic_bank_under_selftest, 0x800);
+						memcpy(AnticOnlyBank(antic_bank) + 0x1000, antic_bank_under_selftest, 0x800);
 					MEMORY_SetRAM(0x5000, 0x57ff);
 				}
 				else
@@ -867,19 +1288,23 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 		UBYTE const *builtin_cart_old = builtin_cart(oldval);
 		if (builtin_cart_old != builtin_cart_new) {
 			if (builtin_cart_old == NULL && MEMORY_ram_size > 40) { /* switching RAM out */
+#ifndef PAGED_ROM
 				memcpy(under_cartA0BF, MEMORY_mem + 0xa000, 0x2000);
+#endif
 				MEMORY_SetROM(0xa000, 0xbfff);
 			}
 			if (builtin_cart_new == NULL) { /* switching RAM in */
 				if (MEMORY_ram_size > 40) {
+#ifndef PAGED_ROM
 					memcpy(MEMORY_mem + 0xa000, under_cartA0BF, 0x2000);
+#endif
 					MEMORY_SetRAM(0xa000, 0xbfff);
 				}
 				else
 					MEMORY_dFillMem(0xa000, 0xff, 0x2000);
 			}
 			else
-				memcpy(MEMORY_mem + 0xa000, builtin_cart_new, 0x2000);
+				MEMORY_CopyROM(0xa000, 0xbfff, builtin_cart_new);
 		}
 	}
 
@@ -888,10 +1313,12 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 		if (MEMORY_selftest_enabled) {
 			/* Disable Self Test ROM */
 			if (MEMORY_ram_size > 20) {
-				Map_memcpy(MEMORY_mem + 0x5000, under_atarixl_os + 0x1000, 0x800);
-				if (ANTIC_xe_ptr != NULL)
+#ifndef PAGED_ROM
+				Map_memcpy(XE_CPU_MEM(0x5000), under_atarixl_os + 0x1000, 0x800);
+#endif
+				if (AnticOnlyBank(antic_bank) != NULL)
 					/* Also disable Self Test from XE bank accessed by ANTIC. */
-					memcpy(atarixe_memory + (antic_bank << 14) + 0x1000, antic_bank_under_selftest, 0x800);
+					memcpy(AnticOnlyBank(antic_bank) + 0x1000, antic_bank_under_selftest, 0x800);
 				MEMORY_SetRAM(0x5000, 0x57ff);
 			}
 			else
@@ -908,22 +1335,32 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 		&& !((byte & 0x10) == 0 && MEMORY_ram_size == 1088)) {
 			/* Enable Self Test ROM */
 			if (MEMORY_ram_size > 20) {
-				Map_memcpy(under_atarixl_os + 0x1000, MEMORY_mem + 0x5000, 0x800);
-				if (ANTIC_xe_ptr != NULL)
+#ifndef PAGED_ROM
+				Map_memcpy(under_atarixl_os + 0x1000, XE_CPU_MEM(0x5000), 0x800);
+#endif
+				if (AnticOnlyBank(antic_bank) != NULL)
 					/* Also backup RAM under Self Test from XE bank accessed by ANTIC. */
-					memcpy(antic_bank_under_selftest, atarixe_memory + (antic_bank << 14) + 0x1000, 0x800);
+					memcpy(antic_bank_under_selftest, AnticOnlyBank(antic_bank) + 0x1000, 0x800);
 				MEMORY_SetROM(0x5000, 0x57ff);
 			}
-			memcpy(MEMORY_mem + 0x5000, MEMORY_os + 0x1000, 0x800);
-			if (ANTIC_xe_ptr != NULL)
+#ifdef PAGED_ROM
+			MEMORY_MapROM(0x5000, 0x57ff, MEMORY_os + 0x1000);
+#else
+			memcpy(XE_CPU_MEM(0x5000), MEMORY_os + 0x1000, 0x800);
+#endif
+			if (AnticOnlyBank(antic_bank) != NULL)
 				/* Also enable Self Test in the XE bank accessed by ANTIC. */
-				memcpy(atarixe_memory + (antic_bank << 14) + 0x1000, MEMORY_os + 0x1000, 0x800);
+				memcpy(AnticOnlyBank(antic_bank) + 0x1000, MEMORY_os + 0x1000, 0x800);
 			MEMORY_selftest_enabled = TRUE;
 		}
 		else if (!mapram_selected && new_mapram_selected) {
 			/* Enable MapRAM */
-			Map_memcpy(under_atarixl_os + 0x1000, MEMORY_mem + 0x5000, 0x800);
-			memcpy(MEMORY_mem + 0x5000, mapram_memory, 0x800);
+#ifdef PAGED_ROM
+			MapPages(0x50, 8, mapram_memory);
+#else
+			Map_memcpy(under_atarixl_os + 0x1000, XE_CPU_MEM(0x5000), 0x800);
+			memcpy(XE_CPU_MEM(0x5000), mapram_memory, 0x800);
+#endif
 		}
 	}
 }
@@ -1012,7 +1449,9 @@ void MEMORY_Cart809fDisable(void)
 {
 	if (cart809F_enabled) {
 		if (MEMORY_ram_size > 32) {
+#ifndef PAGED_ROM
 			memcpy(MEMORY_mem + 0x8000, under_cart809F, 0x2000);
+#endif
 			MEMORY_SetRAM(0x8000, 0x9fff);
 		}
 		else
@@ -1025,7 +1464,9 @@ void MEMORY_Cart809fEnable(void)
 {
 	if (!cart809F_enabled) {
 		if (MEMORY_ram_size > 32) {
+#ifndef PAGED_ROM
 			memcpy(under_cart809F, MEMORY_mem + 0x8000, 0x2000);
+#endif
 			MEMORY_SetROM(0x8000, 0x9fff);
 		}
 		cart809F_enabled = TRUE;
@@ -1040,14 +1481,16 @@ void MEMORY_CartA0bfDisable(void)
 		UBYTE const *builtin = builtin_cart(PIA_PORTB | PIA_PORTB_mask);
 		if (builtin == NULL) { /* switch RAM in */
 			if (MEMORY_ram_size > 40) {
+#ifndef PAGED_ROM
 				memcpy(MEMORY_mem + 0xa000, under_cartA0BF, 0x2000);
+#endif
 				MEMORY_SetRAM(0xa000, 0xbfff);
 			}
 			else
 				MEMORY_dFillMem(0xa000, 0xff, 0x2000);
 		}
 		else
-			memcpy(MEMORY_mem + 0xa000, builtin, 0x2000);
+			MEMORY_CopyROM(0xa000, 0xbfff, builtin);
 		MEMORY_cartA0BF_enabled = FALSE;
 		if (Atari800_machine_type == Atari800_MACHINE_XLXE) {
 			GTIA_TRIG[3] = 0;
@@ -1064,7 +1507,9 @@ void MEMORY_CartA0bfEnable(void)
 		/* or accessing extended 576K or 1088K memory */
 		if (MEMORY_ram_size > 40 && builtin_cart(PIA_PORTB | PIA_PORTB_mask) == NULL) {
 			/* Back-up 0xa000-0xbfff RAM */
+#ifndef PAGED_ROM
 			memcpy(under_cartA0BF, MEMORY_mem + 0xa000, 0x2000);
+#endif
 			MEMORY_SetROM(0xa000, 0xbfff);
 		}
 		MEMORY_cartA0BF_enabled = TRUE;
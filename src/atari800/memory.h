@@ -6,6 +6,11 @@
 
 #include "atari.h"
 
+#if defined(PAGED_ROM) && !defined(PAGED_BANKS)
+#error "PAGED_ROM needs PAGED_BANKS"
+#endif
+
+#ifndef PAGED_BANKS
 #define MEMORY_dGetByte(x)				(MEMORY_mem[x])
 #define MEMORY_dPutByte(x, y)			(MEMORY_mem[x] = y)
 
@@ -34,6 +39,63 @@
 #define MEMORY_dCopyFromMem(from, to, size)	memcpy(to, MEMORY_mem + (from), size)
 #define MEMORY_dCopyToMem(from, to, size)		memcpy(MEMORY_mem + (to), from, size)
 #define MEMORY_dFillMem(addr1, value, length)	memset(MEMORY_mem + (addr1), value, length)
+#define MEMORY_CopyROM(addr1, addr2, src) memcpy(MEMORY_mem + (addr1), src, (addr2) - (addr1) + 1)
+#define MEMORY_PatchByte(addr, byte)	MEMORY_dPutByte(addr, byte)
+#define MEMORY_dPtr(addr)				(MEMORY_mem + (addr))
+
+#else /* PAGED_BANKS */
+
+/* CPU view of memory, one pointer per 256-byte page. All pages point into
+   MEMORY_mem except the XE bank window 0x4000-0x7fff, which PORTB switches
+   by changing the pointers instead of copying 16 KB. */
+extern UBYTE *MEMORY_page[256];
+
+#ifdef PAGED_ROM
+/* With PAGED_ROM, ROM pages are read straight from the ROM images and
+   MEMORY_mem keeps the RAM hidden under them, so writes go through a
+   separate table that sends ROM pages to a dummy page. */
+extern UBYTE *MEMORY_wpage[256];
+#else
+#define MEMORY_wpage MEMORY_page
+#endif
+
+/* functions rather than macros, callers pass arguments like S-- */
+static inline UBYTE MEMORY_PageGetByte(UWORD addr)
+{
+	return MEMORY_page[addr >> 8][addr & 0xff];
+}
+
+static inline void MEMORY_PagePutByte(UWORD addr, UBYTE byte)
+{
+	MEMORY_wpage[addr >> 8][addr & 0xff] = byte;
+}
+
+#define MEMORY_dGetByte(x)				MEMORY_PageGetByte(x)
+#define MEMORY_dPutByte(x, y)			MEMORY_PagePutByte(x, y)
+#define MEMORY_dGetWord(x)				(MEMORY_dGetByte(x) + (MEMORY_dGetByte((UWORD) ((x) + 1)) << 8))
+#define MEMORY_dPutWord(x, y)			(MEMORY_dPutByte(x, (UBYTE) (y)), MEMORY_dPutByte((UWORD) ((x) + 1), (UBYTE) ((y) >> 8)))
+#define MEMORY_dGetWordAligned(x)		MEMORY_dGetWord(x)
+#define MEMORY_dPutWordAligned(x, y)	MEMORY_dPutWord(x, y)
+
+void MEMORY_dCopyFromMem(UWORD from, UBYTE *to, int size);
+void MEMORY_dCopyToMem(const UBYTE *from, UWORD to, int size);
+void MEMORY_dFillMem(UWORD addr1, UBYTE value, int length);
+#ifdef PAGED_ROM
+/* Maps the pages of ADDR1-ADDR2 to SRC, which must stay valid while mapped. */
+void MEMORY_MapROM(UWORD addr1, UWORD addr2, const UBYTE *src);
+/* Maps ADDR1-ADDR2 back to the RAM under it. */
+void MEMORY_MapRAM(UWORD addr1, UWORD addr2);
+/* Changes a byte of ROM, copying its 2 KB block into SRAM first. */
+void MEMORY_PatchByte(UWORD addr, UBYTE byte);
+#define MEMORY_CopyROM(addr1, addr2, src) MEMORY_MapROM(addr1, addr2, src)
+#else
+#define MEMORY_CopyROM(addr1, addr2, src) MEMORY_dCopyToMem(src, addr1, (addr2) - (addr1) + 1)
+#define MEMORY_PatchByte(addr, byte)	MEMORY_dPutByte(addr, byte)
+#endif
+/* Pointer to ADDR, valid for accesses within its 2 KB-aligned block. */
+#define MEMORY_dPtr(addr)				(MEMORY_page[(UWORD) (addr) >> 8] + ((addr) & 0xff))
+
+#endif /* PAGED_BANKS */
 
 //extern UBYTE MEMORY_mem[65536 + 2];
 extern UBYTE* MEMORY_mem;
@@ -56,10 +118,10 @@ extern int MEMORY_ram_size;
 extern UBYTE MEMORY_attrib[65536];
 /* Reads a byte from ADDR. Can potentially have side effects, when reading
    from hardware area. */
-#define MEMORY_GetByte(addr)		(MEMORY_attrib[addr] == MEMORY_HARDWARE ? MEMORY_HwGetByte(addr, FALSE) : MEMORY_mem[addr])
+#define MEMORY_GetByte(addr)		(MEMORY_attrib[addr] == MEMORY_HARDWARE ? MEMORY_HwGetByte(addr, FALSE) : MEMORY_dGetByte(addr))
 /* Reads a byte from ADDR, but without any side effects. */
-#define MEMORY_SafeGetByte(addr)		(MEMORY_attrib[addr] == MEMORY_HARDWARE ? MEMORY_HwGetByte(addr, TRUE) : MEMORY_mem[addr])
-#define MEMORY_PutByte(addr, byte)	 do { if (MEMORY_attrib[addr] == MEMORY_RAM) MEMORY_mem[addr] = byte; else if (MEMORY_attrib[addr] == MEMORY_HARDWARE) MEMORY_HwPutByte(addr, byte); } while (0)
+#define MEMORY_SafeGetByte(addr)		(MEMORY_attrib[addr] == MEMORY_HARDWARE ? MEMORY_HwGetByte(addr, TRUE) : MEMORY_dGetByte(addr))
+#define MEMORY_PutByte(addr, byte)	 do { if (MEMORY_attrib[addr] == MEMORY_RAM) MEMORY_dPutByte(addr, byte); else if (MEMORY_attrib[addr] == MEMORY_HARDWARE) MEMORY_HwPutByte(addr, byte); } while (0)
 #define MEMORY_SetRAM(addr1, addr2) memset(MEMORY_attrib + (addr1), MEMORY_RAM, (addr2) - (addr1) + 1)
 #define MEMORY_SetROM(addr1, addr2) memset(MEMORY_attrib + (addr1), MEMORY_ROM, (addr2) - (addr1) + 1)
 #define MEMORY_SetHARDWARE(addr1, addr2) memset(MEMORY_attrib + (addr1), MEMORY_HARDWARE, (addr2) - (addr1) + 1)
@@ -74,17 +136,28 @@ extern MEMORY_wrfunc MEMORY_writemap[256];
 void MEMORY_ROM_PutByte(UWORD addr, UBYTE byte);
 /* Reads a byte from ADDR. Can potentially have side effects, when reading
    from hardware area. */
-#define MEMORY_GetByte(addr)		(MEMORY_readmap[(addr) >> 8] ? (*MEMORY_readmap[(addr) >> 8])(addr, FALSE) : MEMORY_mem[addr])
+#define MEMORY_GetByte(addr)		(MEMORY_readmap[(addr) >> 8] ? (*MEMORY_readmap[(addr) >> 8])(addr, FALSE) : MEMORY_dGetByte(addr))
 /* Reads a byte from ADDR, but without any side effects. */
-#define MEMORY_SafeGetByte(addr)		(MEMORY_readmap[(addr) >> 8] ? (*MEMORY_readmap[(addr) >> 8])(addr, TRUE) : MEMORY_mem[addr])
-#define MEMORY_PutByte(addr,byte)	(MEMORY_writemap[(addr) >> 8] ? ((*MEMORY_writemap[(addr) >> 8])(addr, byte), 0) : (MEMORY_mem[addr] = byte))
+#define MEMORY_SafeGetByte(addr)		(MEMORY_readmap[(addr) >> 8] ? (*MEMORY_readmap[(addr) >> 8])(addr, TRUE) : MEMORY_dGetByte(addr))
+#define MEMORY_PutByte(addr,byte)	(MEMORY_writemap[(addr) >> 8] ? ((*MEMORY_writemap[(addr) >> 8])(addr, byte), 0) : (MEMORY_dPutByte(addr, byte), 0))
+#ifdef PAGED_ROM
 #define MEMORY_SetRAM(addr1, addr2) do { \
 		int i; \
 		for (i = (addr1) >> 8; i <= (addr2) >> 8; i++) { \
 			MEMORY_readmap[i] = NULL; \
 			MEMORY_writemap[i] = NULL; \
 		} \
+		MEMORY_MapRAM(addr1, addr2); \
 	} while (0)
+#else
+#define MEMORY_SetRAM(addr1, addr2) do { \
+		int i; \
+		for (i = (addr1) >> 8; i <= (addr2) >> 8; i++) { \
+			MEMORY_readmap[i] = NULL; \
+			MEMORY_writemap[i] = NULL; \
+		} \
+	} while (0)
+#endif
 #define MEMORY_SetROM(addr1, addr2) do { \
 		int i; \
 		for (i = (addr1) >> 8; i <= (addr2) >> 8; i++) { \
@@ -97,6 +170,8 @@ void MEMORY_ROM_PutByte(UWORD addr, UBYTE byte);
 
 //extern UBYTE* MEMORY_mem;           // dynamically allocate memory to limit size of statics
 extern UBYTE* under_atarixl_os;     // grr 16k
+extern UBYTE* under_cart809F;       // 8k each, RAM under the cartridge
+extern UBYTE* under_cartA0BF;
 extern const UBYTE* MEMORY_os;      // in rom on esp32
 
 #define TIGHT_MEM
@@ -125,9 +200,35 @@ void MEMORY_Cart809fDisable(void);
 void MEMORY_Cart809fEnable(void);
 void MEMORY_CartA0bfDisable(void);
 void MEMORY_CartA0bfEnable(void);
-#define MEMORY_CopyROM(addr1, addr2, src) memcpy(MEMORY_mem + (addr1), src, (addr2) - (addr1) + 1)
 void MEMORY_GetCharset(UBYTE *cs);
 
+/* Per-page access counters, used to decide which pages must stay in SRAM */
+#define MEMORY_HEAT_CPU_READ   0	/* 6502 data reads */
+#define MEMORY_HEAT_CPU_WRITE  1	/* 6502 data writes */
+#define MEMORY_HEAT_CPU_FETCH  2	/* 6502 instructions executed */
+#define MEMORY_HEAT_ANTIC      3	/* display list, screen, character set and PMG DMA */
+#define MEMORY_HEAT_HARDWARE   4	/* 6502 accesses dispatched to a handler */
+#define MEMORY_HEAT_TYPES      5
+
+#ifdef MEMORY_HEATMAP
+/* counts of the frame in progress */
+extern ULONG MEMORY_heat[MEMORY_HEAT_TYPES][256];
+/* counts of the last complete frame */
+extern ULONG MEMORY_heat_frame[MEMORY_HEAT_TYPES][256];
+/* counts since MEMORY_HeatReset */
+extern unsigned long long MEMORY_heat_session[MEMORY_HEAT_TYPES][256];
+
+#define MEMORY_HEAT(type, addr) (MEMORY_heat[type][(UWORD) (addr) >> 8]++)
+/* Counts LEN bytes read by ANTIC from ADDR on, wrapping at 4 KB like ANTIC. */
+void MEMORY_HeatSpan(int type, UWORD addr, int len);
+/* Closes the current frame's counters. */
+void MEMORY_HeatFrame(void);
+void MEMORY_HeatReset(void);
+#else
+#define MEMORY_HEAT(type, addr)
+#define MEMORY_HeatSpan(type, addr, len)
+#endif /* MEMORY_HEATMAP */
+
 /* Mosaic and Axlon 400/800 RAM extensions */
 extern int MEMORY_mosaic_num_banks;
 extern int MEMORY_axlon_0f_mirror;
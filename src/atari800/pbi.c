@@ -242,7 +242,7 @@ void PBI_D1PutByte(UWORD addr, UBYTE byte)
 		    /* add more devices here... */
 			/* reactivate the floating point rom */
 			if (!fp_active) {
-				memcpy(MEMORY_mem + 0xd800, MEMORY_os + 0x1800, 0x800);
+				MEMORY_CopyROM(0xd800, 0xdfff, MEMORY_os + 0x1800);
 				D(printf("Floating point rom activated\n"));
 				fp_active = TRUE;
 			}
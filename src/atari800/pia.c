@@ -399,3 +399,17 @@ void PIA_StateRead(UBYTE version)
 }
 
 #endif /* BASIC */
+
+#ifdef LIBATARI800
+void PIA_GetState(pia_state_t *state)
+{
+	state->PACTL = PIA_PACTL;
+	state->PBCTL = PIA_PBCTL;
+	state->PORTA = PIA_PORTA;
+	state->PORTB = PIA_PORTB;
+	state->PORTA_mask = PIA_PORTA_mask;
+	state->PORTB_mask = PIA_PORTB_mask;
+	state->CA2 = PIA_CA2;
+	state->CB2 = PIA_CB2;
+}
+#endif /* LIBATARI800 */
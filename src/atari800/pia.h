@@ -25,5 +25,9 @@ UBYTE PIA_GetByte(UWORD addr, int no_side_effects);
 void PIA_PutByte(UWORD addr, UBYTE byte);
 void PIA_StateSave(void);
 void PIA_StateRead(UBYTE version);
+#ifdef LIBATARI800
+#include "libatari800.h"
+void PIA_GetState(pia_state_t *state);
+#endif
 
 #endif /* PIA_H_ */
@@ -23,6 +23,7 @@
 */
 
 #include "config.h"
+#include <string.h>
 #ifdef HAVE_TIME_H
 #include <time.h>
 #endif
@@ -1485,7 +1486,9 @@ int POKEY_Initialise(int *argc, char *argv[])
 #endif
 	{
 		random_scanline_counter =
-#ifdef HAVE_WINDOWS_H
+#ifdef POKEY_RANDOM_SEED
+		POKEY_RANDOM_SEED % POKEY_POLY17_SIZE;
+#elif defined(HAVE_WINDOWS_H)
 		GetTickCount() % POKEY_POLY17_SIZE;
 #elif defined(HAVE_TIME)
 		time(NULL) % POKEY_POLY17_SIZE;
@@ -1764,3 +1767,40 @@ void POKEY_StateRead(void)
 }
 
 #endif
+
+#ifdef LIBATARI800
+void POKEY_GetState(pokey_state_t *state)
+{
+	int chips = 1;
+	int i;
+
+#ifdef STEREO_SOUND
+	chips = POKEY_MAXPOKEYS;
+#endif
+	memset(state, 0, sizeof(pokey_state_t));
+	state->KBCODE = POKEY_KBCODE;
+	state->IRQST = POKEY_IRQST;
+	state->IRQEN = POKEY_IRQEN;
+	state->SKCTL = POKEY_SKCTL;
+
+	/* SKSTAT bits 3 and 2 are low while Shift and a key are held */
+	state->shift_key = !(POKEY_SKSTAT & 0x08);
+	state->keypressed = !(POKEY_SKSTAT & 0x04);
+	state->DELAYED_SERIN_IRQ = POKEY_DELAYED_SERIN_IRQ;
+	state->DELAYED_SEROUT_IRQ = POKEY_DELAYED_SEROUT_IRQ;
+	state->DELAYED_XMTDONE_IRQ = POKEY_DELAYED_XMTDONE_IRQ;
+
+	for (i = 0; i < 4 * chips; i++) {
+		state->AUDF[i] = POKEY_AUDF[i];
+		state->AUDC[i] = POKEY_AUDC[i];
+	}
+	for (i = 0; i < chips; i++) {
+		state->AUDCTL[i] = POKEY_AUDCTL[i];
+		state->Base_mult[i] = POKEY_Base_mult[i];
+	}
+	for (i = 0; i < 4; i++) {
+		state->DivNIRQ[i] = POKEY_DivNIRQ[i];
+		state->DivNMax[i] = POKEY_DivNMax[i];
+	}
+}
+#endif /* LIBATARI800 */
@@ -62,6 +62,10 @@ void POKEY_Frame(void);
 void POKEY_Scanline(void);
 void POKEY_StateSave(void);
 void POKEY_StateRead(void);
+#ifdef LIBATARI800
+#include "libatari800.h"
+void POKEY_GetState(pokey_state_t *state);
+#endif
 
 #endif
 
@@ -25,6 +25,9 @@
 #include "config.h"
 #include <stdlib.h>
 #include <math.h>
+#ifndef PICO_ON_DEVICE
+#include <sched.h>
+#endif
 
 #ifdef ASAP /* external project, see http://asap.sf.net */
 #include "asap_internal.h"
@@ -45,6 +48,14 @@
 #include "gtia.h"
 #include "util.h"
 
+/* POKEYSND_LogRender may run on the other core */
+#ifdef PICO_ON_DEVICE
+#include <pico/platform.h>
+#define LOG_WAIT_IDLE() tight_loop_contents()
+#else
+#define LOG_WAIT_IDLE() sched_yield()
+#endif
+
 #ifdef WORDS_UNALIGNED_OK
 #  define READ_U32(x)     (*(ULONG *) (x))
 #  define WRITE_U32(x, d) (*(ULONG *) (x) = (d))
@@ -85,6 +96,14 @@ static UBYTE Outbit[4 * POKEY_MAXPOKEYS];		/* current state of the output (high
 
 static UBYTE Outvol[4 * POKEY_MAXPOKEYS];		/* last output volume for each channel */
 
+/* AUDF, AUDC and AUDCTL as the synthesis sees them.  They follow the writes
+   given to Update_pokey_sound_rf rather than the registers, which with the
+   write log (POKEYSND_SetLog) are ahead of the sound being rendered. */
+static UBYTE snd_AUDF[4 * POKEY_MAXPOKEYS];
+static UBYTE snd_AUDC[4 * POKEY_MAXPOKEYS];
+static UBYTE snd_AUDCTL[POKEY_MAXPOKEYS];
+static int snd_Base_mult[POKEY_MAXPOKEYS];		/* from snd_AUDCTL, as POKEY_Base_mult */
+
 /* Initialize the bit patterns for the polynomials. */
 
 /* The 4bit and 5bit patterns are the identical ones used in the pokey chip. */
@@ -117,6 +136,72 @@ static ULONG Div_n_cnt[4 * POKEY_MAXPOKEYS],		/* Divide by n counter. one for ea
 static ULONG Samp_n_max,		/* Sample max.  For accuracy, it is *256 */
  Samp_n_cnt[2];					/* Sample cnt. */
 
+#ifndef CLIP_SOUND
+static int hp_lp[2];			/* high-pass state of the output, per channel */
+#endif
+
+#if !defined(CLIP_SOUND) && !defined(INTERPOLATE_SOUND) && !defined(SYNCHRONIZED_SOUND) && !defined(__PLUS)
+#define NATIVE_MIX				/* see pokeysnd_process_mix */
+#endif
+
+#ifdef NATIVE_MIX
+#define BAND_TAPS 16
+#define BAND_PHASES 32
+
+/* The band-limited step: how far the sample TAP samples on from a step is
+   still short of it, for steps PHASE / BAND_PHASES sample before the first
+   one; 1.0 is 1 << 14.  Steps between two phases take both, weighted.  The
+   step is the integral of a sinc cut at 0.42 of the sample rate under a
+   Kaiser window (beta 8) 16 samples wide, centred 8 samples on. */
+static const SWORD blep_table[BAND_PHASES + 1][BAND_TAPS] = {
+	{-16384, -16381, -16409, -16312, -16503, -16311, -16161, -17500, -8192, 1116, -223, -73, 119, -72, 25, -3},
+	{-16384, -16382, -16409, -16309, -16517, -16279, -16217, -17419, -7762, 1183, -275, -42, 106, -68, 25, -3},
+	{-16384, -16382, -16409, -16305, -16530, -16246, -16277, -17324, -7333, 1237, -323, -12, 92, -64, 24, -3},
+	{-16384, -16382, -16409, -16303, -16543, -16213, -16341, -17214, -6906, 1278, -367, 16, 78, -59, 23, -3},
+	{-16384, -16383, -16408, -16300, -16555, -16180, -16408, -17090, -6482, 1307, -406, 44, 65, -55, 23, -3},
+	{-16384, -16383, -16408, -16298, -16567, -16147, -16478, -16951, -6063, 1325, -440, 70, 51, -50, 22, -3},
+	{-16384, -16384, -16407, -16297, -16577, -16114, -16551, -16796, -5648, 1331, -470, 94, 38, -45, 21, -3},
+	{-16384, -16384, -16406, -16296, -16587, -16082, -16626, -16626, -5239, 1327, -495, 116, 25, -40, 20, -3},
+	{-16383, -16385, -16404, -16296, -16596, -16050, -16702, -16441, -4837, 1313, -515, 137, 13, -35, 18, -3},
+	{-16383, -16386, -16403, -16297, -16604, -16020, -16780, -16240, -4443, 1290, -531, 156, 1, -31, 17, -3},
+	{-16383, -16386, -16401, -16298, -16610, -15991, -16859, -16024, -4058, 1258, -543, 173, -10, -26, 16, -3},
+	{-16383, -16387, -16399, -16300, -16615, -15963, -16938, -15793, -3682, 1219, -550, 188, -20, -21, 15, -3},
+	{-16383, -16388, -16396, -16303, -16619, -15937, -17016, -15546, -3316, 1173, -553, 201, -30, -17, 14, -2},
+	{-16383, -16389, -16393, -16307, -16621, -15914, -17094, -15285, -2962, 1120, -551, 212, -39, -12, 12, -2},
+	{-16383, -16390, -16390, -16311, -16621, -15893, -17170, -15009, -2619, 1062, -546, 221, -48, -8, 11, -2},
+	{-16382, -16391, -16387, -16316, -16620, -15874, -17244, -14718, -2288, 999, -537, 228, -55, -4, 10, -2},
+	{-16382, -16393, -16384, -16322, -16617, -15859, -17315, -14414, -1970, 931, -525, 233, -62, 0, 9, -2},
+	{-16382, -16394, -16380, -16329, -16612, -15847, -17383, -14096, -1666, 860, -510, 236, -68, 3, 7, -2},
+	{-16382, -16395, -16376, -16336, -16605, -15838, -17446, -13765, -1375, 786, -491, 237, -73, 6, 6, -1},
+	{-16382, -16396, -16372, -16345, -16596, -15833, -17504, -13422, -1099, 710, -470, 237, -77, 9, 5, -1},
+	{-16382, -16398, -16367, -16354, -16585, -15831, -17557, -13068, -838, 632, -447, 235, -81, 12, 4, -1},
+	{-16381, -16399, -16363, -16364, -16572, -15834, -17603, -12702, -591, 554, -421, 231, -84, 15, 3, -1},
+	{-16381, -16400, -16358, -16374, -16557, -15841, -17642, -12326, -360, 475, -393, 226, -86, 17, 2, -1},
+	{-16381, -16401, -16353, -16385, -16540, -15853, -17674, -11941, -144, 396, -364, 220, -87, 19, 2, -1},
+	{-16381, -16402, -16349, -16397, -16521, -15869, -17697, -11547, 57, 318, -334, 212, -88, 20, 1, -1},
+	{-16381, -16404, -16344, -16409, -16500, -15889, -17711, -11145, 242, 242, -302, 203, -88, 22, 0, 0},
+	{-16381, -16405, -16339, -16422, -16478, -15914, -17715, -10736, 412, 167, -270, 193, -87, 23, 0, 0},
+	{-16381, -16406, -16334, -16435, -16454, -15944, -17709, -10321, 567, 94, -237, 183, -86, 24, -1, 0},
+	{-16381, -16407, -16329, -16449, -16428, -15978, -17691, -9902, 706, 24, -204, 171, -84, 24, -1, 0},
+	{-16381, -16407, -16325, -16462, -16400, -16017, -17662, -9478, 830, -43, -171, 159, -81, 25, -2, 0},
+	{-16381, -16408, -16320, -16476, -16372, -16061, -17621, -9051, 940, -107, -138, 146, -79, 25, -2, 0},
+	{-16381, -16409, -16316, -16490, -16342, -16109, -17567, -8622, 1035, -167, -105, 133, -75, 25, -2, 0},
+	{-16381, -16409, -16312, -16503, -16311, -16161, -17500, -8192, 1116, -223, -73, 119, -72, 25, -3, 0}
+};
+
+/* Steps of the channel outputs on their way into the samples, per output
+   channel (POKEYSND_RESAMPLE_BOX and POKEYSND_RESAMPLE_BLEP) */
+typedef struct {
+	int chans;				/* the channel outputs summed, at the last call end */
+	int vol;				/* the volume-only output */
+	int pos;				/* ring index of the next sample */
+	int ring[BAND_TAPS];	/* what each next sample still lacks of the steps */
+} band_t;
+static band_t band[2];
+static ULONG band_recip;	/* (1 << 24) / Samp_n_max */
+static ULONG band_span;		/* steps further back from a sample are settled in it */
+#endif /* NATIVE_MIX */
+
 #ifdef INTERPOLATE_SOUND
 #ifdef CLIP_SOUND
 static SWORD last_val = 0;		/* last output value */
@@ -178,10 +263,14 @@ int POKEYSND_stereo_enabled = FALSE;
 #endif
 
 int POKEYSND_volume = 0x100;
+int POKEYSND_resample = POKEYSND_RESAMPLE_NEAREST;
 
 /* multiple sound engine interface */
 static void pokeysnd_process_8(void *sndbuffer, int sndn);
 static void pokeysnd_process_16(void *sndbuffer, int sndn);
+#ifdef NATIVE_MIX
+static void pokeysnd_process_8_band(void *sndbuffer, int sndn);
+#endif
 static void null_pokey_process(void *sndbuffer, int sndn) {}
 void (*POKEYSND_Process_ptr)(void *sndbuffer, int sndn) = null_pokey_process;
 
@@ -226,6 +315,53 @@ static int speaker;
 static int const CONSOLE_VOL = 32;
 #endif /* SYNCHRONIZED_SOUND */
 
+/* Timestamped write log, see POKEYSND_SetLog.  The emulation appends to the
+   log and closes a frame of it at every frame end; POKEYSND_LogRender, which
+   may run on another core, takes closed frames from the other end.  Each
+   side owns one counter, so they need no lock between them. */
+typedef struct {
+	UWORD cycle;	/* CPU cycles since the frame start */
+	UBYTE reg;		/* chip << 4 | POKEY_OFFSET_*, or one of LOG_* */
+	UBYTE val;
+} log_entry_t;
+
+#define LOG_SERIO	0x20	/* serial sound, val: the byte */
+#define LOG_CONSOL	0x30	/* | set; console speaker, val: GTIA_speaker */
+#define LOG_FRAME	0xff	/* frame end, cycle: the frame length */
+
+/* A frame whose writes do not fit gets the registers as they are at its end
+   instead, which must always fit along with the frame end. */
+#define LOG_RESERVE	(9 * POKEY_MAXPOKEYS + 1)
+
+/* The console click fades out within 32 lines after the speaker changes
+   (Update_consol_sound_rf), so later updates do nothing until it changes
+   again. */
+#define LOG_CONSOL_FADE	(40 * 114)
+
+static int log_mode = POKEYSND_LOG_OFF;
+static log_entry_t *log_entries = NULL;
+static unsigned int log_head = 0;			/* by the emulation only */
+static volatile unsigned int log_tail = 0;	/* by POKEYSND_LogRender only */
+static volatile unsigned int log_frames = 0;	/* frames closed */
+static volatile unsigned int log_rendered = 0;	/* frames rendered */
+static unsigned int log_frame_start;		/* ANTIC_CPU_CLOCK at the frame start */
+static int log_overflow = FALSE;			/* the writes of this frame did not fit */
+static unsigned int log_consol_clock;		/* last change of the speaker */
+static int log_consol_speaker;
+static volatile UBYTE log_gain;			/* the same for every write (SOUND_GAIN) */
+static unsigned int log_base;				/* CPU clock at the start of the frame being rendered */
+static unsigned int log_clock;				/* and of the write being applied */
+
+static unsigned long long log_writes = 0;
+static unsigned long long log_overflows = 0;
+static unsigned int log_max_queued = 0;
+
+/* The CPU clock the volume-only sound is timed by */
+#define SND_CLOCK (log_mode != POKEYSND_LOG_OFF ? log_clock : ANTIC_CPU_CLOCK)
+
+static void log_hook(void);
+static void log_drain(void);
+
 /*****************************************************************************/
 /* In my routines, I treat the sample output as another divide by N counter  */
 /* For better accuracy, the Samp_n_cnt has a fixed binary decimal point      */
@@ -404,6 +540,11 @@ static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
 {
 	UBYTE chan;
 
+	/* the state reset below is POKEYSND_LogRender's, which may be running on
+	   the other core */
+	if (log_mode != POKEYSND_LOG_OFF)
+		log_drain();
+
 	POKEYSND_Update_ptr = Update_pokey_sound_rf;
 #ifdef SERIO_SOUND
 	POKEYSND_UpdateSerio = Update_serio_sound_rf;
@@ -416,6 +557,10 @@ static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
 #endif
 
 	POKEYSND_Process_ptr = (flags & POKEYSND_BIT16) ? pokeysnd_process_16 : pokeysnd_process_8;
+#ifdef NATIVE_MIX
+	if (POKEYSND_resample != POKEYSND_RESAMPLE_NEAREST && !(flags & POKEYSND_BIT16))
+		POKEYSND_Process_ptr = pokeysnd_process_8_band;
+#endif
 
 #ifdef VOL_ONLY_SOUND
 	POKEYSND_samp_freq = playback_freq;
@@ -432,6 +577,21 @@ static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
 
 	Samp_n_cnt[0] = 0;			/* initialize all bits of the sample */
 	Samp_n_cnt[1] = 0;			/* 'divide by N' counter */
+#ifndef CLIP_SOUND
+	hp_lp[0] = hp_lp[1] = 0;
+#endif
+#ifdef NATIVE_MIX
+	for (chan = 0; chan < 2; chan++) {
+		int i;
+		band[chan].chans = 0;
+		band[chan].vol = 0;
+		band[chan].pos = 0;
+		for (i = 0; i < BAND_TAPS; i++)
+			band[chan].ring[i] = 0;
+	}
+	band_recip = (1UL << 24) / Samp_n_max;
+	band_span = POKEYSND_resample == POKEYSND_RESAMPLE_BOX ? Samp_n_max : BAND_TAPS / 2 * Samp_n_max;
+#endif
 
 	for (chan = 0; chan < (POKEY_MAXPOKEYS * 4); chan++) {
 		Outvol[chan] = 0;
@@ -439,17 +599,26 @@ static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
 		Div_n_cnt[chan] = 0;
 		Div_n_max[chan] = 0x7fffffffL;
 		pokeysnd_AUDV[chan] = 0;
+		snd_AUDF[chan] = POKEY_AUDF[chan];
+		snd_AUDC[chan] = POKEY_AUDC[chan];
 #ifdef VOL_ONLY_SOUND
 		POKEYSND_sampbuf_AUDV[chan] = 0;
 #endif
 	}
 
+	for (chan = 0; chan < POKEY_MAXPOKEYS; chan++) {
+		snd_AUDCTL[chan] = POKEY_AUDCTL[chan];
+		snd_Base_mult[chan] = POKEY_Base_mult[chan];
+	}
+
 	/* set the number of pokey chips currently emulated */
 	Num_pokeys = num_pokeys;
 
 #ifdef SYNCHRONIZED_SOUND
 	init_syncsound();
 #endif
+	if (log_mode != POKEYSND_LOG_OFF)
+		log_hook();
 	return 0; /* OK */
 }
 
@@ -495,47 +664,49 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 	/* determine which address was changed */
 	switch (addr & 0x0f) {
 	case POKEY_OFFSET_AUDF1:
-		/* POKEY_AUDF[POKEY_CHAN1 + chip_offs] = val; */
+		snd_AUDF[POKEY_CHAN1 + chip_offs] = val;
 		chan_mask = 1 << POKEY_CHAN1;
-		if (POKEY_AUDCTL[chip] & POKEY_CH1_CH2)		/* if ch 1&2 tied together */
+		if (snd_AUDCTL[chip] & POKEY_CH1_CH2)		/* if ch 1&2 tied together */
 			chan_mask |= 1 << POKEY_CHAN2;	/* then also change on ch2 */
 		break;
 	case POKEY_OFFSET_AUDC1:
-		/* POKEY_AUDC[POKEY_CHAN1 + chip_offs] = val; */
+		snd_AUDC[POKEY_CHAN1 + chip_offs] = val;
 		pokeysnd_AUDV[POKEY_CHAN1 + chip_offs] = (val & POKEY_VOLUME_MASK) * gain;
 		chan_mask = 1 << POKEY_CHAN1;
 		break;
 	case POKEY_OFFSET_AUDF2:
-		/* POKEY_AUDF[POKEY_CHAN2 + chip_offs] = val; */
+		snd_AUDF[POKEY_CHAN2 + chip_offs] = val;
 		chan_mask = 1 << POKEY_CHAN2;
 		break;
 	case POKEY_OFFSET_AUDC2:
-		/* POKEY_AUDC[POKEY_CHAN2 + chip_offs] = val; */
+		snd_AUDC[POKEY_CHAN2 + chip_offs] = val;
 		pokeysnd_AUDV[POKEY_CHAN2 + chip_offs] = (val & POKEY_VOLUME_MASK) * gain;
 		chan_mask = 1 << POKEY_CHAN2;
 		break;
 	case POKEY_OFFSET_AUDF3:
-		/* POKEY_AUDF[POKEY_CHAN3 + chip_offs] = val; */
+		snd_AUDF[POKEY_CHAN3 + chip_offs] = val;
 		chan_mask = 1 << POKEY_CHAN3;
-		if (POKEY_AUDCTL[chip] & POKEY_CH3_CH4)		/* if ch 3&4 tied together */
+		if (snd_AUDCTL[chip] & POKEY_CH3_CH4)		/* if ch 3&4 tied together */
 			chan_mask |= 1 << POKEY_CHAN4;	/* then also change on ch4 */
 		break;
 	case POKEY_OFFSET_AUDC3:
-		/* POKEY_AUDC[POKEY_CHAN3 + chip_offs] = val; */
+		snd_AUDC[POKEY_CHAN3 + chip_offs] = val;
 		pokeysnd_AUDV[POKEY_CHAN3 + chip_offs] = (val & POKEY_VOLUME_MASK) * gain;
 		chan_mask = 1 << POKEY_CHAN3;
 		break;
 	case POKEY_OFFSET_AUDF4:
-		/* POKEY_AUDF[POKEY_CHAN4 + chip_offs] = val; */
+		snd_AUDF[POKEY_CHAN4 + chip_offs] = val;
 		chan_mask = 1 << POKEY_CHAN4;
 		break;
 	case POKEY_OFFSET_AUDC4:
-		/* POKEY_AUDC[POKEY_CHAN4 + chip_offs] = val; */
+		snd_AUDC[POKEY_CHAN4 + chip_offs] = val;
 		pokeysnd_AUDV[POKEY_CHAN4 + chip_offs] = (val & POKEY_VOLUME_MASK) * gain;
 		chan_mask = 1 << POKEY_CHAN4;
 		break;
 	case POKEY_OFFSET_AUDCTL:
-		/* POKEY_AUDCTL[chip] = val; */
+		snd_AUDCTL[chip] = val;
+		/* determine the base multiplier for the 'div by n' calculations */
+		snd_Base_mult[chip] = (val & POKEY_CLOCK_15) ? POKEY_DIV_15 : POKEY_DIV_64;
 		chan_mask = 15;			/* all channels */
 		break;
 	default:
@@ -555,10 +726,10 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 
 	if (chan_mask & (1 << POKEY_CHAN1)) {
 		/* process channel 1 frequency */
-		if (POKEY_AUDCTL[chip] & POKEY_CH1_179)
-			new_val = POKEY_AUDF[POKEY_CHAN1 + chip_offs] + 4;
+		if (snd_AUDCTL[chip] & POKEY_CH1_179)
+			new_val = snd_AUDF[POKEY_CHAN1 + chip_offs] + 4;
 		else
-			new_val = (POKEY_AUDF[POKEY_CHAN1 + chip_offs] + 1) * POKEY_Base_mult[chip];
+			new_val = (snd_AUDF[POKEY_CHAN1 + chip_offs] + 1) * snd_Base_mult[chip];
 
 		if (new_val != Div_n_max[POKEY_CHAN1 + chip_offs]) {
 			Div_n_max[POKEY_CHAN1 + chip_offs] = new_val;
@@ -571,16 +742,16 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 
 	if (chan_mask & (1 << POKEY_CHAN2)) {
 		/* process channel 2 frequency */
-		if (POKEY_AUDCTL[chip] & POKEY_CH1_CH2) {
-			if (POKEY_AUDCTL[chip] & POKEY_CH1_179)
-				new_val = POKEY_AUDF[POKEY_CHAN2 + chip_offs] * 256 +
-					POKEY_AUDF[POKEY_CHAN1 + chip_offs] + 7;
+		if (snd_AUDCTL[chip] & POKEY_CH1_CH2) {
+			if (snd_AUDCTL[chip] & POKEY_CH1_179)
+				new_val = snd_AUDF[POKEY_CHAN2 + chip_offs] * 256 +
+					snd_AUDF[POKEY_CHAN1 + chip_offs] + 7;
 			else
-				new_val = (POKEY_AUDF[POKEY_CHAN2 + chip_offs] * 256 +
-						   POKEY_AUDF[POKEY_CHAN1 + chip_offs] + 1) * POKEY_Base_mult[chip];
+				new_val = (snd_AUDF[POKEY_CHAN2 + chip_offs] * 256 +
+						   snd_AUDF[POKEY_CHAN1 + chip_offs] + 1) * snd_Base_mult[chip];
 		}
 		else
-			new_val = (POKEY_AUDF[POKEY_CHAN2 + chip_offs] + 1) * POKEY_Base_mult[chip];
+			new_val = (snd_AUDF[POKEY_CHAN2 + chip_offs] + 1) * snd_Base_mult[chip];
 
 		if (new_val != Div_n_max[POKEY_CHAN2 + chip_offs]) {
 			Div_n_max[POKEY_CHAN2 + chip_offs] = new_val;
@@ -593,10 +764,10 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 
 	if (chan_mask & (1 << POKEY_CHAN3)) {
 		/* process channel 3 frequency */
-		if (POKEY_AUDCTL[chip] & POKEY_CH3_179)
-			new_val = POKEY_AUDF[POKEY_CHAN3 + chip_offs] + 4;
+		if (snd_AUDCTL[chip] & POKEY_CH3_179)
+			new_val = snd_AUDF[POKEY_CHAN3 + chip_offs] + 4;
 		else
-			new_val = (POKEY_AUDF[POKEY_CHAN3 + chip_offs] + 1) * POKEY_Base_mult[chip];
+			new_val = (snd_AUDF[POKEY_CHAN3 + chip_offs] + 1) * snd_Base_mult[chip];
 
 		if (new_val != Div_n_max[POKEY_CHAN3 + chip_offs]) {
 			Div_n_max[POKEY_CHAN3 + chip_offs] = new_val;
@@ -609,16 +780,16 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 
 	if (chan_mask & (1 << POKEY_CHAN4)) {
 		/* process channel 4 frequency */
-		if (POKEY_AUDCTL[chip] & POKEY_CH3_CH4) {
-			if (POKEY_AUDCTL[chip] & POKEY_CH3_179)
-				new_val = POKEY_AUDF[POKEY_CHAN4 + chip_offs] * 256 +
-					POKEY_AUDF[POKEY_CHAN3 + chip_offs] + 7;
+		if (snd_AUDCTL[chip] & POKEY_CH3_CH4) {
+			if (snd_AUDCTL[chip] & POKEY_CH3_179)
+				new_val = snd_AUDF[POKEY_CHAN4 + chip_offs] * 256 +
+					snd_AUDF[POKEY_CHAN3 + chip_offs] + 7;
 			else
-				new_val = (POKEY_AUDF[POKEY_CHAN4 + chip_offs] * 256 +
-						   POKEY_AUDF[POKEY_CHAN3 + chip_offs] + 1) * POKEY_Base_mult[chip];
+				new_val = (snd_AUDF[POKEY_CHAN4 + chip_offs] * 256 +
+						   snd_AUDF[POKEY_CHAN3 + chip_offs] + 1) * snd_Base_mult[chip];
 		}
 		else
-			new_val = (POKEY_AUDF[POKEY_CHAN4 + chip_offs] + 1) * POKEY_Base_mult[chip];
+			new_val = (snd_AUDF[POKEY_CHAN4 + chip_offs] + 1) * snd_Base_mult[chip];
 
 		if (new_val != Div_n_max[POKEY_CHAN4 + chip_offs]) {
 			Div_n_max[POKEY_CHAN4 + chip_offs] = new_val;
@@ -638,7 +809,7 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 #ifdef __PLUS
 			if (g_Sound.nDigitized)
 #endif
-			if ((POKEY_AUDC[chan + chip_offs] & POKEY_VOL_ONLY)) {
+			if ((snd_AUDC[chan + chip_offs] & POKEY_VOL_ONLY)) {
 
 #ifdef STEREO_SOUND
 
@@ -654,8 +825,8 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 					sampbuf_val2[sampbuf_ptr2] = sampbuf_lastval2;
 					POKEYSND_sampbuf_AUDV[chan + chip_offs] = pokeysnd_AUDV[chan + chip_offs];
 					sampbuf_cnt2[sampbuf_ptr2] =
-						(ANTIC_CPU_CLOCK - sampbuf_last2) * 128 * POKEYSND_samp_freq / 178979;
-					sampbuf_last2 = ANTIC_CPU_CLOCK;
+						(SND_CLOCK - sampbuf_last2) * 128 * POKEYSND_samp_freq / 178979;
+					sampbuf_last2 = SND_CLOCK;
 					sampbuf_ptr2++;
 					if (sampbuf_ptr2 >= POKEYSND_SAMPBUF_MAX)
 						sampbuf_ptr2 = 0;
@@ -674,8 +845,8 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 					POKEYSND_sampbuf_val[POKEYSND_sampbuf_ptr] = POKEYSND_sampbuf_lastval;
 					POKEYSND_sampbuf_AUDV[chan + chip_offs] = pokeysnd_AUDV[chan + chip_offs];
 					POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_ptr] =
-						(ANTIC_CPU_CLOCK - POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
-					POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK;
+						(SND_CLOCK - POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
+					POKEYSND_sampbuf_last = SND_CLOCK;
 					POKEYSND_sampbuf_ptr++;
 					if (POKEYSND_sampbuf_ptr >= POKEYSND_SAMPBUF_MAX)
 						POKEYSND_sampbuf_ptr = 0;
@@ -697,16 +868,16 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 			/* if the channel is volume only */
 			/* or the channel is off (volume == 0) */
 			/* or the channel freq is greater than the playback freq */
-			if ( (POKEY_AUDC[chan + chip_offs] & POKEY_VOL_ONLY) ||
-				((POKEY_AUDC[chan + chip_offs] & POKEY_VOLUME_MASK) == 0)
+			if ( (snd_AUDC[chan + chip_offs] & POKEY_VOL_ONLY) ||
+				((snd_AUDC[chan + chip_offs] & POKEY_VOLUME_MASK) == 0)
 				|| (!BIENIAS_FIX && (Div_n_max[chan + chip_offs] < (Samp_n_max >> 8)))
 				) {
 				/* indicate the channel is 'on' */
 				Outvol[chan + chip_offs] = 1;
 
 				/* can only ignore channel if filtering off */
-				if ((chan == POKEY_CHAN3 && !(POKEY_AUDCTL[chip] & POKEY_CH1_FILTER)) ||
-					(chan == POKEY_CHAN4 && !(POKEY_AUDCTL[chip] & POKEY_CH2_FILTER)) ||
+				if ((chan == POKEY_CHAN3 && !(snd_AUDCTL[chip] & POKEY_CH1_FILTER)) ||
+					(chan == POKEY_CHAN4 && !(snd_AUDCTL[chip] & POKEY_CH2_FILTER)) ||
 					(chan == POKEY_CHAN1) ||
 					(chan == POKEY_CHAN2)
 					|| (!BIENIAS_FIX && (Div_n_max[chan + chip_offs] < (Samp_n_max >> 8)))
@@ -743,6 +914,22 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 /*                                                                           */
 /*****************************************************************************/
 
+#ifndef CLIP_SOUND
+/* The sum IOUT of the channels as an 8-bit unsigned sample */
+static int output_stage(int iout, int *lp)
+{
+	int s;
+	// stuck volume only sound can push iout to 276 in robot demo etc
+	// highpass to remove those funny dc biases
+	iout >>= 1;
+	*lp = (((*lp + iout) << 8) - *lp) >> 8;	// 255*_lp + iout*1
+	s = iout - (*lp >> 8) + 128;			// hipass to center on 128
+	if (s < 0) s = 0;
+	if (s > 255) s = 255;
+	return s;
+}
+#endif /* CLIP_SOUND */
+
 static void pokeysnd_process_8(void *sndbuffer, int sndn)
 {
 	register UBYTE *buffer = (UBYTE *) sndbuffer;
@@ -920,7 +1107,7 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 			Div_n_cnt[next_event] += Div_n_max[next_event];
 
 			/* get the current AUDC into a register (for optimization) */
-			audc = POKEY_AUDC[next_event];
+			audc = snd_AUDC[next_event];
 
 			/* set a pointer to the current output (for opt...) */
 			out_ptr = &Outvol[next_event];
@@ -949,7 +1136,7 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 					}
 					else {
 						/* if 9-bit poly is selected on this chip */
-						if (POKEY_AUDCTL[next_event >> 2] & POKEY_POLY9) {
+						if (snd_AUDCTL[next_event >> 2] & POKEY_POLY9) {
 							/* compare to the poly9 bit */
 							toggle = ((POKEY_poly9_lookup[P9] & 1) == !(*out_ptr));
 						}
@@ -962,7 +1149,7 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 			}
 
 			/* check channel 1 filter (clocked by channel 3) */
-			if ( POKEY_AUDCTL[next_event >> 2] & POKEY_CH1_FILTER) {
+			if ( snd_AUDCTL[next_event >> 2] & POKEY_CH1_FILTER) {
 				/* if we're processing channel 3 */
 				if ((next_event & 0x03) == POKEY_CHAN3) {
 					/* check output of channel 1 on same chip */
@@ -984,7 +1171,7 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 			}
 
 			/* check channel 2 filter (clocked by channel 4) */
-			if ( POKEY_AUDCTL[next_event >> 2] & POKEY_CH2_FILTER) {
+			if ( snd_AUDCTL[next_event >> 2] & POKEY_CH2_FILTER) {
 				/* if we're processing channel 4 */
 				if ((next_event & 0x03) == POKEY_CHAN4) {
 					/* check output of channel 2 on same chip */
@@ -1184,22 +1371,18 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 #endif /* STEREO_SOUND */
 #else /* CLIP_SOUND */
 
-            // stuck volume only sound can push iout to 276 in robot demo etc
-            // highpass to remove those funny dc biases
-            iout >>= 1;
-            static int _lp = 0;
-            _lp = (((_lp+iout) << 8) - _lp) >> 8;   // 255*_lp + iout*1
-            int s = iout - (_lp >> 8) + 128;        // hipass to center on 128
-            if (s < 0) s = 0;
-            if (s > 255) s = 255;
-            *buffer++ = s;                          // 8 bit unsigned
+            *buffer++ = output_stage(iout, &hp_lp[0]);  // 8 bit unsigned
 
 #ifdef STEREO_SOUND
-			if (Num_pokeys > 1)
 #ifdef ASAP
+			if (Num_pokeys > 1)
 				*buffer++ = (UBYTE) iout2;
 #else
-				*buffer++ = (UBYTE) (POKEYSND_stereo_enabled ? iout2 : iout);
+			/* the right channel through the same output stage */
+			if (Num_pokeys > 1) {
+				*buffer = POKEYSND_stereo_enabled ? output_stage(iout2, &hp_lp[1]) : buffer[-1];
+				buffer++;
+			}
 #endif
 #endif /* STEREO_SOUND */
 #endif /* CLIP_SOUND */
@@ -1226,13 +1409,13 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 #endif
 	{
 		if (POKEYSND_sampbuf_rptr == POKEYSND_sampbuf_ptr)
-			POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK;
+			POKEYSND_sampbuf_last = SND_CLOCK;
 #ifdef STEREO_SOUND
 #ifdef __PLUS
 	if (POKEYSND_stereo_enabled)
 #endif
 		if (sampbuf_rptr2 == sampbuf_ptr2)
-			sampbuf_last2 = ANTIC_CPU_CLOCK;
+			sampbuf_last2 = SND_CLOCK;
 #endif /* STEREO_SOUND */
 	}
 #endif  /* VOL_ONLY_SOUND */
@@ -1259,8 +1442,8 @@ static void Update_serio_sound_rf(int out, UBYTE data)
 
 	POKEYSND_sampbuf_val[POKEYSND_sampbuf_ptr] = POKEYSND_sampbuf_lastval;
 	POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_ptr] =
-		(ANTIC_CPU_CLOCK + future-POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
-	POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK + future;
+		(SND_CLOCK + future-POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
+	POKEYSND_sampbuf_last = SND_CLOCK + future;
 	POKEYSND_sampbuf_ptr++;
 	if (POKEYSND_sampbuf_ptr >= POKEYSND_SAMPBUF_MAX )
 		POKEYSND_sampbuf_ptr = 0;
@@ -1291,18 +1474,363 @@ void POKEYSND_SetVolume(int vol)
     POKEYSND_volume = vol * 0x100 / 100;
 }
 
-static void pokeysnd_process_16(void *sndbuffer, int sndn)
+/* pokeysnd_process_8 widened to 16 bits */
+static void pokeysnd_process_8_16(void *sndbuffer, int sndn)
 {
 	UWORD *buffer = (UWORD *) sndbuffer;
 	pokeysnd_process_8(buffer, sndn);
 	for (int i = sndn - 1; i >= 0; i--) {
-        int n = (((UBYTE*)buffer)[i]) * POKEYSND_volume;
+        int n = ((((UBYTE*)buffer)[i]) - 0x80) * POKEYSND_volume;
         if (n > 32767)
             n = 32767;
+        else if (n < -32768)
+            n = -32768;
 		buffer[i] = n;    // 16 bit signed
 	}
 }
 
+#ifndef NATIVE_MIX
+static void pokeysnd_process_16(void *sndbuffer, int sndn)
+{
+	pokeysnd_process_8_16(sndbuffer, sndn);
+}
+#else
+
+/* What a channel does with its output when its counter runs out */
+#define MIX_STILL	0	/* volume only: nothing */
+#define MIX_PURE	1	/* toggles it */
+#define MIX_POLY4	2	/* takes the poly4 bit */
+#define MIX_POLY9	3	/* takes the poly9 bit */
+#define MIX_POLY17	4	/* takes the poly17 bit */
+
+/* The volume-only output OUT at the next sample, as pokeysnd_process_8
+   reads it */
+#define SAMPBUF_READ(cnt, val, rptr, ptr, out) do { \
+	if (rptr != ptr) { \
+		int l; \
+		if (cnt[rptr] > 0) \
+			cnt[rptr] -= 1280; \
+		while ((l = cnt[rptr]) <= 0) { \
+			out = val[rptr]; \
+			rptr++; \
+			if (rptr >= POKEYSND_SAMPBUF_MAX) \
+				rptr = 0; \
+			if (rptr != ptr) \
+				cnt[rptr] += l; \
+			else \
+				break; \
+		} \
+	} \
+} while (0)
+
+/* output_stage on an 8.8 sum, giving an 8.8 sample.  The rounding of
+   output_stage takes off one less than the level it settles to, so a steady
+   level comes out on 129, and silence on 128: the same here, for the same
+   DC level. */
+static int output_stage_fine(int iout, int *lp)
+{
+	int dc;
+	iout >>= 1;
+	*lp += iout - (*lp >> 8);
+	dc = (*lp >> 8) - (1 << 8);
+	if (dc < 0) dc = 0;
+	iout += (128 << 8) - dc;
+	if (iout < 0) iout = 0;
+	if (iout > 0xffff) iout = 0xffff;
+	return iout;
+}
+
+/* Adds a change of DELTA in the channel outputs, D (24.8) cycles before the
+   next sample, to the samples to come of B */
+static void band_step(band_t *b, int delta, ULONG d, int resample)
+{
+	ULONG u;
+
+	if (d >= band_span)
+		return;
+	u = d * band_recip >> 8;	/* in samples, 16.16 */
+	if (resample == POKEYSND_RESAMPLE_BOX)
+		/* the next sample has the new level for D of its period */
+		b->ring[b->pos] -= delta * ((1 << 14) - (int) (u >> 2));
+	else {
+		int phase = (u >> 11) & (BAND_PHASES - 1);
+		int d1 = delta * (int) ((u >> 5) & 0x3f);	/* times 64 */
+		int d0 = (delta << 6) - d1;
+		int m = u >> 16;
+		int j = b->pos;
+		for (; m < BAND_TAPS; m++) {
+			b->ring[j] += (d0 * blep_table[phase][m] + d1 * blep_table[phase + 1][m]) >> 6;
+			j = (j + 1) & (BAND_TAPS - 1);
+		}
+	}
+}
+
+/* The next sample of output channel SIDE, 8.8 unsigned, for the channel
+   outputs summed LEVEL and the volume-only output VOL */
+static int mix_sample(int side, int level, int vol, int resample)
+{
+	band_t *b = &band[side];
+	int y;
+
+	/* the 8-bit mixer sums in a UBYTE */
+	if (resample == POKEYSND_RESAMPLE_NEAREST)
+		return output_stage((level & 0xff) + vol, &hp_lp[side]) << 8;
+	if (vol != b->vol) {
+		band_step(b, vol - b->vol, 0, resample);
+		b->vol = vol;
+	}
+	y = ((level + vol) << 14) + b->ring[b->pos];
+	b->ring[b->pos] = 0;
+	b->pos = (b->pos + 1) & (BAND_TAPS - 1);
+	return output_stage_fine(y >> 6, &hp_lp[side]);
+}
+
+/* The output of pokeysnd_process_8, signed and times POKEYSND_volume, made
+   directly in 16 bits: the same events in the same order, without the 8-bit pass.  Or,
+   with POKEYSND_resample, the channel outputs filtered down to the sample
+   rate, in 16 bits or 8 as BIT16 says.
+
+   AUDC and AUDCTL do not change within a call, so what each channel does at
+   its events is decoded once, and the polynomial positions it reads move by
+   the same step from one of its events to the next: they are kept per
+   channel, without a division per event.  The counters hold the time of the
+   next event from the start of the call rather than from the last event, so
+   an event moves one of them only, and a channel whose counter cannot run out
+   before the last sample is left out of the search for the next event.
+   The changes of the channel outputs go to band_step with their time, for
+   the resampling.  With STEREO_SOUND and two POKEYs, the second one is the
+   right channel when POKEYSND_stereo_enabled. */
+static void pokeysnd_process_mix(void *sndbuffer, int sndn, int bit16)
+{
+	SWORD *buf16 = (SWORD *) sndbuffer;
+	UBYTE *buf8 = (UBYTE *) sndbuffer;
+	int resample = POKEYSND_resample;
+#ifdef WORDS_BIGENDIAN
+	ULONG samp = Samp_n_cnt[1];	/* 24.8, as in pokeysnd_process_8 */
+#else
+	ULONG samp = Samp_n_cnt[0];
+#endif
+	ULONG horizon;				/* no channel further than this fires */
+	ULONG elapsed = 0;			/* time of the last event */
+	UBYTE act[4 * POKEY_MAXPOKEYS];		/* the channels that may fire, in order */
+	UBYTE mode[4 * POKEY_MAXPOKEYS];
+	UBYTE filter[4 * POKEY_MAXPOKEYS];	/* the channel its events clear, or 0xff */
+	UBYTE gated[4 * POKEY_MAXPOKEYS];	/* by the poly5 bit */
+	UBYTE p5[4 * POKEY_MAXPOKEYS];		/* poly5 position at the next event */
+	UBYTE s5[4 * POKEY_MAXPOKEYS];		/* and its step between events */
+	ULONG pn[4 * POKEY_MAXPOKEYS];		/* the same for the poly of MODE */
+	ULONG sn[4 * POKEY_MAXPOKEYS];
+	ULONG size[4 * POKEY_MAXPOKEYS];
+	int cur[2] = {0, 0};
+	int pair = FALSE;			/* two samples per frame */
+	int split = FALSE;			/* the second POKEY on the right */
+	int nact = 0;
+	int c, i;
+
+#ifdef STEREO_SOUND
+	pair = Num_pokeys > 1;
+	split = pair && POKEYSND_stereo_enabled;
+#endif
+	horizon = (samp >> 8) + (ULONG) sndn * ((Samp_n_max >> 8) + 1);
+	for (c = 0; c < 4 * Num_pokeys; c++) {
+		UBYTE audc = snd_AUDC[c];
+		UBYTE audctl = snd_AUDCTL[c >> 2];
+
+		if (Outvol[c])
+			cur[split && (c & 4)] += pokeysnd_AUDV[c];
+		if (Div_n_cnt[c] > horizon)
+			continue;
+		act[nact++] = c;
+
+		filter[c] = 0xff;
+		if (((c & 0x03) == POKEY_CHAN3 && (audctl & POKEY_CH1_FILTER))
+		    || ((c & 0x03) == POKEY_CHAN4 && (audctl & POKEY_CH2_FILTER)))
+			filter[c] = c & 0xfd;
+
+		gated[c] = FALSE;
+		if (audc & POKEY_VOL_ONLY) {
+			mode[c] = MIX_STILL;
+			continue;
+		}
+		if (!(audc & POKEY_NOTPOLY5)) {
+			gated[c] = TRUE;
+			p5[c] = (P5 + Div_n_cnt[c]) % POKEY_POLY5_SIZE;
+			s5[c] = Div_n_max[c] % POKEY_POLY5_SIZE;
+		}
+		if (audc & POKEY_PURETONE) {
+			mode[c] = MIX_PURE;
+			continue;
+		}
+		if (audc & POKEY_POLY4) {
+			mode[c] = MIX_POLY4;
+			size[c] = POKEY_POLY4_SIZE;
+			pn[c] = P4;
+		}
+		else if (audctl & POKEY_POLY9) {
+			mode[c] = MIX_POLY9;
+			size[c] = POKEY_POLY9_SIZE;
+			pn[c] = P9;
+		}
+		else {
+			mode[c] = MIX_POLY17;
+			size[c] = POKEY_POLY17_SIZE;
+			pn[c] = P17;
+		}
+		pn[c] = (pn[c] + Div_n_cnt[c]) % size[c];
+		sn[c] = Div_n_max[c] % size[c];
+	}
+	/* AUDV written since the last call */
+	if (resample != POKEYSND_RESAMPLE_NEAREST) {
+		for (i = 0; i < 2; i++) {
+			if (cur[i] != band[i].chans)
+				band_step(&band[i], cur[i] - band[i].chans, samp, resample);
+		}
+	}
+
+	while (sndn > 0) {
+		ULONG event_min = (samp >> 8) + elapsed;
+		int next = -1;
+
+		/* ties go to the channel, the last one first */
+		for (i = 0; i < nact; i++) {
+			if (Div_n_cnt[act[i]] <= event_min) {
+				event_min = Div_n_cnt[act[i]];
+				next = act[i];
+			}
+		}
+
+		if (next >= 0) {
+			UBYTE out = Outvol[next];
+			int gate = TRUE;
+			int delta = 0;
+			int f;
+
+			samp -= (event_min - elapsed) << 8;
+			elapsed = event_min;
+			Div_n_cnt[next] += Div_n_max[next];
+
+			if (gated[next]) {
+				gate = bit5[p5[next]];
+				p5[next] += s5[next];
+				if (p5[next] >= POKEY_POLY5_SIZE)
+					p5[next] -= POKEY_POLY5_SIZE;
+			}
+			if (mode[next] >= MIX_POLY4) {
+				if (gate) {
+					ULONG p = pn[next];
+					if (mode[next] == MIX_POLY4)
+						out = bit4[p];
+					else if (mode[next] == MIX_POLY9)
+						out = POKEY_poly9_lookup[p] & 1;
+					else
+						out = (POKEY_poly17_lookup[p >> 3] >> (p & 7)) & 1;
+				}
+				pn[next] += sn[next];
+				if (pn[next] >= size[next])
+					pn[next] -= size[next];
+			}
+			else if (mode[next] == MIX_PURE && gate)
+				out = !out;
+
+			f = filter[next];
+			if (f != 0xff && Outvol[f]) {
+				Outvol[f] = 0;
+				delta -= pokeysnd_AUDV[f];
+			}
+			if (out != Outvol[next]) {
+				Outvol[next] = out;
+				if (out)
+					delta += pokeysnd_AUDV[next];
+				else
+					delta -= pokeysnd_AUDV[next];
+			}
+			if (delta) {
+				int side = split && (next & 4);
+				cur[side] += delta;
+				if (resample != POKEYSND_RESAMPLE_NEAREST)
+					band_step(&band[side], delta, samp, resample);
+			}
+		}
+		else {
+			int vol = 0;
+			int v;
+			int k;
+#ifdef VOL_ONLY_SOUND
+			SAMPBUF_READ(POKEYSND_sampbuf_cnt, POKEYSND_sampbuf_val,
+			             POKEYSND_sampbuf_rptr, POKEYSND_sampbuf_ptr, POKEYSND_sampout);
+			vol = POKEYSND_sampout;
+#endif
+			v = mix_sample(0, cur[0], vol, resample);
+			for (k = 0; k < 1 + pair; k++) {
+#ifdef STEREO_SOUND
+				if (k == 1 && split) {
+					vol = 0;
+#ifdef VOL_ONLY_SOUND
+					SAMPBUF_READ(sampbuf_cnt2, sampbuf_val2, sampbuf_rptr2, sampbuf_ptr2, sampout2);
+					vol = sampout2;
+#endif
+					v = mix_sample(1, cur[1], vol, resample);
+				}
+#endif /* STEREO_SOUND */
+				if (bit16) {
+					int n = (v - 0x8000) * POKEYSND_volume >> 8;
+					*buf16++ = n > 32767 ? 32767 : n < -32768 ? -32768 : n;
+				}
+				else {
+					int n = (v + 0x80) >> 8;
+					*buf8++ = n > 255 ? 255 : n;
+				}
+				sndn--;
+			}
+			samp += Samp_n_max;
+		}
+	}
+	band[0].chans = cur[0];
+	band[1].chans = cur[1];
+
+#ifdef WORDS_BIGENDIAN
+	Samp_n_cnt[1] = samp;
+#else
+	Samp_n_cnt[0] = samp;
+#endif
+	if (elapsed) {
+		for (c = 0; c < 4 * Num_pokeys; c++)
+			Div_n_cnt[c] -= elapsed;
+		P4 = (P4 + elapsed) % POKEY_POLY4_SIZE;
+		P5 = (P5 + elapsed) % POKEY_POLY5_SIZE;
+		P9 = (P9 + elapsed) % POKEY_POLY9_SIZE;
+		P17 = (P17 + elapsed) % POKEY_POLY17_SIZE;
+	}
+
+#ifdef VOL_ONLY_SOUND
+	if (POKEYSND_sampbuf_rptr == POKEYSND_sampbuf_ptr)
+		POKEYSND_sampbuf_last = SND_CLOCK;
+#ifdef STEREO_SOUND
+	if (split && sampbuf_rptr2 == sampbuf_ptr2)
+		sampbuf_last2 = SND_CLOCK;
+#endif
+#endif /* VOL_ONLY_SOUND */
+}
+
+/* Calls shorter than this, as volume-only samples make them, spend more on
+   decoding the registers than pokeysnd_process_8 spends on the samples */
+#define MIX_MIN_SAMPLES 8
+
+static void pokeysnd_process_16(void *sndbuffer, int sndn)
+{
+	if (sndn < MIX_MIN_SAMPLES && POKEYSND_resample == POKEYSND_RESAMPLE_NEAREST)
+		pokeysnd_process_8_16(sndbuffer, sndn);
+	else
+		pokeysnd_process_mix(sndbuffer, sndn, TRUE);
+}
+
+/* 8-bit output with POKEYSND_resample */
+static void pokeysnd_process_8_band(void *sndbuffer, int sndn)
+{
+	pokeysnd_process_mix(sndbuffer, sndn, FALSE);
+}
+#endif /* NATIVE_MIX */
+
 #ifdef SYNCHRONIZED_SOUND
 static void Generate_sync_rf(unsigned int num_ticks)
 {
@@ -1353,11 +1881,11 @@ void POKEYSND_UpdateConsol(int set)
 	POKEYSND_UpdateConsol_ptr(set);
 }
 
-static void Update_consol_sound_rf(int set)
+static void consol_sound_rf(int set, int atari_speaker)
 {
 #ifdef SYNCHRONIZED_SOUND
 	if (set)
-		speaker = CONSOLE_VOL * GTIA_speaker;
+		speaker = CONSOLE_VOL * atari_speaker;
 #elif defined(VOL_ONLY_SOUND)
 	static int prev_atari_speaker = 0;
 	static unsigned int prev_cpu_clock = 0;
@@ -1370,12 +1898,12 @@ static void Update_consol_sound_rf(int set)
 	if (!set && POKEYSND_samp_consol_val == 0)
 		return;
 	POKEYSND_sampbuf_lastval -= POKEYSND_samp_consol_val;
-	if (prev_atari_speaker != GTIA_speaker) {
-		POKEYSND_samp_consol_val = GTIA_speaker * 8 * 4;	/* gain */
-		prev_cpu_clock = ANTIC_CPU_CLOCK;
+	if (prev_atari_speaker != atari_speaker) {
+		POKEYSND_samp_consol_val = atari_speaker * 8 * 4;	/* gain */
+		prev_cpu_clock = SND_CLOCK;
 	}
 	else if (!set) {
-		d = ANTIC_CPU_CLOCK - prev_cpu_clock;
+		d = SND_CLOCK - prev_cpu_clock;
 		if (d < 114) {
 			POKEYSND_sampbuf_lastval += POKEYSND_samp_consol_val;
 			return;
@@ -1384,15 +1912,15 @@ static void Update_consol_sound_rf(int set)
 			POKEYSND_samp_consol_val = POKEYSND_samp_consol_val * 99 / 100;
 			d -= 114;
 		}
-		prev_cpu_clock = ANTIC_CPU_CLOCK - d;
+		prev_cpu_clock = SND_CLOCK - d;
 	}
 	POKEYSND_sampbuf_lastval += POKEYSND_samp_consol_val;
-	prev_atari_speaker = GTIA_speaker;
+	prev_atari_speaker = atari_speaker;
 
 	POKEYSND_sampbuf_val[POKEYSND_sampbuf_ptr] = POKEYSND_sampbuf_lastval;
 	POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_ptr] =
-		(ANTIC_CPU_CLOCK - POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
-	POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK;
+		(SND_CLOCK - POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
+	POKEYSND_sampbuf_last = SND_CLOCK;
 	POKEYSND_sampbuf_ptr++;
 	if (POKEYSND_sampbuf_ptr >= POKEYSND_SAMPBUF_MAX)
 		POKEYSND_sampbuf_ptr = 0;
@@ -1403,6 +1931,11 @@ static void Update_consol_sound_rf(int set)
 	}
 #endif /* !SYNCHRONIZED_SOUND && VOL_ONLY_SOUND */
 }
+
+static void Update_consol_sound_rf(int set)
+{
+	consol_sound_rf(set, GTIA_speaker);
+}
 #endif /* CONSOLE_SOUND */
 
 #ifdef VOL_ONLY_SOUND
@@ -1413,3 +1946,231 @@ static void Update_vol_only_sound_rf(void)
 #endif /* CONSOLE_SOUND */
 }
 #endif  /* VOL_ONLY_SOUND */
+
+/*****************************************************************************/
+/* Timestamped write log                                                     */
+/*****************************************************************************/
+
+static void log_put(unsigned int cycle, UBYTE reg, UBYTE val)
+{
+	log_entry_t *entry = &log_entries[log_head % POKEYSND_LOG_SIZE];
+
+	entry->cycle = cycle > 0xffff ? 0xffff : cycle;
+	entry->reg = reg;
+	entry->val = val;
+	log_head++;
+}
+
+/* Waits until COUNT more entries fit */
+static void log_wait(unsigned int count)
+{
+	while (POKEYSND_LOG_SIZE - (log_head - log_tail) < count)
+		LOG_WAIT_IDLE();
+}
+
+/* Waits until every closed frame is rendered */
+static void log_drain(void)
+{
+	while (log_rendered != log_frames)
+		LOG_WAIT_IDLE();
+}
+
+static void log_write(UBYTE reg, UBYTE val)
+{
+	if (POKEYSND_LOG_SIZE - (log_head - log_tail) <= LOG_RESERVE)
+		log_overflow = TRUE;
+	/* the rest of the frame is dropped; POKEYSND_LogFrame puts the registers
+	   in its place */
+	if (log_overflow)
+		return;
+	log_put(ANTIC_CPU_CLOCK - log_frame_start, reg, val);
+	log_writes++;
+}
+
+static void log_pokey_sound(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
+{
+	/* STIMER, SKCTL: nothing for Update_pokey_sound_rf to do */
+	if ((addr & 0x0f) > POKEY_OFFSET_AUDCTL)
+		return;
+	log_gain = gain;
+	log_write((chip << 4) | (addr & 0x0f), val);
+}
+
+#ifdef SERIO_SOUND
+static void log_serio_sound(int out, UBYTE data)
+{
+	log_write(LOG_SERIO, data);
+}
+#endif
+
+#ifdef CONSOLE_SOUND
+static void log_consol_sound(int set)
+{
+	if (set) {
+		/* a click starts where the speaker changes */
+		if (GTIA_speaker != log_consol_speaker)
+			log_consol_clock = ANTIC_CPU_CLOCK;
+		log_consol_speaker = GTIA_speaker;
+	}
+	else if (ANTIC_CPU_CLOCK - log_consol_clock > LOG_CONSOL_FADE)
+		return;
+	log_write(LOG_CONSOL | set, GTIA_speaker);
+}
+#endif
+
+static void log_hook(void)
+{
+	POKEYSND_Update_ptr = log_pokey_sound;
+#ifdef SERIO_SOUND
+	POKEYSND_UpdateSerio = log_serio_sound;
+#endif
+#ifdef CONSOLE_SOUND
+	POKEYSND_UpdateConsol_ptr = log_consol_sound;
+#endif
+}
+
+static void log_apply(const log_entry_t *entry)
+{
+	switch (entry->reg & 0xf0) {
+	case LOG_SERIO:
+#ifdef SERIO_SOUND
+		Update_serio_sound_rf(1, entry->val);
+#endif
+		break;
+	case LOG_CONSOL:
+#ifdef CONSOLE_SOUND
+		consol_sound_rf(entry->reg & 1, entry->val);
+#endif
+		break;
+	default:
+		Update_pokey_sound_rf(entry->reg & 0x0f, entry->val, entry->reg >> 4, log_gain);
+		break;
+	}
+}
+
+int POKEYSND_SetLog(int mode)
+{
+	if (mode != POKEYSND_LOG_OFF && log_entries == NULL) {
+		log_entries = (log_entry_t *) malloc(POKEYSND_LOG_SIZE * sizeof(log_entry_t));
+		if (log_entries == NULL)
+			return FALSE;
+	}
+	/* frames not rendered yet are dropped */
+	log_head = log_tail = 0;
+	log_frames = log_rendered = 0;
+	log_overflow = FALSE;
+	log_frame_start = log_base = log_clock = ANTIC_CPU_CLOCK;
+	/* a click may still be fading out, and the next write may start one */
+	log_consol_clock = ANTIC_CPU_CLOCK;
+	log_consol_speaker = -1;
+	log_mode = mode;
+
+	if (mode != POKEYSND_LOG_OFF)
+		log_hook();
+	else {
+		POKEYSND_Update_ptr = Update_pokey_sound_rf;
+#ifdef SERIO_SOUND
+		POKEYSND_UpdateSerio = Update_serio_sound_rf;
+#endif
+#ifdef CONSOLE_SOUND
+		POKEYSND_UpdateConsol_ptr = Update_consol_sound_rf;
+#endif
+	}
+	return TRUE;
+}
+
+void POKEYSND_LogFrame(void)
+{
+	unsigned int cycles = ANTIC_CPU_CLOCK - log_frame_start;
+	int chip;
+	int chan;
+
+	if (log_overflow) {
+		log_wait(LOG_RESERVE);
+		for (chip = 0; chip < POKEYSND_num_pokeys; chip++) {
+			log_put(cycles, (chip << 4) | POKEY_OFFSET_AUDCTL, POKEY_AUDCTL[chip]);
+			for (chan = POKEY_CHAN1; chan <= POKEY_CHAN4; chan++) {
+				log_put(cycles, (chip << 4) | (POKEY_OFFSET_AUDF1 + 2 * chan), POKEY_AUDF[(chip << 2) + chan]);
+				log_put(cycles, (chip << 4) | (POKEY_OFFSET_AUDC1 + 2 * chan), POKEY_AUDC[(chip << 2) + chan]);
+			}
+		}
+		log_overflow = FALSE;
+		log_overflows++;
+	}
+	else
+		log_wait(1);
+	log_put(cycles, LOG_FRAME, 0);
+	if (log_head - log_tail > log_max_queued)
+		log_max_queued = log_head - log_tail;
+
+	/* publish the frame only after its entries are stored */
+	__sync_synchronize();
+	log_frames++;
+	log_frame_start += cycles;
+}
+
+int POKEYSND_LogPending(void)
+{
+	return log_frames - log_rendered;
+}
+
+int POKEYSND_LogRender(void *sndbuffer, int sndn)
+{
+	UBYTE *buffer = (UBYTE *) sndbuffer;
+	int size = (POKEYSND_snd_flags & POKEYSND_BIT16) ? 2 : 1;
+	int frames = sndn / POKEYSND_num_pokeys;
+	unsigned int tail = log_tail;
+	unsigned int end;
+	unsigned int cycles;
+	int done = 0;
+
+	if (log_rendered == log_frames)
+		return FALSE;
+	/* read the entries of the frame only after it is published */
+	__sync_synchronize();
+
+	for (end = tail; log_entries[end % POKEYSND_LOG_SIZE].reg != LOG_FRAME; end++)
+		;
+	cycles = log_entries[end % POKEYSND_LOG_SIZE].cycle;
+
+	for (; tail != end; tail++) {
+		const log_entry_t *entry = &log_entries[tail % POKEYSND_LOG_SIZE];
+
+		log_clock = log_base + entry->cycle;
+		if (log_mode == POKEYSND_LOG_TIMED && cycles > 0) {
+			/* the samples before the write */
+			int pos = (int) ((ULONG) entry->cycle * frames / cycles) * POKEYSND_num_pokeys;
+			if (pos > done) {
+				POKEYSND_Process(buffer + done * size, pos - done);
+				done = pos;
+			}
+		}
+		log_apply(entry);
+	}
+	log_clock = log_base + cycles;
+	if (done < sndn)
+		POKEYSND_Process(buffer + done * size, sndn - done);
+	log_base += cycles;
+
+	/* free the entries only after they are read */
+	__sync_synchronize();
+	log_tail = end + 1;
+	log_rendered++;
+	return TRUE;
+}
+
+#ifdef LIBATARI800
+void POKEYSND_GetLogStats(sound_log_stats_t *stats)
+{
+	stats->writes = log_writes;
+	stats->overflows = log_overflows;
+	stats->max_queued = log_max_queued;
+}
+
+void POKEYSND_ResetLogStats(void)
+{
+	log_writes = 0;
+	log_overflows = 0;
+	log_max_queued = 0;
+}
+#endif
@@ -86,6 +86,20 @@ extern int POKEYSND_volume;
 
 extern int POKEYSND_enable_new_pokey;
 extern int POKEYSND_stereo_enabled;
+
+/* How the 1.79 MHz signal becomes samples, taken at POKEYSND_Init.  Nearest
+   takes the channel outputs as they are at each sample, which aliases
+   whatever is above half the playback rate.  Box averages them over the
+   sample period, at one multiplication per output change.  BLEP adds each
+   change as a band-limited step, from a 16-sample table: 32 multiplications
+   per change and 8 samples of delay, for output that is flat to 0.3 and down
+   85 dB from 0.6 of the playback rate.  Box and BLEP go through the 16-bit
+   mixer, for 8-bit output as well; not available with CLIP_SOUND,
+   INTERPOLATE_SOUND or SYNCHRONIZED_SOUND. */
+#define POKEYSND_RESAMPLE_NEAREST	0
+#define POKEYSND_RESAMPLE_BOX		1
+#define POKEYSND_RESAMPLE_BLEP		2
+extern int POKEYSND_resample;
 extern int POKEYSND_serio_sound_enabled;
 extern int POKEYSND_console_sound_enabled;
 extern int POKEYSND_bienias_fix;
@@ -113,6 +127,37 @@ int POKEYSND_DoInit(void);
 void POKEYSND_SetMzQuality(int quality);
 void POKEYSND_SetVolume(int vol);
 
+/* Timestamped write log.  With it on, the writes to AUDF, AUDC and AUDCTL,
+   and the console speaker and serial port sound, are only logged with their
+   CPU cycle in the frame; POKEYSND_LogFrame, called at every frame end,
+   closes a frame of them, and POKEYSND_LogRender turns the oldest closed
+   frame into sndn samples as POKEYSND_Process would.  The log is a
+   single-producer single-consumer queue: POKEYSND_LogRender may run on
+   another core than the emulation, which then never waits for the sound but
+   when the log is full at a frame end.  A frame whose writes do not fit in
+   the log gets the registers as they are at its end instead.
+   POKEYSND_Init first waits until the closed frames are rendered, so it
+   must not be called with frames pending from the thread that renders them. */
+#ifndef POKEYSND_LOG_SIZE
+#define POKEYSND_LOG_SIZE 2048	/* entries of 4 bytes */
+#endif
+#define POKEYSND_LOG_OFF	0	/* writes applied as they come, as ever */
+#define POKEYSND_LOG_TIMED	1	/* writes applied at their sample in the frame */
+#define POKEYSND_LOG_FRAME	2	/* writes applied at the frame start, which is what
+								   POKEYSND_LOG_OFF amounts to; for checking the log */
+/* FALSE if the log cannot be allocated. Drops the frames not rendered yet. */
+int POKEYSND_SetLog(int mode);
+void POKEYSND_LogFrame(void);
+/* Frames closed and not rendered yet */
+int POKEYSND_LogPending(void);
+/* FALSE if no frame is closed */
+int POKEYSND_LogRender(void *sndbuffer, int sndn);
+#ifdef LIBATARI800
+#include "libatari800.h"
+void POKEYSND_GetLogStats(sound_log_stats_t *stats);
+void POKEYSND_ResetLogStats(void);
+#endif
+
 /* Volume only emulations declarations */
 #ifdef VOL_ONLY_SOUND
 
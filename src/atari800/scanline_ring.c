@@ -0,0 +1,238 @@
+/*
+ * scanline_ring.c - stream ANTIC scanlines to the display
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "config.h"
+#include <string.h>
+#ifndef PICO_ON_DEVICE
+#include <sched.h>
+#include <time.h>
+#endif
+
+#include "atari.h"
+#include "screen.h"
+#include "scanline_ring.h"
+
+#ifdef SCANLINE_RING
+
+/* The display side runs in the video interrupt. */
+#ifdef PICO_ON_DEVICE
+#include <pico/platform.h>
+#include <pico/time.h>
+#define DISPLAY_FUNC(f) __not_in_flash_func(f)
+#define RING_WAIT_IDLE() tight_loop_contents()
+#else
+#define DISPLAY_FUNC(f) f
+/* the display thread may share a CPU with this one */
+#define RING_WAIT_IDLE() sched_yield()
+#endif
+
+/* The ring, and one line past the end of the frame that is never shown. */
+static ULONG ring[SCANLINE_RING_LINES + 1][Screen_WIDTH / 4];
+
+/* Both counters hold a frame number in bits 8-31 and a line in bits 0-7.
+   drawn is written by ANTIC only: the lines of its frame done so far.
+   beam is written by the display only: the line it shows now. */
+static volatile ULONG drawn = 0;
+static volatile ULONG beam = 0;
+static volatile int attached = FALSE;
+
+/* ANTIC side */
+static ULONG frame = 0;
+static int line = 0;
+static unsigned long long stalls = 0;
+static unsigned long long late_frames = 0;
+
+/* display side */
+static ULONG display_frame = 0;
+/* the last line asked for and what it got, for a driver that asks again
+   for the same line, as when it doubles lines */
+static int last_y = -1;
+static const UBYTE *last_line = NULL;
+static unsigned long long lines_shown = 0;
+static unsigned long long underruns = 0;
+
+/* Input to display latency: from SCANLINE_RING_InputTaken to the display
+   asking for the first line of the frame that input goes into.  ANTIC
+   writes the frame and time and then sets input_pending; the display reads
+   them and clears it.  One frame is measured at a time. */
+static volatile ULONG input_frame = 0;
+static volatile unsigned long long input_us = 0;
+static volatile int input_pending = FALSE;
+static unsigned long long latency_frames = 0;
+static unsigned long long latency_us = 0;
+static unsigned long long latency_max_us = 0;
+
+static unsigned long long DISPLAY_FUNC(ring_now_us)(void)
+{
+#ifdef PICO_ON_DEVICE
+	return time_us_64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* Frame numbers are 24 bits; the difference A - B, sign included. */
+static int frame_diff(ULONG a, ULONG b)
+{
+	return (int) ((a - b) << 8) >> 8;
+}
+
+UWORD *SCANLINE_RING_BeginFrame(void)
+{
+	frame++;
+	line = 0;
+	if (attached) {
+		ULONG at;
+		/* the display shows the frame after it has finished this one */
+		while (frame_diff((at = beam) >> 8, frame) < 0)
+			RING_WAIT_IDLE();
+		if (frame_diff(at >> 8, frame) > 0) {
+			/* the display has begun the frame already; catch up */
+			frame = at >> 8;
+			late_frames++;
+		}
+	}
+	drawn = frame << 8;
+	return (UWORD *) ring[0];
+}
+
+UWORD *SCANLINE_RING_NextLine(void)
+{
+	/* publish the line only after all its pixels are stored */
+	__sync_synchronize();
+	drawn = frame << 8 | ++line;
+	if (line >= Screen_HEIGHT)
+		return (UWORD *) ring[SCANLINE_RING_LINES];
+	if (attached) {
+		ULONG at = beam;
+		/* the slot still holds line - SCANLINE_RING_LINES */
+		if (frame_diff(at >> 8, frame) == 0 && (int) (at & 0xff) + SCANLINE_RING_LINES <= line) {
+			stalls++;
+			do {
+				RING_WAIT_IDLE();
+				at = beam;
+			} while (frame_diff(at >> 8, frame) == 0 && (int) (at & 0xff) + SCANLINE_RING_LINES <= line);
+		}
+	}
+	return (UWORD *) ring[line & (SCANLINE_RING_LINES - 1)];
+}
+
+void SCANLINE_RING_WaitDisplay(void)
+{
+	/* what BeginFrame would wait for */
+	if (attached)
+		while (frame_diff(beam >> 8, frame + 1) < 0)
+			RING_WAIT_IDLE();
+}
+
+void SCANLINE_RING_InputTaken(void)
+{
+	input_pending = FALSE;
+	__sync_synchronize();
+	input_frame = frame + 1;
+	input_us = ring_now_us();
+	__sync_synchronize();
+	input_pending = attached;
+}
+
+void SCANLINE_RING_Attach(int attach)
+{
+	if (attach) {
+		display_frame = drawn >> 8;
+		beam = display_frame << 8;
+		last_y = -1;
+	}
+	attached = attach;
+}
+
+const UBYTE *DISPLAY_FUNC(SCANLINE_RING_GetLine)(int y)
+{
+	ULONG done;
+
+	/* counted once, and the slot of Y is still kept */
+	if (y == last_y)
+		return last_line;
+	last_y = y;
+	/* keeps the slot of Y until the next call */
+	beam = display_frame << 8 | y;
+	__sync_synchronize();
+	if (y == 0 && input_pending && frame_diff(display_frame, input_frame) >= 0) {
+		unsigned long long us = ring_now_us() - input_us;
+		input_pending = FALSE;
+		latency_frames++;
+		latency_us += us;
+		if (us > latency_max_us)
+			latency_max_us = us;
+	}
+	done = drawn;
+	if (frame_diff(done >> 8, display_frame) == 0 && (int) (done & 0xff) > y) {
+		lines_shown++;
+		last_line = (const UBYTE *) ring[y & (SCANLINE_RING_LINES - 1)];
+	}
+	else {
+		underruns++;
+		last_line = NULL;
+	}
+	return last_line;
+}
+
+void DISPLAY_FUNC(SCANLINE_RING_EndFrame)(void)
+{
+	display_frame++;
+	last_y = -1;
+	beam = display_frame << 8;
+}
+
+#endif /* SCANLINE_RING */
+
+#ifdef LIBATARI800
+
+void SCANLINE_RING_GetStats(scanline_ring_stats_t *stats)
+{
+#ifdef SCANLINE_RING
+	stats->lines = lines_shown;
+	stats->underruns = underruns;
+	stats->stalls = stalls;
+	stats->late_frames = late_frames;
+	stats->latency_frames = latency_frames;
+	stats->latency_us = latency_us;
+	stats->latency_max_us = latency_max_us;
+#else
+	memset(stats, 0, sizeof(scanline_ring_stats_t));
+#endif
+}
+
+void SCANLINE_RING_ResetStats(void)
+{
+#ifdef SCANLINE_RING
+	lines_shown = 0;
+	underruns = 0;
+	stalls = 0;
+	late_frames = 0;
+	latency_frames = 0;
+	latency_us = 0;
+	latency_max_us = 0;
+#endif
+}
+
+#endif /* LIBATARI800 */
@@ -0,0 +1,54 @@
+#ifndef SCANLINE_RING_H_
+#define SCANLINE_RING_H_
+
+#include "atari.h"
+
+/* With SCANLINE_RING, ANTIC_Frame draws into a ring of SCANLINE_RING_LINES
+   scanlines instead of Screen_atari, and the display driver takes every
+   line from the ring as the beam reaches it.  ANTIC runs on one core and
+   the driver on the other; each side only writes its own counters.
+
+   While a display is attached, ANTIC starts a frame only after the display
+   has finished the previous one and waits whenever it is a whole ring ahead
+   of the beam.  A line the display asks for before ANTIC has drawn it, or
+   after ANTIC has reused its slot, is an underrun: the driver shows what it
+   had and the line is counted.
+
+   So ANTIC races the beam: it is at most a ring ahead of the line shown.
+   Input read when the display has finished a frame, just before ANTIC
+   starts the next, is on the screen from the first line of that frame. */
+
+/* Power of two */
+#define SCANLINE_RING_LINES 8
+
+#ifdef SCANLINE_RING
+
+/* ANTIC side: buffer of the first line of a frame and, after each line,
+   the buffer of the next one. */
+UWORD *SCANLINE_RING_BeginFrame(void);
+UWORD *SCANLINE_RING_NextLine(void);
+
+/* Waits, while a display is attached, until it has finished the frame
+   before the next one; BeginFrame then starts at once. */
+void SCANLINE_RING_WaitDisplay(void);
+/* Marks the input of the next frame as read now, for the latency stats. */
+void SCANLINE_RING_InputTaken(void);
+
+/* Display side.  Attach before asking for lines; GetLine returns line Y
+   (0 .. Screen_HEIGHT - 1) or NULL on an underrun, and EndFrame is called
+   once after the last visible line.  Asking again for the line just asked
+   for returns the same, counted once: a driver that doubles lines may ask
+   for each of them. */
+void SCANLINE_RING_Attach(int attach);
+const UBYTE *SCANLINE_RING_GetLine(int y);
+void SCANLINE_RING_EndFrame(void);
+
+#endif /* SCANLINE_RING */
+
+#ifdef LIBATARI800
+#include "libatari800.h"
+void SCANLINE_RING_GetStats(scanline_ring_stats_t *stats);
+void SCANLINE_RING_ResetStats(void);
+#endif
+
+#endif /* SCANLINE_RING_H_ */
@@ -158,6 +158,8 @@ int Screen_Initialise(int *argc, char *argv[])
 	if (help_only)
 		return TRUE;
 
+#ifndef SCANLINE_RING
+	/* with SCANLINE_RING, ANTIC draws into scanline_ring.c instead */
 	if (Screen_atari == NULL) { /* platform-specific code can initialize it */
 		Screen_atari = (ULONG *) Util_malloc(Screen_HEIGHT * Screen_WIDTH);
 		/* Clear the screen. */
@@ -173,6 +175,7 @@ int Screen_Initialise(int *argc, char *argv[])
 		Screen_atari2 = Screen_atari_b;
 #endif
 	}
+#endif /* SCANLINE_RING */
 
 	return TRUE;
 }
@@ -365,6 +368,7 @@ static void SmallFont_DrawChar(UBYTE *screen, int ch, UBYTE color1, UBYTE color2
 		}
 		screen += Screen_WIDTH - SMALLFONT_WIDTH;
 	}
+	ANTIC_ForgetLines((int) ((screen - (UBYTE *) Screen_atari) / Screen_WIDTH) - SMALLFONT_HEIGHT, SMALLFONT_HEIGHT);
 }
 
 /* Returns screen address for placing the next character on the left of the
@@ -641,6 +645,8 @@ int Screen_SaveScreenshot(const char *filename, int interlaced)
 #endif
 	else
 		return FALSE;
+	if (Screen_atari == NULL)
+		return FALSE;
 	fp = fopen(filename, "wb");
 	if (fp == NULL)
 		return FALSE;
@@ -649,6 +655,7 @@ int Screen_SaveScreenshot(const char *filename, int interlaced)
 	if (interlaced) {
 		Screen_atari = (ULONG *) Util_malloc(Screen_WIDTH * Screen_HEIGHT);
 		ptr2 = (UBYTE *) Screen_atari + ATARI_LEFT_MARGIN;
+		ANTIC_ForgetLines(0, Screen_HEIGHT);
 		ANTIC_Frame(TRUE); /* draw on Screen_atari */
 	}
 	else {
@@ -665,6 +672,7 @@ int Screen_SaveScreenshot(const char *filename, int interlaced)
 	if (interlaced) {
 		free(Screen_atari);
 		Screen_atari = main_screen_atari;
+		ANTIC_ForgetLines(0, Screen_HEIGHT);
 	}
 	return TRUE;
 }
@@ -11,6 +11,7 @@ extern UBYTE *Screen_dirty;
 #endif /* CLIENTUPDATE */
 #endif /* DIRTYRECT */
 
+/* NULL when built with SCANLINE_RING */
 extern ULONG *Screen_atari;
 
 /* Dimensions of Screen_atari.
@@ -157,6 +157,20 @@ int Sound_Initialise(int *argc, char *argv[])
 			}
 			else a_m = TRUE;
 		}
+		else if (strcmp(argv[i], "-resample") == 0) {
+			if (i_a) {
+				i++;
+				if (strcmp(argv[i], "nearest") == 0)
+					POKEYSND_resample = POKEYSND_RESAMPLE_NEAREST;
+				else if (strcmp(argv[i], "box") == 0)
+					POKEYSND_resample = POKEYSND_RESAMPLE_BOX;
+				else if (strcmp(argv[i], "blep") == 0)
+					POKEYSND_resample = POKEYSND_RESAMPLE_BLEP;
+				else
+					a_i = TRUE;
+			}
+			else a_m = TRUE;
+		}
 		else if (strcmp(argv[i], "-audio16") == 0)
 			Sound_desired.sample_size = 2;
 		else if (strcmp(argv[i], "-audio8") == 0)
@@ -184,6 +198,8 @@ int Sound_Initialise(int *argc, char *argv[])
 				Log_print("\t-nosound             Disable sound");
 				Log_print("\t-dsprate <rate>      Set sound output frequency in Hz");
 				Log_print("\t-volume <0 .. 100>   Set sound output volume");
+				Log_print("\t-resample nearest|box|blep");
+				Log_print("\t                     Set how POKEY sound is brought to the output rate");
 				Log_print("\t-audio16             Set sound output format to 16-bit");
 				Log_print("\t-audio8              Set sound output format to 8-bit");
 				Log_print("\t-snd-buflen <ms>     Set length of the hardware sound buffer in milliseconds");
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <hardware/clocks.h>
@@ -8,6 +9,13 @@
 #include <pico/stdlib.h>
 
 #include "graphics.h"
+#ifdef AUDIO
+#ifdef AUDIO_PWM_PIN
+#include "pwm_audio.h"
+#else
+#include "audio.h"
+#endif
+#endif
 
 extern "C" {
 #include "ps2.h"
@@ -18,6 +26,11 @@ extern "C" {
 #include "atari800/sound.h"
 #include "atari800/akey.h"
 #include "atari800/memory.h"
+#include "atari800/antic.h"
+#include "atari800/screen.h"
+#ifdef SCANLINE_RING
+#include "atari800/scanline_ring.h"
+#endif
 }
 
 #include "ff.h"
@@ -25,7 +38,16 @@ extern "C" {
 
 static FATFS fs;
 semaphore vga_start_semaphore;
+#if defined(VGA) && defined(SCANLINE_RING)
+// Columns of the Atari line shown: 320 (cropped), 336 (the visible area) or
+// 384 (all of it); the VGA pixel clock is scaled to fit them on the screen
+#ifndef VGA_SCANOUT_WIDTH
+#define VGA_SCANOUT_WIDTH (336)
+#endif
+#define DISP_WIDTH VGA_SCANOUT_WIDTH
+#else
 #define DISP_WIDTH (320)
+#endif
 #define DISP_HEIGHT (240)
 
 uint16_t SCREEN[TEXTMODE_ROWS][TEXTMODE_COLS];
@@ -41,6 +63,19 @@ bool __time_critical_func(handleScancode)(const uint32_t ps2scancode) {
 }
 }
 
+#ifdef AUDIO
+static bool audio_render();
+#endif
+
+#ifdef TFT
+// Between the lines of an LCD refresh: the scanlines core 0 handed over
+// meanwhile, so that it does not wait for the whole refresh
+static void __time_critical_func(render_pending)() {
+    while (ANTIC_RenderLine())
+        ;
+}
+#endif
+
 void __time_critical_func(render_core)() {
     multicore_lockout_victim_init();
     graphics_init();
@@ -54,33 +89,134 @@ void __time_critical_func(render_core)() {
     clrScr(1);
 
     sem_acquire_blocking(&vga_start_semaphore);
-    // 60 FPS loop
+#ifdef TFT
+    // 60 FPS refresh
 #define frame_tick (16666)
     uint64_t tick = time_us_64();
-#ifdef TFT
     uint64_t last_renderer_tick = tick;
+    graphics_set_refresh_yield(render_pending);
 #endif
-    uint64_t last_input_tick = tick;
     while (true) {
 #ifdef TFT
         if (tick >= last_renderer_tick + frame_tick) {
             refresh_lcd();
             last_renderer_tick = tick;
         }
-#endif
-        // Every 5th frame
-        if (tick >= last_input_tick + frame_tick * 5) {
-            nespad_read();
-            last_input_tick = tick;
-        }
         tick = time_us_64();
+#endif
 
+        // Scanlines handed over by ANTIC_Frame on core 0, then the sound of
+        // the frames it has finished
+        if (ANTIC_RenderLine())
+            continue;
+#ifdef AUDIO
+        if (audio_render())
+            continue;
+#endif
         tight_loop_contents();
     }
 
     __unreachable();
 }
 
+#ifndef TV
+// NTSC colours: hue in the high nibble on the YIQ colour wheel (hue 1 at
+// 303 degrees, 26.8 degrees apart), luminance in the low nibble.
+static uint32_t atari_rgb(const int c) {
+    const double y = (c & 0x0f) / 15.0;
+    double i = 0, q = 0;
+    if (c >> 4) {
+        const double angle = (303.0 + ((c >> 4) - 1) * 26.8) * M_PI / 180;
+        i = 0.2 * cos(angle);
+        q = 0.2 * sin(angle);
+    }
+    const double rgb[3] = {
+        y + 0.956 * i + 0.621 * q,
+        y - 0.272 * i - 0.647 * q,
+        y - 1.106 * i + 1.703 * q
+    };
+    uint32_t color888 = 0;
+    for (double v : rgb)
+        color888 = color888 << 8 | (uint8_t)(v <= 0 ? 0 : v >= 1 ? 255 : v * 255);
+    return color888;
+}
+
+static void set_atari_palette() {
+    for (int i = 0; i < 256; i++) {
+        const uint32_t rgb = atari_rgb(i);
+#ifdef TFT
+        // the TFT takes RGB565
+        graphics_set_palette(i, RGB888(rgb >> 16, rgb >> 8 & 0xff, rgb & 0xff));
+#else
+        graphics_set_palette(i, rgb);
+#endif
+    }
+}
+#endif
+
+#ifdef SCANLINE_RING
+// The display takes every line from the ring as it scans; there is no
+// frame buffer. The middle DISP_WIDTH of the 384 columns are shown.
+static void stream_display() {
+    set_atari_palette();
+    graphics_set_buffer(NULL, Screen_WIDTH, Screen_HEIGHT);
+#ifdef VGA
+    graphics_set_scanout(DISP_WIDTH);
+#endif
+    // centred
+    graphics_set_offset(-(Screen_WIDTH - DISP_WIDTH) / 2, 0);
+    graphics_set_line_source(SCANLINE_RING_GetLine, SCANLINE_RING_EndFrame);
+    SCANLINE_RING_Attach(TRUE);
+    graphics_set_mode(GRAPHICSMODE_DEFAULT);
+    // read the input in the vertical blank, right before ANTIC starts the
+    // frame, so that it is on screen from the top of that frame
+    libatari800_set_beam_racing(TRUE);
+}
+#endif
+
+#ifdef AUDIO
+// POKEY output goes to the DAC (I2S) or the PWM pins through a ring of DMA
+// blocks of half a frame each; every emulated frame queues its own samples.
+// Core 0 only logs the POKEY writes with their cycle; core 1 synthesizes
+// each frame from the log when it has no scanline to draw.
+#define AUDIO_BLOCKS 8
+#ifndef AUDIO_LATENCY
+#define AUDIO_LATENCY 3
+#endif
+static audio_ring_t *audio_ring;
+static int16_t audio_buffer[1024];
+
+static void audio_init() {
+    const uint16_t block = libatari800_get_sound_frequency() / 120;
+#ifdef AUDIO_PWM_PIN
+    audio_ring = pwm_audio_init(AUDIO_PWM_PIN, libatari800_get_sound_frequency(),
+                                libatari800_get_num_sound_channels(), block, AUDIO_BLOCKS, AUDIO_LATENCY);
+#else
+    static i2s_config_t i2s_config = i2s_get_default_config();
+    i2s_config.sample_freq = libatari800_get_sound_frequency();
+    i2s_config.channel_count = libatari800_get_num_sound_channels();
+    i2s_config.dma_trans_count = block;
+    audio_ring = i2s_ring_init(&i2s_config, AUDIO_BLOCKS, AUDIO_LATENCY);
+#endif
+    // averaging over the sample period costs no more than nearest here and
+    // takes most of the aliasing out of the high tones
+    libatari800_set_resampler(LIBATARI800_RESAMPLE_BOX);
+    libatari800_set_sound_log(LIBATARI800_SOUND_LOG);
+}
+
+// On core 1: false if core 0 has not finished a frame since
+static bool audio_render() {
+    const int size = libatari800_get_sound_sample_size();
+    const int room = sizeof(audio_buffer) / size / libatari800_get_num_sound_channels();
+    const int samples = libatari800_render_sound_frame(audio_buffer, room);
+    if (samples == 0)
+        return false;
+    if (audio_ring)
+        audio_ring_write(audio_ring, audio_buffer, samples, size);
+    return true;
+}
+#endif
+
 extern "C"
 int LIBATARI800_Input_Initialise(int *argc, char *argv[])
 {
@@ -161,26 +297,56 @@ int main() {
 
     libatari800_init(-1, test_args);
     libatari800_clear_input_array(&input);
-
-
-    emulator_state_t state;
-    cpu_state_t *cpu;
+    // core 1 draws the scanlines while core 0 runs the CPU
+    libatari800_set_render_split(TRUE);
+    // player/missile collisions by masks, without touching every pixel
+    libatari800_set_pm_collisions(LIBATARI800_PM_COLLS_MASKS);
+#ifdef AUDIO
+    audio_init();
+#endif
 
 
     int frame = 0;
-    char tmp[255];
 
 
-    // Uncomment if we reach this line
-    // graphics_set_buffer(libatari800_get_screen_ptr(), 384, 240);
-    // graphics_set_mode(GRAPHICSMODE_DEFAULT);
+#ifdef SCANLINE_RING
+    stream_display();
+#else
+    // drop up to 3 frames in a row when a frame runs over 1/60 s
+    libatari800_set_frame_skip(3, 0);
+    // lines that come out as they are in the frame buffer are not redrawn
+    libatari800_set_line_cache(TRUE);
+#ifdef TFT
+    // and only the lines ANTIC drew go over SPI
+    graphics_set_dirty_lines(ANTIC_dirty_lines);
+#endif
+#ifndef TV
+    // the frame buffer, its middle DISP_WIDTH columns centred; the TV
+    // driver has no 256-colour mode and keeps the text screen
+    set_atari_palette();
+    graphics_set_buffer(libatari800_get_screen_ptr(), Screen_WIDTH, Screen_HEIGHT);
+    graphics_set_offset(-(Screen_WIDTH - DISP_WIDTH) / 2, 0);
+    graphics_set_mode(GRAPHICSMODE_DEFAULT);
+#endif
+#endif
 
     while(true) {
-        libatari800_get_current_state(&state);
-        cpu = (cpu_state_t *)&state.state[state.tags.cpu];  /* order: A,SR,SP,X,Y */
-        sprintf(tmp, "frame %d: A=%02x X=%02x Y=%02x SP=%02x SR=%02x\n", frame++, cpu->A, cpu->X, cpu->Y, cpu->P, cpu->S);
+        frame++;
+        // the pad every 5th frame, here rather than between scanlines on core 1
+        if (frame % 5 == 0)
+            nespad_read();
+#ifdef TV
+        // only the TV build keeps the text screen
+        cpu_state_t cpu;
+        char tmp[255];
+        libatari800_get_cpu_state(&cpu);
+        sprintf(tmp, "frame %d: A=%02x X=%02x Y=%02x SP=%02x SR=%02x\n", frame, cpu.A, cpu.X, cpu.Y, cpu.S, cpu.P);
         draw_text(tmp, 0, 0, 15, 0);
+#endif
         libatari800_next_frame(&input);
+#ifdef AUDIO
+        libatari800_end_sound_frame();
+#endif
 
     }
 